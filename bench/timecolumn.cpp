@@ -0,0 +1,87 @@
+﻿/*
+ * timecolumn.cpp
+ *
+ *  Created on: 2026年10月19日
+ *      Author: havesnag
+ *
+ * TimeColumn的压缩率和解码速度
+ *
+ *     g++ -O2 -std=c++11 bench/timecolumn.cpp src/timecolumn.cpp src/date.cpp src/zone.cpp src/zonedb.cpp src/clock.cpp
+ */
+
+#include <chrono>
+#include <iostream>
+#include <iomanip>
+#include <random>
+#include <vector>
+using namespace std;
+
+#include "../src/timecolumn.h"
+using namespace ec;
+
+namespace
+{
+
+void run(const char * name, const vector<int64> & stamps)
+{
+	TimeColumn column;
+	chrono::steady_clock::time_point start = chrono::steady_clock::now();
+	for (size_t i = 0; i < stamps.size(); ++i)
+	{
+		column.append(stamps[i]);
+	}
+	const double encodeSeconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+	vector<int64> out(stamps.size());
+	const int rounds = 10;
+	start = chrono::steady_clock::now();
+	for (int i = 0; i < rounds; ++i)
+	{
+		column.decode(0, column.size(), &out[0]);
+	}
+	const double decodeSeconds = chrono::duration<double>(chrono::steady_clock::now() - start).count() / rounds;
+
+	if (out != stamps)
+	{
+		cout << name << ": decode mismatch" << endl;
+		return;
+	}
+
+	const double gigabytes = stamps.size() * sizeof(int64) / 1e9;
+	cout << setw(10) << left << name
+		<< " bits/point " << fixed << setprecision(3) << double(column.bits()) / stamps.size()
+		<< "  with index " << double(column.bytes()) * 8 / stamps.size()
+		<< "  encode " << setprecision(1) << stamps.size() / encodeSeconds / 1e6 << " M/s"
+		<< "  decode " << setprecision(2) << gigabytes / decodeSeconds << " GB/s" << endl;
+}
+
+} /* namespace */
+
+int main()
+{
+	const size_t count = 10000000;
+	const int64 start = Time().microStamp();
+	mt19937_64 random(42);
+
+	vector<int64> regular(count);
+	vector<int64> jittered(count);
+	vector<int64> sparse(count);
+	int64 stamp = start;
+	for (size_t i = 0; i < count; ++i)
+	{
+		// 每秒一个点
+		regular[i] = start + static_cast<int64>(i) * 1000000;
+
+		// 每秒一个点，有±1毫秒的抖动
+		jittered[i] = regular[i] + static_cast<int64>(random() % 2001) - 1000;
+
+		// 偶尔丢点
+		stamp += (0 == random() % 100) ? 2000000 : 1000000;
+		sparse[i] = stamp;
+	}
+
+	run("regular", regular);
+	run("jittered", jittered);
+	run("gaps", sparse);
+	return 0;
+}
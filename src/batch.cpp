@@ -0,0 +1,496 @@
+﻿/*
+ * batch.cpp
+ *
+ *  Created on: 2026年10月19日
+ *      Author: havesnag
+ */
+
+#include "batch.h"
+#include <algorithm>
+using namespace std;
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define BATCH_AVX2
+#include <immintrin.h>
+#endif
+
+namespace ec
+{
+
+namespace
+{
+
+const int64 microsPerDay = 86400LL * 1000000;
+
+/** @brief 按固定长度的周期计算差值，shift为周期边界相对于0的偏移 */
+void diffFixed(const int64 * a, const int64 * b, size_t count, int64 shift, int64 unit, int64 * out)
+{
+	for (size_t i = 0; i < count; ++i)
+	{
+		out[i] = Calendar::floorDiv(a[i] - shift, unit) - Calendar::floorDiv(b[i] - shift, unit);
+	}
+}
+
+#ifdef BATCH_AVX2
+
+bool hasAVX2()
+{
+	static const bool supported = __builtin_cpu_supports("avx2");
+	return supported;
+}
+
+/**
+ * @brief diffFixed的AVX2实现
+ * @details
+ *     减去与周期边界对齐的基准后，±2^51以内的整数可以借助1.5*2^52与double互转，
+ *     |x| < 2^53时floor(x / unit)的双精度除法结果是精确的，超出范围的一组按标量计算。
+ */
+__attribute__((target("avx2")))
+void diffFixedAVX2(const int64 * a, const int64 * b, size_t count, int64 shift, int64 unit, int64 * out)
+{
+	if (0 == count)
+	{
+		return;
+	}
+
+	// 基准与周期边界对齐，两边的商同时减去一个常数，差值不变
+	const int64 base = shift + Calendar::floorDiv(a[0] - shift, unit) * unit;
+	const __m256i vbase = _mm256_set1_epi64x(base);
+	const __m256i magic = _mm256_set1_epi64x(0x4338000000000000LL);
+	const __m256d magicDouble = _mm256_set1_pd(6755399441055744.0);
+	const __m256i half = _mm256_set1_epi64x(1LL << 51);
+	const __m256i high = _mm256_set1_epi64x(~((1LL << 52) - 1));
+	const __m256d vunit = _mm256_set1_pd(static_cast<double>(unit));
+
+	size_t i = 0;
+	for (; i + 4 <= count; i += 4)
+	{
+		const __m256i x = _mm256_sub_epi64(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(a + i)), vbase);
+		const __m256i y = _mm256_sub_epi64(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(b + i)), vbase);
+
+		// x + 2^51 在[0, 2^52)以内
+		const __m256i range = _mm256_or_si256(_mm256_add_epi64(x, half), _mm256_add_epi64(y, half));
+		if (!_mm256_testz_si256(range, high))
+		{
+			diffFixed(a + i, b + i, 4, shift, unit, out + i);
+			continue;
+		}
+
+		const __m256d dx = _mm256_sub_pd(_mm256_castsi256_pd(_mm256_add_epi64(x, magic)), magicDouble);
+		const __m256d dy = _mm256_sub_pd(_mm256_castsi256_pd(_mm256_add_epi64(y, magic)), magicDouble);
+		const __m256d qx = _mm256_floor_pd(_mm256_div_pd(dx, vunit));
+		const __m256d qy = _mm256_floor_pd(_mm256_div_pd(dy, vunit));
+		const __m256i result = _mm256_sub_epi64(
+			_mm256_castpd_si256(_mm256_add_pd(_mm256_sub_pd(qx, qy), magicDouble)), magic);
+		_mm256_storeu_si256(reinterpret_cast<__m256i *>(out + i), result);
+	}
+
+	diffFixed(a + i, b + i, count - i, shift, unit, out + i);
+}
+
+#endif // BATCH_AVX2
+
+/** @brief 最近一次计算的月份，相邻的时间戳大多在同一个月 */
+struct MonthCache
+{
+	int64 first;
+	int64 end;
+	int64 months;
+
+	MonthCache() : first(1), end(0), months(0)
+	{
+	}
+
+	/** @brief 天数对应的月份，以0年1月为0 */
+	inline int64 get(int64 days)
+	{
+		if (days < first || days >= end)
+		{
+			int year = 0;
+			int month = 0;
+			int day = 0;
+			Date::civilFromDays(days, year, month, day);
+			first = days - day + 1;
+			end = first + Date::yearMonthDays(year, month);
+			months = static_cast<int64>(year) * 12 + month - 1;
+		}
+		return months;
+	}
+};
+
+void diffCalendar(const int64 * a, const int64 * b, size_t count, int64 shift, bool years, int64 * out)
+{
+	MonthCache cacheA;
+	MonthCache cacheB;
+	for (size_t i = 0; i < count; ++i)
+	{
+		const int64 monthsA = cacheA.get(Calendar::floorDiv(a[i] - shift, microsPerDay));
+		const int64 monthsB = cacheB.get(Calendar::floorDiv(b[i] - shift, microsPerDay));
+		out[i] = years ? (Calendar::floorDiv(monthsA, 12) - Calendar::floorDiv(monthsB, 12)) : (monthsA - monthsB);
+	}
+}
+
+/** @brief 月份(以0年1月为0)的第一天，length返回该月的天数 */
+inline int64 monthFirstDay(int64 months, int & length)
+{
+	const int year = static_cast<int>(Calendar::floorDiv(months, 12));
+	const int month = static_cast<int>(months - static_cast<int64>(year) * 12) + 1;
+	length = Date::yearMonthDays(year, month);
+	return Date::daysFromCivil(year, month, 1);
+}
+
+void addMonths(const int64 * days, size_t count, int64 value, int64 * out)
+{
+	// 同一个月的日期对应同一个目标月，只在月份变化时计算
+	MonthCache source;
+	int64 lastMonths = 0;
+	int64 targetFirst = 0;
+	int targetLength = 0;
+	for (size_t i = 0; i < count; ++i)
+	{
+		const int64 day = days[i];
+		const int64 months = source.get(day);
+		if (0 == targetLength || months != lastMonths)
+		{
+			lastMonths = months;
+			targetFirst = monthFirstDay(months + value, targetLength);
+		}
+		out[i] = targetFirst + std::min<int64>(day - source.first, targetLength - 1);
+	}
+}
+
+/** @brief 年可以被25整除，乘以25的模逆元判断，[-536870800, 536870999]以内有效 */
+inline uint32_t divisibleBy25(int year)
+{
+	return (static_cast<uint32_t>(year) * 3264175145u + 42949672u) < 85899345u;
+}
+
+/**
+ * @brief 校验一个，没有分支
+ * @details
+ *     能被100整除等价于能被4和25整除，所以闰年为 year & (能被25整除 ? 15 : 3) == 0；
+ *     2月以外的天数为30 + ((month ^ (month >> 3)) & 1)。
+ */
+inline int validateOne(int year, int month, int day, int hour, int minute, int second, int minYear, int maxYear)
+{
+	const uint32_t leap = (0 == (year & (3 | (divisibleBy25(year) * 12)))) ? 1 : 0;
+	const uint32_t isFebruary = (2 == month) ? 1 : 0;
+	const uint32_t monthDays = isFebruary * (28 + leap) + (1 - isFebruary) * (30 + ((month ^ (month >> 3)) & 1));
+
+	int reason = (static_cast<uint32_t>(second) > 59) ? Batch::InvalidSecond : Batch::Valid;
+	reason = (static_cast<uint32_t>(minute) > 59) ? Batch::InvalidMinute : reason;
+	reason = (static_cast<uint32_t>(hour) > 23) ? Batch::InvalidHour : reason;
+	reason = (static_cast<uint32_t>(day - 1) >= monthDays) ? Batch::InvalidDay : reason;
+	reason = (static_cast<uint32_t>(month - 1) >= 12) ? Batch::InvalidMonth : reason;
+	reason = (year < minYear || year > maxYear) ? Batch::InvalidYear : reason;
+	return reason;
+}
+
+size_t validateScalar(const int * years, const int * months, const int * days,
+	const int * hours, const int * minutes, const int * seconds, size_t begin, size_t count,
+	uint64_t * bitmap, uint8_t * reasons, int minYear, int maxYear)
+{
+	size_t valid = 0;
+	for (size_t i = begin; i < count; ++i)
+	{
+		const int reason = validateOne(years[i], months[i], days[i],
+			(NULL != hours) ? hours[i] : 0, (NULL != minutes) ? minutes[i] : 0, (NULL != seconds) ? seconds[i] : 0,
+			minYear, maxYear);
+		const uint64_t bit = (Batch::Valid == reason) ? (static_cast<uint64_t>(1) << (i & 63)) : 0;
+		bitmap[i >> 6] = ((0 == (i & 63)) ? 0 : bitmap[i >> 6]) | bit;
+		valid += (Batch::Valid == reason) ? 1 : 0;
+		if (NULL != reasons)
+		{
+			reasons[i] = static_cast<uint8_t>(reason);
+		}
+	}
+	return valid;
+}
+
+#ifdef BATCH_AVX2
+
+/** @brief validateScalar的AVX2实现，每8个一组，返回处理到的位置 */
+__attribute__((target("avx2")))
+size_t validateAVX2(const int * years, const int * months, const int * days,
+	const int * hours, const int * minutes, const int * seconds, size_t count,
+	uint64_t * bitmap, uint8_t * reasons, int minYear, int maxYear, size_t & valid)
+{
+	const __m256i zero = _mm256_setzero_si256();
+	const __m256i one = _mm256_set1_epi32(1);
+	const __m256i sign = _mm256_set1_epi32(INT32_MIN);
+	const __m256i inverse = _mm256_set1_epi32(static_cast<int>(3264175145u));
+	const __m256i bias = _mm256_set1_epi32(42949672);
+	const __m256i limit = _mm256_set1_epi32(static_cast<int>(85899345u ^ 0x80000000u));
+	const __m256i lowest = _mm256_set1_epi32(minYear);
+	const __m256i highest = _mm256_set1_epi32(maxYear);
+
+	uint64_t word = 0;
+	size_t i = 0;
+	for (; i + 8 <= count; i += 8)
+	{
+		const __m256i year = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(years + i));
+		const __m256i month = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(months + i));
+		const __m256i day = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(days + i));
+		const __m256i hour = (NULL != hours) ? _mm256_loadu_si256(reinterpret_cast<const __m256i *>(hours + i)) : zero;
+		const __m256i minute = (NULL != minutes) ? _mm256_loadu_si256(reinterpret_cast<const __m256i *>(minutes + i)) : zero;
+		const __m256i second = (NULL != seconds) ? _mm256_loadu_si256(reinterpret_cast<const __m256i *>(seconds + i)) : zero;
+
+		// 无符号比较通过翻转符号位转为有符号比较
+		const __m256i product = _mm256_xor_si256(_mm256_add_epi32(_mm256_mullo_epi32(year, inverse), bias), sign);
+		const __m256i by25 = _mm256_cmpgt_epi32(limit, product);
+		const __m256i mask = _mm256_or_si256(_mm256_set1_epi32(3), _mm256_and_si256(by25, _mm256_set1_epi32(12)));
+		const __m256i leap = _mm256_and_si256(_mm256_cmpeq_epi32(_mm256_and_si256(year, mask), zero), one);
+		const __m256i odd = _mm256_and_si256(_mm256_xor_si256(month, _mm256_srli_epi32(month, 3)), one);
+		const __m256i monthDays = _mm256_blendv_epi8(_mm256_add_epi32(_mm256_set1_epi32(30), odd),
+			_mm256_add_epi32(_mm256_set1_epi32(28), leap), _mm256_cmpeq_epi32(month, _mm256_set1_epi32(2)));
+
+		// x不在[0, n)时，(x ^ sign) >= (n ^ sign)
+		const __m256i badSecond = _mm256_cmpgt_epi32(_mm256_xor_si256(second, sign), _mm256_set1_epi32(59 ^ INT32_MIN));
+		const __m256i badMinute = _mm256_cmpgt_epi32(_mm256_xor_si256(minute, sign), _mm256_set1_epi32(59 ^ INT32_MIN));
+		const __m256i badHour = _mm256_cmpgt_epi32(_mm256_xor_si256(hour, sign), _mm256_set1_epi32(23 ^ INT32_MIN));
+		const __m256i badDay = _mm256_cmpgt_epi32(_mm256_xor_si256(day, sign),
+			_mm256_xor_si256(monthDays, sign));
+		const __m256i badDayZero = _mm256_cmpgt_epi32(one, day);
+		const __m256i badMonth = _mm256_cmpgt_epi32(_mm256_xor_si256(_mm256_sub_epi32(month, one), sign),
+			_mm256_set1_epi32(11 ^ INT32_MIN));
+		const __m256i badYear = _mm256_or_si256(_mm256_cmpgt_epi32(year, highest), _mm256_cmpgt_epi32(lowest, year));
+
+		__m256i reason = _mm256_and_si256(badSecond, _mm256_set1_epi32(Batch::InvalidSecond));
+		reason = _mm256_blendv_epi8(reason, _mm256_set1_epi32(Batch::InvalidMinute), badMinute);
+		reason = _mm256_blendv_epi8(reason, _mm256_set1_epi32(Batch::InvalidHour), badHour);
+		reason = _mm256_blendv_epi8(reason, _mm256_set1_epi32(Batch::InvalidDay), _mm256_or_si256(badDay, badDayZero));
+		reason = _mm256_blendv_epi8(reason, _mm256_set1_epi32(Batch::InvalidMonth), badMonth);
+		reason = _mm256_blendv_epi8(reason, _mm256_set1_epi32(Batch::InvalidYear), badYear);
+
+		const unsigned bits = static_cast<unsigned>(_mm256_movemask_ps(_mm256_castsi256_ps(
+			_mm256_cmpeq_epi32(reason, zero))));
+		valid += static_cast<size_t>(__builtin_popcount(bits));
+		word |= static_cast<uint64_t>(bits) << (i & 63);
+		if (56 == (i & 63))
+		{
+			bitmap[i >> 6] = word;
+			word = 0;
+		}
+
+		if (NULL != reasons)
+		{
+			const __m128i packed = _mm_packs_epi32(_mm256_castsi256_si128(reason), _mm256_extracti128_si256(reason, 1));
+			_mm_storel_epi64(reinterpret_cast<__m128i *>(reasons + i), _mm_packus_epi16(packed, packed));
+		}
+	}
+
+	if (0 != (i & 63))
+	{
+		bitmap[i >> 6] = word;
+	}
+	return i;
+}
+
+#endif // BATCH_AVX2
+
+} /* namespace */
+
+void Batch::diff(const int64 * a, const int64 * b, size_t count, Duration::Period period,
+	int64 * out, time_t offset)
+{
+	const int64 shift = static_cast<int64>(offset) * 1000000;
+	int64 unit = 0;
+	switch (period)
+	{
+	case Duration::MicroSecond:
+		for (size_t i = 0; i < count; ++i)
+		{
+			out[i] = a[i] - b[i];
+		}
+		return;
+	case Duration::Month:
+	case Duration::Year:
+		diffCalendar(a, b, count, shift, Duration::Year == period, out);
+		return;
+	case Duration::MilliSecond:
+		unit = 1000;
+		break;
+	case Duration::Second:
+		unit = 1000000;
+		break;
+	case Duration::Minute:
+		unit = 60LL * 1000000;
+		break;
+	case Duration::Hour:
+		unit = 3600LL * 1000000;
+		break;
+	case Duration::Day:
+		unit = microsPerDay;
+		break;
+	case Duration::Week:
+		unit = 7 * microsPerDay;
+		break;
+	default:
+		for (size_t i = 0; i < count; ++i)
+		{
+			out[i] = 0;
+		}
+		return;
+	}
+
+	// 时、分、秒按UTC的边界，天和周按本地日历，1970-01-01为星期四，周的边界提前3天
+	const int64 boundary = (Duration::Day == period) ? shift
+		: ((Duration::Week == period) ? shift - 3 * microsPerDay : 0);
+
+#ifdef BATCH_AVX2
+	if (hasAVX2())
+	{
+		diffFixedAVX2(a, b, count, boundary, unit, out);
+		return;
+	}
+#endif // BATCH_AVX2
+
+	diffFixed(a, b, count, boundary, unit, out);
+}
+
+void Batch::diff(const Time * a, const Time * b, size_t count, Duration::Period period,
+	int64 * out, time_t offset)
+{
+	int64 stampsA[256];
+	int64 stampsB[256];
+	for (size_t begin = 0; begin < count; begin += 256)
+	{
+		const size_t n = (count - begin < 256) ? (count - begin) : 256;
+		for (size_t i = 0; i < n; ++i)
+		{
+			stampsA[i] = a[begin + i].microStamp();
+			stampsB[i] = b[begin + i].microStamp();
+		}
+		diff(stampsA, stampsB, n, period, out + begin, offset);
+	}
+}
+
+void Batch::days(const int64 * stamps, size_t count, int64 * out, time_t offset)
+{
+	const int64 shift = static_cast<int64>(offset) * 1000000;
+	for (size_t i = 0; i < count; ++i)
+	{
+		out[i] = Calendar::floorDiv(stamps[i] - shift, microsPerDay);
+	}
+}
+
+void Batch::add(const int64 * days, size_t count, int64 value, Duration::Period period, int64 * out)
+{
+	switch (period)
+	{
+	case Duration::Day:
+		addDays(days, count, value, out);
+		break;
+	case Duration::Week:
+		addDays(days, count, value * 7, out);
+		break;
+	case Duration::Month:
+		addMonths(days, count, value, out);
+		break;
+	case Duration::Year:
+		addMonths(days, count, value * 12, out);
+		break;
+	default:
+		if (out != days)
+		{
+			std::copy(days, days + count, out);
+		}
+		break;
+	}
+}
+
+void Batch::addDays(const int64 * days, size_t count, int64 value, int64 * out)
+{
+	for (size_t i = 0; i < count; ++i)
+	{
+		out[i] = days[i] + value;
+	}
+}
+
+void Batch::addMonth(const int64 * days, size_t count, int value, int64 * out)
+{
+	addMonths(days, count, value, out);
+}
+
+void Batch::addMonth(const int64 * days, const int * values, size_t count, int64 * out)
+{
+	MonthCache source;
+	for (size_t i = 0; i < count; ++i)
+	{
+		const int64 day = days[i];
+		const int64 months = source.get(day);
+		int length = 0;
+		const int64 first = monthFirstDay(months + values[i], length);
+		out[i] = first + std::min<int64>(day - source.first, length - 1);
+	}
+}
+
+void Batch::addYear(const int64 * days, size_t count, int value, int64 * out)
+{
+	addMonths(days, count, static_cast<int64>(value) * 12, out);
+}
+
+void Batch::isoWeek(const int64 * days, size_t count, int * years, int * weeks, int * weekDays)
+{
+	int year = 0;
+	int64 first = 0, next = 0;
+	for (size_t i = 0; i < count; ++i)
+	{
+		const int64 index = Calendar::weekDay(days[i]) - 1;
+		const int64 thursday = days[i] - index + 3;
+		if (thursday < first || thursday >= next)
+		{
+			int month = 0, day = 0;
+			Date::civilFromDays(thursday, year, month, day);
+			first = Date::daysFromCivil(year, 1, 1);
+			next = Date::daysFromCivil(year + 1, 1, 1);
+		}
+
+		if (NULL != years)
+		{
+			years[i] = year;
+		}
+		if (NULL != weeks)
+		{
+			weeks[i] = static_cast<int>((thursday - first) / 7 + 1);
+		}
+		if (NULL != weekDays)
+		{
+			weekDays[i] = static_cast<int>(index + 1);
+		}
+	}
+}
+
+void Batch::weekStart(const int64 * days, size_t count, int firstWeekDay, int64 * out)
+{
+	// 相对于firstWeekDay的星期即为需要退回的天数
+	const int64 shift = firstWeekDay - 1;
+	for (size_t i = 0; i < count; ++i)
+	{
+		out[i] = days[i] - (Calendar::weekDay(days[i] - shift) - 1);
+	}
+}
+
+size_t Batch::validate(const int * years, const int * months, const int * days,
+	const int * hours, const int * minutes, const int * seconds, size_t count,
+	uint64_t * bitmap, uint8_t * reasons, int minYear, int maxYear)
+{
+	// 超出范围时闰年的判断不再准确
+	minYear = std::max(minYear, -536870800);
+	maxYear = std::min(maxYear, 536870999);
+
+	size_t valid = 0;
+	size_t begin = 0;
+#ifdef BATCH_AVX2
+	if (hasAVX2())
+	{
+		begin = validateAVX2(years, months, days, hours, minutes, seconds, count,
+			bitmap, reasons, minYear, maxYear, valid);
+	}
+#endif // BATCH_AVX2
+
+	return valid + validateScalar(years, months, days, hours, minutes, seconds, begin, count,
+		bitmap, reasons, minYear, maxYear);
+}
+
+} /* namespace ec */
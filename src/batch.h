@@ -0,0 +1,143 @@
+﻿/*
+ * batch.h
+ *
+ *  Created on: 2026年10月19日
+ *      Author: havesnag
+ */
+
+#ifndef INCLUDE_EC_BATCH_H_
+#define INCLUDE_EC_BATCH_H_
+
+#include "date.h"
+#include <stddef.h>
+
+namespace ec
+{
+
+/**
+ * @brief 批量的日期时间计算
+ * @details
+ *     对数组逐个计算，结果与Time/Date的相应方法一致，但不经过struct tm和mktime。
+ *     时区以固定偏移表示，与Date::localTimeZoneOffset()含义相同，即本地时间 = UTC时间 - offset，
+ *     不处理夏令时，需要夏令时的场合请按Zone::offset逐个计算。
+ *     x86-64下使用GCC或Clang编译时，运行时检测到AVX2则使用向量化的实现。
+ */
+class Batch
+{
+public:
+	/** @brief 校验失败的原因，有多个字段无效时取最靠前的字段 */
+	enum Reason
+	{
+		/** @brief 有效 */
+		Valid = 0,
+		/** @brief 年超出范围 */
+		InvalidYear = 1,
+		/** @brief 月不在[1,12] */
+		InvalidMonth = 2,
+		/** @brief 日不在[1,当月天数] */
+		InvalidDay = 3,
+		/** @brief 时不在[0,23] */
+		InvalidHour = 4,
+		/** @brief 分不在[0,59] */
+		InvalidMinute = 5,
+		/** @brief 秒不在[0,59] */
+		InvalidSecond = 6,
+	};
+
+public:
+	/**
+	 * @brief 批量计算差值，out[i]为a[i] - b[i]
+	 * @details
+	 *     周期的划分与Time::diff相同，不是绝对差值：
+	 *     MilliSecond、Second、Minute和Hour按UTC的时间边界计算，
+	 *     Day、Week、Month和Year按偏移后的本地日历计算，周从星期一开始。
+	 *     两边都按所在周期向下取整，1970年之前也落在正确的周期里；
+	 *     Time::diff的Minute、Hour、Day和Week按截断计算，只有两个时刻都不早于1970年(本地日历)时结果相同，
+	 *     比如a为30秒、b为-30秒时Minute的差值为1，Time::diff为0。
+	 *     微秒时间戳在±2^51(约71年)以内时，固定长度的周期每4个一组向量化计算。
+	 * @param a 微秒时间戳数组
+	 * @param b 微秒时间戳数组
+	 * @param count 个数
+	 * @param period 差值的周期
+	 * @param out 输出数组，长度不小于count，可以与a或b相同
+	 * @param offset 时区偏移(秒)
+	 * @see Time::diff
+	 */
+	static void diff(const int64 * a, const int64 * b, size_t count, Duration::Period period,
+		int64 * out, time_t offset = Date::localTimeZoneOffset());
+	/** @brief 批量计算差值 @see diff(const int64 *, const int64 *, size_t, Duration::Period, int64 *, time_t) */
+	static void diff(const Time * a, const Time * b, size_t count, Duration::Period period,
+		int64 * out, time_t offset = Date::localTimeZoneOffset());
+
+	/**
+	 * @brief 微秒时间戳对应的本地日期，以距离1970-01-01的天数表示
+	 * @param out 输出数组，长度不小于count，可以与stamps相同
+	 * @see Date::daysFromCivil
+	 */
+	static void days(const int64 * stamps, size_t count, int64 * out, time_t offset = Date::localTimeZoneOffset());
+
+	/**
+	 * @brief 批量加/减 一段时间
+	 * @details 与Date::add相同，月和年超出目标月的天数时取目标月的最后一天，比如1月31日加1月为2月28日或29日
+	 * @param days 距离1970-01-01的天数
+	 * @param period 仅支持Day、Week、Month和Year，其他周期原样输出
+	 * @param out 输出数组，长度不小于count，可以与days相同
+	 * @see Date::add
+	 */
+	static void add(const int64 * days, size_t count, int64 value, Duration::Period period, int64 * out);
+	/** @brief 批量加/减 天 */
+	static void addDays(const int64 * days, size_t count, int64 value, int64 * out);
+	/** @brief 批量加/减 月 @see Date::addMonth */
+	static void addMonth(const int64 * days, size_t count, int value, int64 * out);
+	/** @brief 每个日期加/减 不同的月数，values长度不小于count @see Date::addMonth */
+	static void addMonth(const int64 * days, const int * values, size_t count, int64 * out);
+	/** @brief 批量加/减 年，2月29日加1年为2月28日 @see Date::addYear */
+	static void addYear(const int64 * days, size_t count, int value, int64 * out);
+
+	/**
+	 * @brief 批量计算ISO 8601周日期
+	 * @details 相邻的日期通常在同一年，只在跨年时重新计算年的边界
+	 * @param days 距离1970-01-01的天数
+	 * @param years 输出ISO周年，为NULL时不输出，下同
+	 * @param weeks 输出周，[1,53]
+	 * @param weekDays 输出星期，[1,7]，1为星期一
+	 * @see Date::isoWeekFromDays
+	 */
+	static void isoWeek(const int64 * days, size_t count, int * years, int * weeks, int * weekDays);
+	/**
+	 * @brief 批量计算所在周的第一天
+	 * @param firstWeekDay 一周的第一天，[1,7]，1为星期一，7为星期日
+	 * @param out 输出数组，长度不小于count，可以与days相同
+	 * @see Date::weekStartDays
+	 */
+	static void weekStart(const int64 * days, size_t count, int firstWeekDay, int64 * out);
+
+	/**
+	 * @brief 批量校验按字段分开存储的日期时间
+	 * @details
+	 *     不会像Date那样经mktime把2月30日进位为3月2日，而是报告为无效。
+	 *     闰年与月份天数的判断没有分支，AVX2下每8个一组计算。
+	 * @param years 年
+	 * @param months 月，[1,12]
+	 * @param days 日
+	 * @param hours 时，为NULL时不校验，下同
+	 * @param minutes 分
+	 * @param seconds 秒
+	 * @param count 个数
+	 * @param bitmap 输出有效位图，第i位为1表示第i个有效，长度不小于(count + 63) / 64
+	 * @param reasons 输出每个的Reason，可以为NULL
+	 * @param minYear 年的最小值
+	 * @param maxYear 年的最大值
+	 * @return 有效的个数
+	 */
+	static size_t validate(const int * years, const int * months, const int * days,
+		const int * hours, const int * minutes, const int * seconds, size_t count,
+		uint64_t * bitmap, uint8_t * reasons = NULL, int minYear = 1, int maxYear = 9999);
+
+private:
+	Batch();
+};
+
+} /* namespace ec */
+
+#endif /* INCLUDE_EC_BATCH_H_ */
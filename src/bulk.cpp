@@ -0,0 +1,589 @@
+﻿/*
+ * bulk.cpp
+ *
+ *  Created on: 2026年10月19日
+ *      Author: havesnag
+ */
+
+#include "bulk.h"
+#include "threadpool.h"
+#include "zone.h"
+#include <string.h>
+#include <algorithm>
+using namespace std;
+
+#ifndef PLATFORM_WINDOWS
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif // PLATFORM_WINDOWS
+
+namespace ec
+{
+
+const int64 Bulk::Invalid;
+
+namespace
+{
+
+/** @brief 编译后的格式 */
+struct Pattern
+{
+	/** @brief 说明符，为0时表示一段原样的字符 */
+	struct Field
+	{
+		char spec;
+		const char * text;
+		size_t length;
+	};
+
+	const char * fmt;
+	std::vector<Field> fields;
+	/** @brief 是否只包含可以直接生成的说明符 */
+	bool fast;
+	/** @brief 是否包含ISO周日期的说明符，格式化时需要计算周日期 */
+	bool iso;
+	/** @brief 包含%G和%V且没有完整的%Y %m %d，解析时按周日期确定日期 */
+	bool week;
+	/** @brief 包含%u */
+	bool hasWeekDay;
+	/** @brief 一行的最大长度，含'\n' */
+	size_t maxLength;
+
+	explicit Pattern(const char * fmt) : fmt(fmt), fast(true), iso(false), week(false), hasWeekDay(false), maxLength(1)
+	{
+		const char * literal = fmt;
+		const char * p = fmt;
+		while ('\0' != *p)
+		{
+			if ('%' != *p || '\0' == p[1])
+			{
+				++p;
+				continue;
+			}
+
+			_literal(literal, p);
+			const char spec = p[1];
+			if ('%' == spec)
+			{
+				_literal(p + 1, p + 2);
+			}
+			else if (NULL != strchr("YmdHMSXGVu", spec))
+			{
+				Field field = {spec, p, 2};
+				fields.push_back(field);
+				iso = iso || (NULL != strchr("GVu", spec));
+				hasWeekDay = hasWeekDay || ('u' == spec);
+				maxLength += ('Y' == spec || 'G' == spec) ? 11 : (('X' == spec) ? 8 : (('u' == spec) ? 1 : 2));
+			}
+			else
+			{
+				fast = false;
+			}
+			p += 2;
+			literal = p;
+		}
+		_literal(literal, p);
+
+		// 有完整的年月日时以年月日为准
+		const char * const dateSpecs = "GVYmd";
+		int specs = 0;
+		for (size_t i = 0; i < fields.size(); ++i)
+		{
+			const char * found = (0 != fields[i].spec) ? strchr(dateSpecs, fields[i].spec) : NULL;
+			specs |= (NULL != found) ? (1 << (found - dateSpecs)) : 0;
+		}
+		week = (3 == (specs & 3)) && (28 != (specs & 28));
+
+		if (!fast)
+		{
+			maxLength = 257;
+		}
+	}
+
+private:
+	void _literal(const char * begin, const char * end)
+	{
+		if (end > begin)
+		{
+			Field field = {0, begin, static_cast<size_t>(end - begin)};
+			fields.push_back(field);
+			maxLength += field.length;
+		}
+	}
+};
+
+inline char * putTwo(char * p, int value)
+{
+	p[0] = static_cast<char>('0' + value / 10);
+	p[1] = static_cast<char>('0' + value % 10);
+	return p + 2;
+}
+
+/** @brief 与strftime的%Y相同，不补0 */
+inline char * putYear(char * p, int year)
+{
+	unsigned value = static_cast<unsigned>(year);
+	if (year < 0)
+	{
+		*p++ = '-';
+		value = 0u - value;
+	}
+
+	char digits[10];
+	int count = 0;
+	do
+	{
+		digits[count++] = static_cast<char>('0' + value % 10);
+		value /= 10;
+	} while (value > 0);
+
+	while (count > 0)
+	{
+		*p++ = digits[--count];
+	}
+	return p;
+}
+
+/** @brief 格式化一段，按天缓存年月日 */
+class Formatter
+{
+public:
+	Formatter(const Pattern & pattern, const Zone * zone)
+		: _pattern(pattern), _zone(zone), _days(INT64_MIN), _year(0), _month(0), _day(0), _isoYear(0), _isoWeek(0), _weekDay(0)
+	{
+	}
+
+	void run(const int64 * stamps, size_t count, std::string & out)
+	{
+		out.resize(count * _pattern.maxLength);
+		char * begin = &out[0];
+		char * p = begin;
+		for (size_t i = 0; i < count; ++i)
+		{
+			p = _format(p, Calendar::floorDiv(stamps[i], 1000000));
+		}
+		out.resize(static_cast<size_t>(p - begin));
+	}
+
+private:
+	char * _format(char * p, int64 stamp)
+	{
+		if (!_pattern.fast && NULL == _zone)
+		{
+			// 系统时区的其他说明符与Date::format完全一致
+			const std::string text = Date(static_cast<time_t>(stamp)).format(_pattern.fmt);
+			const size_t length = std::min<size_t>(text.size(), _pattern.maxLength - 1);
+			memcpy(p, text.data(), length);
+			p += length;
+			*p++ = '\n';
+			return p;
+		}
+
+		Zone::Info info;
+		if (NULL != _zone)
+		{
+			info = _zone->lookup(static_cast<time_t>(stamp));
+		}
+		else
+		{
+			info.offset = Date::localOffset(static_cast<time_t>(stamp));
+			info.isDst = false;
+			info.abbr = "";
+		}
+
+		const int64 local = stamp + info.offset;
+		const int64 days = Calendar::floorDiv(local, 86400);
+		const int seconds = static_cast<int>(local - days * 86400);
+		if (days != _days)
+		{
+			_days = days;
+			Date::civilFromDays(days, _year, _month, _day);
+			if (_pattern.iso)
+			{
+				Date::isoWeekFromDays(days, _isoYear, _isoWeek, _weekDay);
+			}
+		}
+
+		if (!_pattern.fast)
+		{
+			return _strftime(p, days, seconds, info);
+		}
+
+		const int hour = seconds / 3600;
+		const int minute = seconds / 60 % 60;
+		const int second = seconds % 60;
+		for (size_t i = 0; i < _pattern.fields.size(); ++i)
+		{
+			const Pattern::Field & field = _pattern.fields[i];
+			switch (field.spec)
+			{
+			case 0:
+				memcpy(p, field.text, field.length);
+				p += field.length;
+				break;
+			case 'Y':
+				p = putYear(p, _year);
+				break;
+			case 'm':
+				p = putTwo(p, _month);
+				break;
+			case 'd':
+				p = putTwo(p, _day);
+				break;
+			case 'H':
+				p = putTwo(p, hour);
+				break;
+			case 'M':
+				p = putTwo(p, minute);
+				break;
+			case 'S':
+				p = putTwo(p, second);
+				break;
+			case 'X':
+				p = putTwo(p, hour);
+				*p++ = ':';
+				p = putTwo(p, minute);
+				*p++ = ':';
+				p = putTwo(p, second);
+				break;
+			case 'G':
+				p = putYear(p, _isoYear);
+				break;
+			case 'V':
+				p = putTwo(p, _isoWeek);
+				break;
+			case 'u':
+				*p++ = static_cast<char>('0' + _weekDay);
+				break;
+			default:
+				break;
+			}
+		}
+		*p++ = '\n';
+		return p;
+	}
+
+	char * _strftime(char * p, int64 days, int seconds, const Zone::Info & info)
+	{
+		struct tm tm;
+		memset(&tm, 0, sizeof(struct tm));
+		tm.tm_year = _year - 1900;
+		tm.tm_mon = _month - 1;
+		tm.tm_mday = _day;
+		tm.tm_hour = seconds / 3600;
+		tm.tm_min = seconds / 60 % 60;
+		tm.tm_sec = seconds % 60;
+		tm.tm_wday = Calendar::weekDay(days) % 7;
+		tm.tm_yday = static_cast<int>(days - Date::daysFromCivil(_year, 1, 1));
+		tm.tm_isdst = info.isDst ? 1 : 0;
+#ifndef PLATFORM_WINDOWS
+# if defined(__USE_BSD) || defined(__USE_MISC)
+		tm.tm_gmtoff = info.offset;
+		tm.tm_zone = info.abbr;
+# else
+		tm.__tm_gmtoff = info.offset;
+		tm.__tm_zone = info.abbr;
+# endif//__USE_BSD __USE_MISC
+#endif // PLATFORM_WINDOWS
+
+		p += strftime(p, 256, _pattern.fmt, &tm);
+		*p++ = '\n';
+		return p;
+	}
+
+	const Pattern & _pattern;
+	const Zone * _zone;
+	int64 _days;
+	int _year;
+	int _month;
+	int _day;
+	int _isoYear;
+	int _isoWeek;
+	int _weekDay;
+};
+
+/** @brief 读取最多width位数字 */
+inline bool getNumber(const char *& p, const char * end, int width, int & value)
+{
+	const char * begin = p;
+	value = 0;
+	while (p < end && p - begin < width && *p >= '0' && *p <= '9')
+	{
+		value = value * 10 + (*p++ - '0');
+	}
+	return p > begin;
+}
+
+/** @brief 解析一行，返回本地时间的秒数 */
+bool parseLine(const Pattern & pattern, const char * p, const char * end, int64 & local)
+{
+	int year = 1970;
+	int month = 1;
+	int day = 1;
+	int hour = 0;
+	int minute = 0;
+	int second = 0;
+	int isoYear = 1970;
+	int isoWeek = 1;
+	int weekDay = 1;
+	for (size_t i = 0; i < pattern.fields.size(); ++i)
+	{
+		const Pattern::Field & field = pattern.fields[i];
+		bool ok = true;
+		switch (field.spec)
+		{
+		case 0:
+			ok = (static_cast<size_t>(end - p) >= field.length) && (0 == memcmp(p, field.text, field.length));
+			p += field.length;
+			break;
+		case 'Y':
+		case 'G':
+		{
+			int & value = ('Y' == field.spec) ? year : isoYear;
+			const bool negative = (p < end && '-' == *p);
+			p += negative ? 1 : 0;
+			ok = getNumber(p, end, 4, value);
+			value = negative ? -value : value;
+			break;
+		}
+		case 'V':
+			ok = getNumber(p, end, 2, isoWeek);
+			break;
+		case 'u':
+			ok = getNumber(p, end, 1, weekDay);
+			break;
+		case 'm':
+			ok = getNumber(p, end, 2, month);
+			break;
+		case 'd':
+			ok = getNumber(p, end, 2, day);
+			break;
+		case 'H':
+			ok = getNumber(p, end, 2, hour);
+			break;
+		case 'M':
+			ok = getNumber(p, end, 2, minute);
+			break;
+		case 'S':
+			ok = getNumber(p, end, 2, second);
+			break;
+		case 'X':
+			ok = getNumber(p, end, 2, hour) && p < end && ':' == *p++
+				&& getNumber(p, end, 2, minute) && p < end && ':' == *p++
+				&& getNumber(p, end, 2, second);
+			break;
+		default:
+			ok = false;
+			break;
+		}
+
+		if (!ok)
+		{
+			return false;
+		}
+	}
+
+	if (month < 1 || month > 12 || day < 1 || day > Date::yearMonthDays(year, month)
+		|| hour > 23 || minute > 59 || second > 60)
+	{
+		return false;
+	}
+
+	int64 days = 0;
+	if (pattern.week)
+	{
+		// 有ISO周年和周时以周日期为准，12月28日总在最后一周
+		int lastYear = 0, lastWeek = 0, lastWeekDay = 0;
+		Date::isoWeekFromDays(Date::daysFromCivil(isoYear, 12, 28), lastYear, lastWeek, lastWeekDay);
+		if (isoWeek < 1 || isoWeek > lastWeek || weekDay < 1 || weekDay > 7)
+		{
+			return false;
+		}
+		days = Date::daysFromIsoWeek(isoYear, isoWeek, weekDay);
+	}
+	else
+	{
+		// 只有%u时按年月日确定日期，%u须与之一致
+		days = Calendar::daysFromCivil(year, month, day);
+		if (pattern.hasWeekDay && weekDay != Calendar::weekDay(days))
+		{
+			return false;
+		}
+	}
+
+	local = days * 86400 + hour * 3600 + minute * 60 + second;
+	return true;
+}
+
+/** @brief 解析一段完整的行 */
+size_t parseLines(const Pattern & pattern, const Zone * zone, const char * p, const char * end,
+	std::vector<int64> & out)
+{
+	size_t valid = 0;
+	while (p < end)
+	{
+		const char * next = static_cast<const char *>(memchr(p, '\n', static_cast<size_t>(end - p)));
+		const char * lineEnd = (NULL != next) ? next : end;
+		if (lineEnd > p && '\r' == lineEnd[-1])
+		{
+			--lineEnd;
+		}
+
+		int64 local = 0;
+		if (pattern.fast && parseLine(pattern, p, lineEnd, local))
+		{
+			const int64 stamp = (NULL != zone) ? static_cast<int64>(zone->localToUTC(static_cast<time_t>(local)))
+				: static_cast<int64>(Date::localToUTC(static_cast<time_t>(local)));
+			out.push_back(stamp * 1000000);
+			++valid;
+		}
+		else
+		{
+			out.push_back(Bulk::Invalid);
+		}
+
+		p = (NULL != next) ? (next + 1) : end;
+	}
+	return valid;
+}
+
+/** @brief 按顺序并行拼接各段的结果 */
+template <typename Container, typename Output>
+void concat(ThreadPool & pool, const std::vector<Container> & parts, Output & out)
+{
+	std::vector<size_t> offsets(parts.size() + 1, 0);
+	for (size_t i = 0; i < parts.size(); ++i)
+	{
+		offsets[i + 1] = offsets[i] + parts[i].size();
+	}
+
+	out.resize(offsets.back());
+	pool.run(parts.size(), [&](size_t i) {
+		std::copy(parts[i].begin(), parts[i].end(), out.begin() + offsets[i]);
+	});
+}
+
+/** @brief 每个线程分到多块，块的耗时不均时由空闲线程窃取 */
+inline size_t chunkCount(const ThreadPool & pool, size_t total, size_t minimum)
+{
+	const size_t threads = std::max<size_t>(pool.size(), 1);
+	return std::max<size_t>(std::min(threads * 8, total / minimum), 1);
+}
+
+} /* namespace */
+
+void Bulk::format(const int64 * stamps, size_t count, std::string & out,
+	const char * fmt, const Zone * zone, ThreadPool * pool)
+{
+	ThreadPool & workers = (NULL != pool) ? *pool : ThreadPool::shared();
+	const Pattern pattern(fmt);
+	const size_t chunks = chunkCount(workers, count, 4096);
+	const size_t rows = (count + chunks - 1) / chunks;
+
+	std::vector<std::string> parts(chunks);
+	workers.run(chunks, [&](size_t i) {
+		const size_t begin = std::min(i * rows, count);
+		Formatter(pattern, zone).run(stamps + begin, std::min(rows, count - begin), parts[i]);
+	});
+
+	if (1 == parts.size())
+	{
+		out.swap(parts[0]);
+		return;
+	}
+	concat(workers, parts, out);
+}
+
+size_t Bulk::parse(const char * data, size_t size, std::vector<int64> & out,
+	const char * fmt, const Zone * zone, ThreadPool * pool)
+{
+	ThreadPool & workers = (NULL != pool) ? *pool : ThreadPool::shared();
+	const Pattern pattern(fmt);
+	const size_t chunks = chunkCount(workers, size, 1 << 16);
+	const size_t length = (size + chunks - 1) / chunks;
+
+	// 块的边界移到下一行的开头
+	std::vector<size_t> bounds(1, 0);
+	while (bounds.back() < size)
+	{
+		const size_t begin = bounds.back() + length;
+		const char * next = (begin < size) ? static_cast<const char *>(memchr(data + begin, '\n', size - begin)) : NULL;
+		bounds.push_back((NULL != next) ? static_cast<size_t>(next - data + 1) : size);
+	}
+
+	const size_t count = bounds.size() - 1;
+	std::vector<std::vector<int64> > parts(count);
+	std::vector<size_t> valid(count, 0);
+	workers.run(count, [&](size_t i) {
+		valid[i] = parseLines(pattern, zone, data + bounds[i], data + bounds[i + 1], parts[i]);
+	});
+
+	size_t total = 0;
+	for (size_t i = 0; i < count; ++i)
+	{
+		total += valid[i];
+	}
+
+	if (1 == count)
+	{
+		out.swap(parts[0]);
+	}
+	else
+	{
+		concat(workers, parts, out);
+	}
+	return total;
+}
+
+size_t Bulk::parseFile(const std::string & path, std::vector<int64> & out,
+	const char * fmt, const Zone * zone, ThreadPool * pool)
+{
+	out.clear();
+#ifdef PLATFORM_WINDOWS
+	FILE * file = fopen(path.c_str(), "rb");
+	if (NULL == file)
+	{
+		return 0;
+	}
+
+	std::string data;
+	char buf[65536];
+	size_t n = 0;
+	while ((n = fread(buf, 1, sizeof(buf), file)) > 0)
+	{
+		data.append(buf, n);
+	}
+	fclose(file);
+	return parse(data.data(), data.size(), out, fmt, zone, pool);
+#else
+	const int fd = ::open(path.c_str(), O_RDONLY);
+	if (fd < 0)
+	{
+		return 0;
+	}
+
+	struct stat info;
+	if (0 != fstat(fd, &info) || 0 == info.st_size)
+	{
+		::close(fd);
+		return 0;
+	}
+
+	const size_t size = static_cast<size_t>(info.st_size);
+	void * addr = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+	::close(fd);
+	if (MAP_FAILED == addr)
+	{
+		return 0;
+	}
+
+	madvise(addr, size, MADV_SEQUENTIAL);
+	const size_t count = parse(static_cast<const char *>(addr), size, out, fmt, zone, pool);
+	munmap(addr, size);
+	return count;
+#endif // PLATFORM_WINDOWS
+}
+
+} /* namespace ec */
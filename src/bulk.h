@@ -0,0 +1,68 @@
+﻿/*
+ * bulk.h
+ *
+ *  Created on: 2026年10月19日
+ *      Author: havesnag
+ */
+
+#ifndef INCLUDE_EC_BULK_H_
+#define INCLUDE_EC_BULK_H_
+
+#include "date.h"
+#include <stddef.h>
+#include <string>
+#include <vector>
+
+namespace ec
+{
+
+class ThreadPool;
+
+/**
+ * @brief 大量时间的并行格式化和解析
+ * @details
+ *     输入按块切分后在线程池中处理，块数多于线程数，由任务窃取平衡各块的耗时，输出保持输入的顺序。
+ *     格式与Date::format相同，%Y %m %d %H %M %S %X %G %V %u %%直接生成，其他说明符逐行交给strftime。
+ *     解析不使用strptime，只支持上述说明符，格式中的其他字符需原样匹配；有%G和%V且没有完整的%Y %m %d时按ISO周日期确定日期(没有%u时为星期一)，否则按年月日，此时%u须与之一致。
+ *     zone为NULL时按系统时区计算，含夏令时，结果与Date::format和Date的构造一致。
+ */
+class Bulk
+{
+public:
+	/** @brief 解析失败的行对应的值 */
+	static const int64 Invalid = INT64_MIN;
+
+	/**
+	 * @brief 格式化微秒时间戳，每个一行
+	 * @param stamps 微秒时间戳数组
+	 * @param count 个数
+	 * @param out 输出，每行以'\n'结尾
+	 * @param fmt 格式 @see Date::format
+	 * @param zone 时区
+	 * @param pool 线程池，为NULL时使用ThreadPool::shared()
+	 */
+	static void format(const int64 * stamps, size_t count, std::string & out,
+		const char * fmt = "%Y-%m-%d %H:%M:%S", const Zone * zone = NULL, ThreadPool * pool = NULL);
+
+	/**
+	 * @brief 解析每行开头的时间，行尾的'\r'和时间之后的内容被忽略
+	 * @param out 输出微秒时间戳，每行一个，解析失败的行为Invalid
+	 * @return 解析成功的行数
+	 */
+	static size_t parse(const char * data, size_t size, std::vector<int64> & out,
+		const char * fmt = "%Y-%m-%d %H:%M:%S", const Zone * zone = NULL, ThreadPool * pool = NULL);
+	/**
+	 * @brief 映射文件后解析每行开头的时间
+	 * @return 解析成功的行数，文件无法读取时返回0且out为空
+	 * @see parse
+	 */
+	static size_t parseFile(const std::string & path, std::vector<int64> & out,
+		const char * fmt = "%Y-%m-%d %H:%M:%S", const Zone * zone = NULL, ThreadPool * pool = NULL);
+
+private:
+	Bulk();
+};
+
+} /* namespace ec */
+
+#endif /* INCLUDE_EC_BULK_H_ */
@@ -0,0 +1,499 @@
+﻿/*
+ * businesscalendar.cpp
+ *
+ *  Created on: 2026年10月19日
+ *      Author: havesnag
+ */
+
+#include "businesscalendar.h"
+#include <stdio.h>
+#include <string.h>
+#include <ctype.h>
+#include <algorithm>
+#include <utility>
+using namespace std;
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif // _MSC_VER
+
+namespace ec
+{
+
+namespace
+{
+
+const int64 dayMicros = 86400LL * 1000000;
+
+/** @brief 每个字节中1的个数 */
+inline uint64_t byteCounts(uint64_t bits)
+{
+	bits = bits - ((bits >> 1) & 0x5555555555555555ULL);
+	bits = (bits & 0x3333333333333333ULL) + ((bits >> 2) & 0x3333333333333333ULL);
+	return (bits + (bits >> 4)) & 0x0f0f0f0f0f0f0f0fULL;
+}
+
+/** @brief 1的个数，x86没有popcnt指令时按字节并行计算 */
+inline unsigned countBits(uint64_t bits)
+{
+#if defined(__GNUC__) && (defined(__POPCNT__) || !(defined(__x86_64__) || defined(__i386__)))
+	return static_cast<unsigned>(__builtin_popcountll(bits));
+#else
+	return static_cast<unsigned>((byteCounts(bits) * 0x0101010101010101ULL) >> 56);
+#endif
+}
+
+/** @brief 末尾0的个数，bits不能为0 */
+inline unsigned trailingZeros(uint64_t bits)
+{
+#if defined(__GNUC__)
+	return static_cast<unsigned>(__builtin_ctzll(bits));
+#elif defined(_MSC_VER) && defined(_M_X64)
+	unsigned long index = 0;
+	_BitScanForward64(&index, bits);
+	return index;
+#else
+	unsigned count = 0;
+	while (0 == (bits & (static_cast<uint64_t>(1) << count)))
+	{
+		++count;
+	}
+	return count;
+#endif
+}
+
+/** @brief 第一个大于k的字节的序号，prefix的各字节须不大于127且递增 */
+inline unsigned firstGreater(uint64_t prefix, unsigned k)
+{
+	const uint64_t ones = 0x0101010101010101ULL;
+	const uint64_t highs = 0x8080808080808080ULL;
+	return trailingZeros(((prefix | highs) - (k + 1) * ones) & highs) >> 3;
+}
+
+/** @brief 第k个(从0开始)为1的位的位置，先按字节的累计个数找到所在字节，再在字节内按位找，没有分支 */
+inline unsigned selectBit(uint64_t bits, unsigned k)
+{
+	const uint64_t ones = 0x0101010101010101ULL;
+
+	// 第i个字节为前i+1个字节中1的个数
+	const uint64_t prefix = byteCounts(bits) * ones;
+	const unsigned byte = firstGreater(prefix, k);
+	k -= static_cast<unsigned>(((prefix << 8) >> (byte * 8)) & 0xff);
+
+	// 将该字节的每一位展开为一个字节的0或1，同样求累计个数
+	const uint64_t spread = (((bits >> (byte * 8)) & 0xff) * ones) & 0x8040201008040201ULL;
+	const uint64_t flags = ((spread + 0x7f7f7f7f7f7f7f7fULL) >> 7) & ones;
+	return byte * 8 + firstGreater(flags * ones, k);
+}
+
+/** @brief 解析YYYY-MM-DD */
+bool parseDay(const std::string & text, int64 & day)
+{
+	int year = 0, month = 0, date = 0;
+	char tail = 0;
+	if (3 != sscanf(text.c_str(), "%d-%d-%d%c", &year, &month, &date, &tail)
+		|| month < 1 || month > 12 || date < 1 || date > Date::yearMonthDays(year, month))
+	{
+		return false;
+	}
+	day = Date::daysFromCivil(year, month, date);
+	return true;
+}
+
+/** @brief 解析星期，可以是1~7、英文名称或其前三个字母，不区分大小写 */
+bool parseWeek(const std::string & text, int & week)
+{
+	static const char * const names[] = {
+		"monday", "tuesday", "wednesday", "thursday", "friday", "saturday", "sunday"
+	};
+
+	if (1 == text.size() && text[0] >= '1' && text[0] <= '7')
+	{
+		week = text[0] - '0';
+		return true;
+	}
+
+	std::string lower(text);
+	for (size_t i = 0; i < lower.size(); ++i)
+	{
+		lower[i] = static_cast<char>(tolower(static_cast<unsigned char>(lower[i])));
+	}
+
+	for (int i = 0; i < 7; ++i)
+	{
+		if (lower.size() >= 3 && 0 == strncmp(names[i], lower.c_str(), lower.size())
+			&& ('\0' == names[i][lower.size()] || 3 == lower.size()))
+		{
+			week = i + 1;
+			return true;
+		}
+	}
+	return false;
+}
+
+} /* namespace */
+
+BusinessCalendar::BusinessCalendar(int firstYear, int lastYear)
+	: _firstYear(firstYear), _lastYear(std::max(firstYear, lastYear)), _weekend((1 << 5) | (1 << 6))
+{
+	_firstDay = Date::daysFromCivil(_firstYear, 1, 1);
+	_days = Date::daysFromCivil(_lastYear + 1, 1, 1) - _firstDay;
+
+	const size_t words = static_cast<size_t>((_days + 63) / 64);
+	_bits.assign(words + 1, 0);
+	_ranks.assign(words + 2, 0);
+	_fill();
+}
+
+BusinessCalendar::~BusinessCalendar()
+{
+}
+
+void BusinessCalendar::setWeekend(unsigned mask)
+{
+	_weekend = mask & 0x7f;
+	_fill();
+}
+
+void BusinessCalendar::addHoliday(int year, int month, int day)
+{
+	const int64 value = Date::daysFromCivil(year, month, day);
+	_overrides[value] = false;
+	_apply(value);
+	_rebuild(static_cast<size_t>(std::min(std::max<int64>(value - _firstDay, 0), _days) / 64));
+}
+
+void BusinessCalendar::addWorkday(int year, int month, int day)
+{
+	const int64 value = Date::daysFromCivil(year, month, day);
+	_overrides[value] = true;
+	_apply(value);
+	_rebuild(static_cast<size_t>(std::min(std::max<int64>(value - _firstDay, 0), _days) / 64));
+}
+
+void BusinessCalendar::removeDay(int year, int month, int day)
+{
+	const int64 value = Date::daysFromCivil(year, month, day);
+	_overrides.erase(value);
+	_apply(value);
+	_rebuild(static_cast<size_t>(std::min(std::max<int64>(value - _firstDay, 0), _days) / 64));
+}
+
+void BusinessCalendar::clearDays()
+{
+	_overrides.clear();
+	_fill();
+}
+
+bool BusinessCalendar::parse(const char * data, size_t size, int * errorLine)
+{
+	unsigned weekend = _weekend;
+	std::vector<std::pair<int64, bool> > days;
+
+	const char * end = data + size;
+	int line = 0;
+	for (const char * p = data; p < end; )
+	{
+		const char * next = static_cast<const char *>(memchr(p, '\n', static_cast<size_t>(end - p)));
+		if (NULL == next)
+		{
+			next = end;
+		}
+		++line;
+
+		// 去掉注释后按空白分隔
+		const char * comment = static_cast<const char *>(memchr(p, '#', static_cast<size_t>(next - p)));
+		const char * stop = (NULL != comment) ? comment : next;
+		std::vector<std::string> tokens;
+		for (const char * q = p; q < stop; )
+		{
+			while (q < stop && isspace(static_cast<unsigned char>(*q)))
+			{
+				++q;
+			}
+			const char * begin = q;
+			while (q < stop && !isspace(static_cast<unsigned char>(*q)))
+			{
+				++q;
+			}
+			if (q > begin)
+			{
+				tokens.push_back(std::string(begin, q));
+			}
+		}
+		p = next + 1;
+
+		if (tokens.empty())
+		{
+			continue;
+		}
+
+		bool ok = true;
+		if ("weekend" == tokens[0])
+		{
+			weekend = 0;
+			for (size_t i = 1; ok && i < tokens.size(); ++i)
+			{
+				int week = 0;
+				ok = parseWeek(tokens[i], week);
+				weekend |= ok ? (1u << (week - 1)) : 0;
+			}
+		}
+		else if ("holiday" == tokens[0] || "workday" == tokens[0])
+		{
+			const bool business = ("workday" == tokens[0]);
+			ok = (tokens.size() > 1);
+			for (size_t i = 1; ok && i < tokens.size(); ++i)
+			{
+				int64 first = 0, last = 0;
+				const size_t dots = tokens[i].find("..");
+				if (std::string::npos == dots)
+				{
+					ok = parseDay(tokens[i], first);
+					last = first;
+				}
+				else
+				{
+					ok = parseDay(tokens[i].substr(0, dots), first)
+						&& parseDay(tokens[i].substr(dots + 2), last) && first <= last;
+				}
+
+				// 区间只保留覆盖范围内的部分
+				if (ok && (first != last))
+				{
+					first = std::max(first, _firstDay);
+					last = std::min(last, _firstDay + _days - 1);
+				}
+				for (int64 day = first; ok && day <= last; ++day)
+				{
+					days.push_back(std::make_pair(day, business));
+				}
+			}
+		}
+		else
+		{
+			ok = false;
+		}
+
+		if (!ok)
+		{
+			if (NULL != errorLine)
+			{
+				*errorLine = line;
+			}
+			return false;
+		}
+	}
+
+	_weekend = weekend;
+	for (size_t i = 0; i < days.size(); ++i)
+	{
+		_overrides[days[i].first] = days[i].second;
+	}
+	_fill();
+	return true;
+}
+
+bool BusinessCalendar::load(const std::string & path, int * errorLine)
+{
+	FILE * file = fopen(path.c_str(), "rb");
+	if (NULL == file)
+	{
+		return false;
+	}
+
+	std::string data;
+	char buf[4096];
+	size_t size = 0;
+	while ((size = fread(buf, 1, sizeof(buf), file)) > 0)
+	{
+		data.append(buf, size);
+	}
+	const bool failed = (0 != ferror(file));
+	fclose(file);
+
+	return !failed && parse(data.data(), data.size(), errorLine);
+}
+
+bool BusinessCalendar::isBusinessDay(int64 day) const
+{
+	if (day < _firstDay || day - _firstDay >= _days)
+	{
+		return false;
+	}
+
+	const size_t index = static_cast<size_t>(day - _firstDay);
+	return 0 != ((_bits[index >> 6] >> (index & 63)) & 1);
+}
+
+int64 BusinessCalendar::count(int64 from, int64 to) const
+{
+	return _rank(to) - _rank(from);
+}
+
+int64 BusinessCalendar::add(int64 day, int64 n) const
+{
+	if (0 == n)
+	{
+		return day;
+	}
+
+	// 之后的第n个是day之后的第一个工作日再往后n-1个，之前的第n个是day之前的工作日往前数
+	if (n > 0)
+	{
+		const int64 rank = (day < _firstDay + _days) ? _rank(day + 1) : _ranks.back();
+		return (n <= static_cast<int64>(_ranks.back()) - rank) ? _select(rank + n - 1) : Invalid;
+	}
+	const int64 rank = _rank(day);
+	return (-n <= rank) ? _select(rank + n) : Invalid;
+}
+
+bool BusinessCalendar::isBusinessDay(const Date & date) const
+{
+	return isBusinessDay(Date::daysFromCivil(date.year(), date.month(), date.day()));
+}
+
+bool BusinessCalendar::add(Date & date, int64 n) const
+{
+	const int64 day = add(Date::daysFromCivil(date.year(), date.month(), date.day()), n);
+	if (Invalid == day)
+	{
+		return false;
+	}
+
+	int year = 0, month = 0, value = 0;
+	Date::civilFromDays(day, year, month, value);
+	date.setDate(year, month, value);
+	return true;
+}
+
+int64 BusinessCalendar::diff(const Date & a, const Date & b) const
+{
+	return count(Date::daysFromCivil(b.year(), b.month(), b.day()),
+		Date::daysFromCivil(a.year(), a.month(), a.day()));
+}
+
+bool BusinessCalendar::isBusinessDay(const Time & time, time_t offset) const
+{
+	return isBusinessDay(Calendar::floorDiv(time.microStamp() - static_cast<int64>(offset) * 1000000, dayMicros));
+}
+
+bool BusinessCalendar::add(Time & time, int64 n, time_t offset) const
+{
+	const int64 stamp = time.microStamp();
+	const int64 day = Calendar::floorDiv(stamp - static_cast<int64>(offset) * 1000000, dayMicros);
+	const int64 target = add(day, n);
+	if (Invalid == target)
+	{
+		return false;
+	}
+
+	time.setMicroStamp(stamp + (target - day) * dayMicros);
+	return true;
+}
+
+int64 BusinessCalendar::diff(const Time & a, const Time & b, time_t offset) const
+{
+	const int64 shift = static_cast<int64>(offset) * 1000000;
+	return count(Calendar::floorDiv(b.microStamp() - shift, dayMicros), Calendar::floorDiv(a.microStamp() - shift, dayMicros));
+}
+
+void BusinessCalendar::_fill()
+{
+	std::fill(_bits.begin(), _bits.end(), 0);
+
+	int week = Calendar::weekDay(_firstDay) - 1;
+	for (int64 i = 0; i < _days; ++i)
+	{
+		if (0 == (_weekend & (1u << week)))
+		{
+			_bits[static_cast<size_t>(i >> 6)] |= static_cast<uint64_t>(1) << (i & 63);
+		}
+		week = (6 == week) ? 0 : week + 1;
+	}
+
+	for (std::map<int64, bool>::const_iterator it = _overrides.lower_bound(_firstDay);
+		it != _overrides.end() && it->first - _firstDay < _days; ++it)
+	{
+		_apply(it->first);
+	}
+	_rebuild(0);
+}
+
+void BusinessCalendar::_apply(int64 day)
+{
+	if (day < _firstDay || day - _firstDay >= _days)
+	{
+		return;
+	}
+
+	bool business = (0 == (_weekend & (1u << (Calendar::weekDay(day) - 1))));
+	const std::map<int64, bool>::const_iterator it = _overrides.find(day);
+	if (it != _overrides.end())
+	{
+		business = it->second;
+	}
+
+	const size_t index = static_cast<size_t>(day - _firstDay);
+	const uint64_t bit = static_cast<uint64_t>(1) << (index & 63);
+	if (business)
+	{
+		_bits[index >> 6] |= bit;
+	}
+	else
+	{
+		_bits[index >> 6] &= ~bit;
+	}
+}
+
+void BusinessCalendar::_rebuild(size_t word)
+{
+	const size_t words = _bits.size() - 1;
+	for (size_t i = word; i < words; ++i)
+	{
+		_ranks[i + 1] = _ranks[i] + countBits(_bits[i]);
+	}
+	_ranks[words + 1] = _ranks[words];
+
+	// 每64个工作日记录所在的字，select时从那里开始向后找
+	const uint32_t total = _ranks[words];
+	_samples.resize((total + 63) / 64);
+	size_t sample = 0;
+	for (size_t i = 0; i < words && sample < _samples.size(); ++i)
+	{
+		while (sample < _samples.size() && static_cast<uint32_t>(sample * 64) < _ranks[i + 1])
+		{
+			_samples[sample++] = static_cast<uint32_t>(i);
+		}
+	}
+}
+
+int64 BusinessCalendar::_rank(int64 day) const
+{
+	if (day <= _firstDay)
+	{
+		return 0;
+	}
+	if (day - _firstDay >= _days)
+	{
+		return _ranks.back();
+	}
+
+	const size_t index = static_cast<size_t>(day - _firstDay);
+	const uint64_t mask = (static_cast<uint64_t>(1) << (index & 63)) - 1;
+	return _ranks[index >> 6] + countBits(_bits[index >> 6] & mask);
+}
+
+int64 BusinessCalendar::_select(int64 rank) const
+{
+	size_t word = _samples[static_cast<size_t>(rank >> 6)];
+	while (_ranks[word + 1] <= rank)
+	{
+		++word;
+	}
+
+	const unsigned bit = selectBit(_bits[word], static_cast<unsigned>(rank - _ranks[word]));
+	return _firstDay + static_cast<int64>(word) * 64 + bit;
+}
+
+} /* namespace ec */
@@ -0,0 +1,147 @@
+﻿/*
+ * businesscalendar.h
+ *
+ *  Created on: 2026年10月19日
+ *      Author: havesnag
+ */
+
+#ifndef INCLUDE_EC_BUSINESSCALENDAR_H_
+#define INCLUDE_EC_BUSINESSCALENDAR_H_
+
+#include "date.h"
+#include <stddef.h>
+#include <stdint.h>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace ec
+{
+
+/**
+ * @brief 工作日日历，O(1)计算若干个工作日之后的日期和两个日期之间的工作日数
+ * @details
+ *     覆盖[firstYear, lastYear]，每天1位按顺序存为位图，每64天一个字，每个字保存之前的工作日数(rank)，
+ *     每64个工作日保存所在的字(select)，加减和求差都只需常数次查表与位运算。
+ *     周末可配置，节假日和调休的工作日逐日指定，修改后立即重建计数。
+ *     天数均为距离1970-01-01的天数 @see Date::daysFromCivil
+ *
+ *     文件格式，每行一条，#之后为注释，日期为YYYY-MM-DD，可以用..表示包含两端的区间：
+ * @code
+ * weekend Sat Sun
+ * holiday 2026-01-01 2026-10-01..2026-10-07
+ * workday 2026-10-10
+ * @endcode
+ * @note 查询可以多线程同时进行，修改不能与查询同时进行；覆盖范围之外没有工作日
+ */
+class BusinessCalendar
+{
+public:
+	/** @brief 无效的天数，结果超出覆盖范围 */
+	static const int64 Invalid = INT64_MIN;
+
+public:
+	/** @brief 构造，默认周六周日为周末，没有节假日 */
+	BusinessCalendar(int firstYear = 1970, int lastYear = 2099);
+	~BusinessCalendar();
+
+	/** @brief 覆盖的第一年 */
+	inline int firstYear() const
+	{
+		return _firstYear;
+	}
+
+	/** @brief 覆盖的最后一年 */
+	inline int lastYear() const
+	{
+		return _lastYear;
+	}
+
+	/**
+	 * @brief 设置周末
+	 * @param mask 第week-1位表示星期week是否为周末，week为[1,7] @see Date::week
+	 */
+	void setWeekend(unsigned mask);
+	/** @brief 周末，@see setWeekend */
+	inline unsigned weekend() const
+	{
+		return _weekend;
+	}
+
+	/** @brief 将某天设为节假日 */
+	void addHoliday(int year, int month, int day);
+	/** @brief 将某天设为工作日，比如周末调休 */
+	void addWorkday(int year, int month, int day);
+	/** @brief 取消某天的指定，恢复按周末判断 */
+	void removeDay(int year, int month, int day);
+	/** @brief 取消所有节假日和工作日的指定 */
+	void clearDays();
+
+	/**
+	 * @brief 解析日历文本，追加到当前配置
+	 * @param errorLine 不为NULL时，失败时设为出错的行号(从1开始)
+	 * @return 格式错误时返回false且不改变当前配置
+	 */
+	bool parse(const char * data, size_t size, int * errorLine = NULL);
+	/** @brief 读取并解析日历文件 @see parse */
+	bool load(const std::string & path, int * errorLine = NULL);
+
+	/** @brief 某天是否为工作日 */
+	bool isBusinessDay(int64 day) const;
+	/** @brief [from, to)中的工作日数，to小于from时为负数 */
+	int64 count(int64 from, int64 to) const;
+	/**
+	 * @brief 之后(或之前)的第n个工作日
+	 * @param day 起始日，不计入
+	 * @param n 为0时返回day本身
+	 * @return 超出覆盖范围时返回Invalid
+	 */
+	int64 add(int64 day, int64 n) const;
+
+	/** @brief 日期所在的那天是否为工作日，按Date的日历日期判断 */
+	bool isBusinessDay(const Date & date) const;
+	/** @brief 移动到之后(或之前)的第n个工作日，时分秒不变，超出范围时返回false且不修改 */
+	bool add(Date & date, int64 n) const;
+	/** @brief 两个日期的工作日差值，即[b, a)中的工作日数 */
+	int64 diff(const Date & a, const Date & b) const;
+
+	/** @brief 时间所在的那天是否为工作日，按offset的时区偏移判断 @see Date::localTimeZoneOffset */
+	bool isBusinessDay(const Time & time, time_t offset = Date::localTimeZoneOffset()) const;
+	/** @brief 移动到之后(或之前)的第n个工作日，当天的时间不变 */
+	bool add(Time & time, int64 n, time_t offset = Date::localTimeZoneOffset()) const;
+	/** @brief 两个时间的工作日差值 @see diff(const Date &, const Date &) */
+	int64 diff(const Time & a, const Time & b, time_t offset = Date::localTimeZoneOffset()) const;
+
+private:
+	BusinessCalendar(const BusinessCalendar &);
+	BusinessCalendar & operator = (const BusinessCalendar &);
+
+	/** @brief 按周末和指定的日期重新设置所有天 */
+	void _fill();
+	/** @brief 按周末和指定的日期设置某天 */
+	void _apply(int64 day);
+	/** @brief 从某个字开始重建计数 */
+	void _rebuild(size_t word);
+	/** @brief 覆盖范围内[start, day)中的工作日数 */
+	int64 _rank(int64 day) const;
+	/** @brief 第rank个工作日(从0开始) */
+	int64 _select(int64 rank) const;
+
+	int _firstYear;
+	int _lastYear;
+	int64 _firstDay;
+	int64 _days;
+	unsigned _weekend;
+	/** @brief 每天1位，多一个字便于边界处理 */
+	std::vector<uint64_t> _bits;
+	/** @brief 每个字之前的工作日数，比_bits多一个 */
+	std::vector<uint32_t> _ranks;
+	/** @brief 第64k个工作日所在的字 */
+	std::vector<uint32_t> _samples;
+	/** @brief 指定的日期，true为工作日，false为节假日 */
+	std::map<int64, bool> _overrides;
+};
+
+} /* namespace ec */
+
+#endif /* INCLUDE_EC_BUSINESSCALENDAR_H_ */
@@ -0,0 +1,160 @@
+﻿/*
+ * calendar.h
+ *
+ *  Created on: 2026年10月19日
+ *      Author: havesnag
+ */
+
+#ifndef INCLUDE_EC_CALENDAR_H_
+#define INCLUDE_EC_CALENDAR_H_
+
+#include <stdint.h>
+
+typedef int64_t int64;
+
+namespace ec
+{
+
+/** @brief 公历的年月日 */
+struct CivilDate
+{
+	int year;
+	/** @brief [1,12] */
+	int month;
+	/** @brief [1,31] */
+	int day;
+
+	constexpr CivilDate(int year, int month, int day)
+		: year(year), month(month), day(day)
+	{
+	}
+};
+
+/**
+ * @brief 编译期可用的公历计算
+ * @details
+ *     全部为constexpr，可以在常量表达式中使用，比如把固定的日期、分区边界在编译时算成天数或时间戳，
+ *     Date的对应函数也由它实现。天数均为距离1970-01-01的天数，时间戳为UTC的秒数，
+ *     按前推公历计算，支持负数(1970年之前)。算法见 http://howardhinnant.github.io/date_algorithms.html
+ * @code
+ * static_assert(Calendar::daysFromCivil(2000, 1, 1) == 10957, "");
+ * const int64 cutoff = Calendar::stamp(2026, 1, 1);
+ * @endcode
+ */
+class Calendar
+{
+public:
+	/** @brief 向下取整的除法，b为正数 */
+	static constexpr int64 floorDiv(int64 a, int64 b)
+	{
+		return (a >= 0) ? (a / b) : ((a - b + 1) / b);
+	}
+
+	/** @brief 是否为闰年 */
+	static constexpr bool isLeapYear(int year)
+	{
+		return (year % 4 == 0 && ((year % 400 == 0) || (year % 100 != 0)));
+	}
+
+	/** @brief 一年的天数 */
+	static constexpr int yearDays(int year)
+	{
+		return isLeapYear(year) ? 366 : 365;
+	}
+
+	/** @brief 某年某月的天数，月份超出[1,12]时为0 */
+	static constexpr int monthDays(int year, int month)
+	{
+		return (month < 1 || month > 12) ? 0
+			: (2 == month) ? (isLeapYear(year) ? 29 : 28)
+			: 30 + ((month + (month >> 3)) & 1);
+	}
+
+	/** @brief 某年某月某日距离1970-01-01的天数，月份超出[1,12]时自动进位，日可以超出当月 */
+	static constexpr int64 daysFromCivil(int year, int month, int day)
+	{
+		return _daysFromMonth(year + floorDiv(month - 1, 12), month - floorDiv(month - 1, 12) * 12, day);
+	}
+
+	/** @brief 距离1970-01-01的天数对应的年月日 */
+	static constexpr CivilDate civilFromDays(int64 days)
+	{
+		return _civilFromEra(floorDiv(days + 719468, 146097), days + 719468);
+	}
+
+	/** @brief 星期，[1,7]，1为星期一，7为星期日 */
+	static constexpr int weekDay(int64 days)
+	{
+		// 1970-01-01为星期四
+		return static_cast<int>(days + 3 - floorDiv(days + 3, 7) * 7) + 1;
+	}
+
+	/** @brief 一年中的第几天，[1,366] */
+	static constexpr int yearDay(int year, int month, int day)
+	{
+		return static_cast<int>(daysFromCivil(year, month, day) - daysFromCivil(year, 1, 1)) + 1;
+	}
+
+	/** @brief UTC时间对应的秒数时间戳 */
+	static constexpr int64 stamp(int year, int month, int day, int hour = 0, int minute = 0, int second = 0)
+	{
+		return daysFromCivil(year, month, day) * 86400 + hour * 3600 + minute * 60 + second;
+	}
+
+private:
+	Calendar();
+
+	/** @brief 月份已在[1,12]，以3月为一年的开始 */
+	static constexpr int64 _daysFromMonth(int64 year, int64 month, int64 day)
+	{
+		return _daysFromYear(year - ((month <= 2) ? 1 : 0),
+			(153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1);
+	}
+
+	/** @brief dayOfYear为从3月1日起的天数 */
+	static constexpr int64 _daysFromYear(int64 year, int64 dayOfYear)
+	{
+		return _daysFromEra(floorDiv(year, 400), year - floorDiv(year, 400) * 400, dayOfYear);
+	}
+
+	/** @brief 400年为一个周期(era)，yearOfEra为[0,399] */
+	static constexpr int64 _daysFromEra(int64 era, int64 yearOfEra, int64 dayOfYear)
+	{
+		return era * 146097 + yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear - 719468;
+	}
+
+	/** @brief shifted为距离0000-03-01的天数 */
+	static constexpr CivilDate _civilFromEra(int64 era, int64 shifted)
+	{
+		return _civilFromDayOfEra(era, shifted - era * 146097);
+	}
+
+	static constexpr CivilDate _civilFromDayOfEra(int64 era, int64 dayOfEra)
+	{
+		return _civilFromYearOfEra(era, dayOfEra,
+			(dayOfEra - dayOfEra / 1460 + dayOfEra / 36524 - dayOfEra / 146096) / 365);
+	}
+
+	static constexpr CivilDate _civilFromYearOfEra(int64 era, int64 dayOfEra, int64 yearOfEra)
+	{
+		return _civilFromDayOfYear(yearOfEra + era * 400,
+			dayOfEra - (365 * yearOfEra + yearOfEra / 4 - yearOfEra / 100));
+	}
+
+	static constexpr CivilDate _civilFromDayOfYear(int64 year, int64 dayOfYear)
+	{
+		return _civilFromMonth(year, dayOfYear, (5 * dayOfYear + 2) / 153);
+	}
+
+	/** @brief month为从3月起的月份，[0,11] */
+	static constexpr CivilDate _civilFromMonth(int64 year, int64 dayOfYear, int64 month)
+	{
+		return CivilDate(static_cast<int>(year + (month >= 10 ? 1 : 0)),
+			static_cast<int>(month < 10 ? month + 3 : month - 9),
+			static_cast<int>(dayOfYear - (153 * month + 2) / 5 + 1));
+	}
+};
+
+} /* namespace ec */
+
+#endif /* INCLUDE_EC_CALENDAR_H_ */
@@ -0,0 +1,230 @@
+﻿/*
+ * clock.cpp
+ *
+ *  Created on: 2026年10月19日
+ *      Author: havesnag
+ */
+
+#include "clock.h"
+#include <algorithm>
+
+#ifdef PLATFORM_WINDOWS
+/** @brief 在date.cpp中实现 */
+int gettimeofday(struct timeval *tp, void *tzp);
+#endif // PLATFORM_WINDOWS
+
+namespace ec
+{
+
+namespace
+{
+
+std::atomic<Clock *> globalClock(NULL);
+thread_local Clock * localClock = NULL;
+
+} /* namespace */
+
+std::atomic<int> Clock::_installed(0);
+
+Clock::Clock()
+{
+}
+
+Clock::~Clock()
+{
+}
+
+void Clock::setGlobal(Clock * clock)
+{
+	Clock * previous = globalClock.exchange(clock, std::memory_order_acq_rel);
+	_installed.fetch_add(((NULL != clock) ? 1 : 0) - ((NULL != previous) ? 1 : 0), std::memory_order_relaxed);
+}
+
+Clock * Clock::global()
+{
+	return globalClock.load(std::memory_order_acquire);
+}
+
+void Clock::setLocal(Clock * clock)
+{
+	_installed.fetch_add(((NULL != clock) ? 1 : 0) - ((NULL != localClock) ? 1 : 0), std::memory_order_relaxed);
+	localClock = clock;
+}
+
+Clock * Clock::local()
+{
+	return localClock;
+}
+
+int64 Clock::now()
+{
+	Clock * clock = localClock;
+	if (NULL == clock)
+	{
+		clock = globalClock.load(std::memory_order_acquire);
+	}
+	return (NULL != clock) ? clock->microStamp() : systemMicroStamp();
+}
+
+int64 Clock::systemMicroStamp()
+{
+	struct timeval tv;
+	gettimeofday(&tv, NULL);
+	return static_cast<int64>(tv.tv_sec) * 1000000 + tv.tv_usec;
+}
+
+
+ClockScope::ClockScope(Clock & clock)
+{
+	_previous = Clock::local();
+	Clock::setLocal(&clock);
+}
+
+ClockScope::~ClockScope()
+{
+	Clock::setLocal(_previous);
+}
+
+
+VirtualClock::VirtualClock(int64 start)
+	: _now(start), _next(1)
+{
+}
+
+VirtualClock::VirtualClock(const Time & start)
+	: _now(start.microStamp()), _next(1)
+{
+}
+
+VirtualClock::~VirtualClock()
+{
+}
+
+int64 VirtualClock::microStamp()
+{
+	return _now.load(std::memory_order_acquire);
+}
+
+void VirtualClock::set(int64 stamp)
+{
+	int64 current = _now.load(std::memory_order_relaxed);
+	while (current < stamp && !_now.compare_exchange_weak(current, stamp, std::memory_order_acq_rel))
+	{
+	}
+}
+
+void VirtualClock::set(const Time & time)
+{
+	set(time.microStamp());
+}
+
+void VirtualClock::advance(const Duration & duration)
+{
+	_now.fetch_add(std::max<int64>(duration.valueAs(Duration::MicroSecond), 0), std::memory_order_acq_rel);
+}
+
+uint64_t VirtualClock::schedule(const Time & deadline, const Callback & callback)
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	const uint64_t id = _next++;
+	_tasks[std::make_pair(deadline.microStamp(), id)] = callback;
+	_deadlines[id] = deadline.microStamp();
+	return id;
+}
+
+uint64_t VirtualClock::scheduleAfter(const Duration & delay, const Callback & callback)
+{
+	Time deadline(0);
+	deadline.setMicroStamp(microStamp() + delay.valueAs(Duration::MicroSecond));
+	return schedule(deadline, callback);
+}
+
+bool VirtualClock::cancel(uint64_t id)
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	std::map<uint64_t, int64>::iterator it = _deadlines.find(id);
+	if (_deadlines.end() == it)
+	{
+		return false;
+	}
+	_tasks.erase(std::make_pair(it->second, id));
+	_deadlines.erase(it);
+	return true;
+}
+
+size_t VirtualClock::pending() const
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	return _tasks.size();
+}
+
+bool VirtualClock::nextDeadline(int64 & stamp) const
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	if (_tasks.empty())
+	{
+		return false;
+	}
+	stamp = _tasks.begin()->first.first;
+	return true;
+}
+
+bool VirtualClock::runNext()
+{
+	Callback callback;
+	if (!_take(INT64_MAX, callback))
+	{
+		return false;
+	}
+	callback();
+	return true;
+}
+
+size_t VirtualClock::runUntil(const Time & deadline)
+{
+	const int64 end = deadline.microStamp();
+	size_t count = 0;
+	Callback callback;
+	while (_take(end, callback))
+	{
+		callback();
+		++count;
+	}
+	set(end);
+	return count;
+}
+
+size_t VirtualClock::runFor(const Duration & duration)
+{
+	Time deadline(0);
+	deadline.setMicroStamp(microStamp() + duration.valueAs(Duration::MicroSecond));
+	return runUntil(deadline);
+}
+
+size_t VirtualClock::runAll()
+{
+	size_t count = 0;
+	while (runNext())
+	{
+		++count;
+	}
+	return count;
+}
+
+bool VirtualClock::_take(int64 deadline, Callback & callback)
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	if (_tasks.empty() || _tasks.begin()->first.first > deadline)
+	{
+		return false;
+	}
+
+	std::map<std::pair<int64, uint64_t>, Callback>::iterator it = _tasks.begin();
+	set(it->first.first);
+	callback.swap(it->second);
+	_deadlines.erase(it->first.second);
+	_tasks.erase(it);
+	return true;
+}
+
+} /* namespace ec */
@@ -0,0 +1,155 @@
+﻿/*
+ * clock.h
+ *
+ *  Created on: 2026年10月19日
+ *      Author: havesnag
+ */
+
+#ifndef INCLUDE_EC_CLOCK_H_
+#define INCLUDE_EC_CLOCK_H_
+
+#include "date.h"
+#include <stddef.h>
+#include <stdint.h>
+#include <atomic>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <utility>
+
+namespace ec
+{
+
+/**
+ * @brief 可替换的时钟
+ * @details
+ *     Time()和Date()以当前时间构造时先看是否安装了时钟：当前线程的时钟优先，其次为全局时钟，都没有时读取系统时间。
+ *     没有安装任何时钟时只多一次原子变量的读取和一次可预测的分支。
+ *     依赖Time()的模块(限流、滑动窗口计数、混合逻辑时钟、ID生成器等)随之使用安装的时钟。
+ * @note 安装的时钟由调用者管理，卸载之前必须保持存在
+ */
+class Clock
+{
+public:
+	virtual ~Clock();
+
+	/** @brief 当前的微秒时间戳，可能被多个线程同时调用 */
+	virtual int64 microStamp() = 0;
+
+	/** @brief 安装全局时钟，为NULL时卸载 */
+	static void setGlobal(Clock * clock);
+	/** @brief 全局时钟 */
+	static Clock * global();
+	/** @brief 为当前线程安装时钟，为NULL时卸载 */
+	static void setLocal(Clock * clock);
+	/** @brief 当前线程的时钟 */
+	static Clock * local();
+
+	/** @brief 是否有任何线程安装了时钟 */
+	static inline bool overridden()
+	{
+		return _installed.load(std::memory_order_relaxed) > 0;
+	}
+
+	/** @brief 当前时钟的微秒时间戳，没有安装时钟时为系统时间 */
+	static int64 now();
+	/** @brief 系统时间的微秒时间戳 */
+	static int64 systemMicroStamp();
+
+protected:
+	Clock();
+
+private:
+	Clock(const Clock &);
+	Clock & operator = (const Clock &);
+
+	/** @brief 已安装的时钟个数，全局时钟与每个线程的时钟各算一个 */
+	static std::atomic<int> _installed;
+};
+
+/** @brief 在作用域内为当前线程安装时钟，结束时恢复之前的 */
+class ClockScope
+{
+public:
+	explicit ClockScope(Clock & clock);
+	~ClockScope();
+
+private:
+	ClockScope(const ClockScope &);
+	ClockScope & operator = (const ClockScope &);
+
+	Clock * _previous;
+};
+
+/**
+ * @brief 虚拟时钟，时间只在设置、前进或运行定时任务时改变
+ * @details
+ *     定时任务按(截止时间, 加入顺序)排序，运行时时钟直接跳到下一个截止时间再执行，中间的时间不用等待，
+ *     模拟一周的定时行为只需执行这些任务所用的时间。任务中可以再加入或取消任务。
+ *     时间只向前走，设置为更早的时间或运行已过期的任务时保持不变。
+ * @note 读取时间可以多线程进行；任务在调用run系列函数的线程中执行
+ */
+class VirtualClock : public Clock
+{
+public:
+	/** @brief 定时任务 */
+	typedef std::function<void ()> Callback;
+
+	/** @brief 以微秒时间戳构造 */
+	explicit VirtualClock(int64 start = 0);
+	/** @brief 以时间构造 */
+	explicit VirtualClock(const Time & start);
+	virtual ~VirtualClock();
+
+	virtual int64 microStamp();
+
+	/** @brief 设置为微秒时间戳，早于当前时间时不变 */
+	void set(int64 stamp);
+	/** @brief 设置时间 */
+	void set(const Time & time);
+	/** @brief 前进一段时间，不运行期间到期的任务 */
+	void advance(const Duration & duration);
+
+	/**
+	 * @brief 加入定时任务
+	 * @return 任务的编号，用于取消
+	 */
+	uint64_t schedule(const Time & deadline, const Callback & callback);
+	/** @brief 加入一段时间之后的定时任务 */
+	uint64_t scheduleAfter(const Duration & delay, const Callback & callback);
+	/** @brief 取消任务，已执行或不存在时返回false */
+	bool cancel(uint64_t id);
+
+	/** @brief 等待中的任务个数 */
+	size_t pending() const;
+	/** @brief 下一个任务的截止时间，没有任务时返回false */
+	bool nextDeadline(int64 & stamp) const;
+
+	/** @brief 跳到下一个任务的截止时间并执行它，没有任务时返回false */
+	bool runNext();
+	/**
+	 * @brief 依次执行截止时间不晚于deadline的任务，最后时钟停在deadline
+	 * @return 执行的任务个数
+	 */
+	size_t runUntil(const Time & deadline);
+	/** @brief 执行从现在起一段时间内的任务 */
+	size_t runFor(const Duration & duration);
+	/** @brief 执行所有任务，包括执行中新加入的，返回执行的个数 */
+	size_t runAll();
+
+private:
+	/** @brief 截止时间不晚于deadline时取出下一个任务并把时钟跳过去 */
+	bool _take(int64 deadline, Callback & callback);
+
+	std::atomic<int64> _now;
+	mutable std::mutex _mutex;
+	uint64_t _next;
+	/** @brief (截止时间, 编号)到任务 */
+	std::map<std::pair<int64, uint64_t>, Callback> _tasks;
+	/** @brief 编号到截止时间 */
+	std::map<uint64_t, int64> _deadlines;
+};
+
+} /* namespace ec */
+
+#endif /* INCLUDE_EC_CLOCK_H_ */
@@ -0,0 +1,470 @@
+﻿/*
+ * codec.cpp
+ *
+ *  Created on: 2026年10月19日
+ *      Author: havesnag
+ */
+
+#include "codec.h"
+using namespace std;
+
+namespace ec
+{
+
+namespace
+{
+
+/** @brief 读取周期字节，不是Duration::Period的值时返回false */
+inline bool readPeriod(const char *& data, Duration::Period & period)
+{
+	switch (static_cast<unsigned char>(*data))
+	{
+	case Duration::MicroSecond:
+	case Duration::MilliSecond:
+	case Duration::Second:
+	case Duration::Minute:
+	case Duration::Hour:
+	case Duration::Day:
+	case Duration::Week:
+	case Duration::Month:
+	case Duration::Year:
+		period = static_cast<Duration::Period>(*data++);
+		return true;
+	default:
+		return false;
+	}
+}
+
+inline void appendVarint(std::string & buffer, uint64_t value)
+{
+	char buf[10];
+	size_t size = 0;
+	while (value >= 0x80)
+	{
+		buf[size++] = static_cast<char>(value | 0x80);
+		value >>= 7;
+	}
+	buf[size++] = static_cast<char>(value);
+	buffer.append(buf, size);
+}
+
+inline bool readVarint(const char *& data, const char * end, uint64_t & value)
+{
+	const unsigned char * p = reinterpret_cast<const unsigned char *>(data);
+	const unsigned char * last = reinterpret_cast<const unsigned char *>(end);
+	uint64_t result = 0;
+	for (int shift = 0; shift < 64 && p < last; shift += 7)
+	{
+		const uint64_t byte = *p++;
+		result |= (byte & 0x7F) << shift;
+		if (byte < 0x80)
+		{
+			value = result;
+			data = reinterpret_cast<const char *>(p);
+			return true;
+		}
+	}
+	return false;
+}
+
+/** @brief 相邻差值，按无符号整数回绕，任意取值都不会溢出 */
+inline int64 delta(int64 current, int64 previous)
+{
+	return static_cast<int64>(static_cast<uint64_t>(current) - static_cast<uint64_t>(previous));
+}
+
+inline int64 accumulate(int64 previous, int64 delta)
+{
+	return static_cast<int64>(static_cast<uint64_t>(previous) + static_cast<uint64_t>(delta));
+}
+
+} /* namespace */
+
+Encoder::Encoder(std::string & buffer)
+	: _buffer(buffer)
+{
+}
+
+Encoder::~Encoder()
+{
+}
+
+Encoder & Encoder::putFixed32(uint32_t value)
+{
+	char buf[4];
+	for (int i = 0; i < 4; ++i)
+	{
+		buf[i] = static_cast<char>(value >> (i * 8));
+	}
+	_buffer.append(buf, 4);
+	return *this;
+}
+
+Encoder & Encoder::putFixed64(uint64_t value)
+{
+	char buf[8];
+	for (int i = 0; i < 8; ++i)
+	{
+		buf[i] = static_cast<char>(value >> (i * 8));
+	}
+	_buffer.append(buf, 8);
+	return *this;
+}
+
+Encoder & Encoder::putVarint(uint64_t value)
+{
+	appendVarint(_buffer, value);
+	return *this;
+}
+
+Encoder & Encoder::putSignedVarint(int64 value)
+{
+	appendVarint(_buffer, zigzag(value));
+	return *this;
+}
+
+Encoder & Encoder::putTime(const Time & time)
+{
+	return putFixed64(static_cast<uint64_t>(time.microStamp()));
+}
+
+Encoder & Encoder::putDate(const Date & date)
+{
+	// UTC的Date::stamp()按本地时间解释日历字段，直接由日历字段计算时刻
+	const int64 stamp = date.isUTC()
+		? Calendar::stamp(date.year(), date.month(), date.day(), date.hour(), date.minute(), date.second())
+		: static_cast<int64>(date.stamp());
+	putSignedVarint(stamp);
+	_buffer.push_back(date.isUTC() ? 1 : 0);
+	return *this;
+}
+
+Encoder & Encoder::putDuration(const Duration & duration)
+{
+	_buffer.push_back(static_cast<char>(duration.period()));
+	return putSignedVarint(duration.value());
+}
+
+Encoder & Encoder::putFixedStamps(const int64 * stamps, size_t count)
+{
+	putVarint(count);
+	_buffer.reserve(_buffer.size() + count * 8);
+	for (size_t i = 0; i < count; ++i)
+	{
+		putFixed64(static_cast<uint64_t>(stamps[i]));
+	}
+	return *this;
+}
+
+Encoder & Encoder::putStamps(const int64 * stamps, size_t count)
+{
+	std::string body;
+	int64 last = 0;
+	for (size_t i = 0; i < count; ++i)
+	{
+		appendVarint(body, zigzag(delta(stamps[i], last)));
+		last = stamps[i];
+	}
+
+	putVarint(count);
+	putVarint(body.size());
+	_buffer.append(body);
+	return *this;
+}
+
+Encoder & Encoder::putTimes(const Time * times, size_t count)
+{
+	std::string body;
+	int64 last = 0;
+	for (size_t i = 0; i < count; ++i)
+	{
+		const int64 stamp = times[i].microStamp();
+		appendVarint(body, zigzag(delta(stamp, last)));
+		last = stamp;
+	}
+
+	putVarint(count);
+	putVarint(body.size());
+	_buffer.append(body);
+	return *this;
+}
+
+Encoder & Encoder::putDurations(const Duration * durations, size_t count)
+{
+	putVarint(count);
+	for (size_t begin = 0; begin < count; )
+	{
+		const Duration::Period period = durations[begin].period();
+		size_t end = begin + 1;
+		while (end < count && durations[end].period() == period)
+		{
+			++end;
+		}
+
+		_buffer.push_back(static_cast<char>(period));
+		putVarint(end - begin);
+		int64 last = 0;
+		for (; begin < end; ++begin)
+		{
+			putSignedVarint(delta(durations[begin].value(), last));
+			last = durations[begin].value();
+		}
+	}
+	return *this;
+}
+
+
+FixedStamps::FixedStamps()
+{
+	_data = NULL;
+	_count = 0;
+}
+
+
+StampSequence::StampSequence()
+{
+	_data = NULL;
+	_end = NULL;
+	_remaining = 0;
+	_last = 0;
+}
+
+bool StampSequence::next(int64 & stamp)
+{
+	uint64_t value = 0;
+	if (0 == _remaining || !readVarint(_data, _end, value))
+	{
+		return false;
+	}
+
+	_last = accumulate(_last, Decoder::unzigzag(value));
+	--_remaining;
+	stamp = _last;
+	return true;
+}
+
+bool StampSequence::next(Time & time)
+{
+	int64 stamp = 0;
+	if (!next(stamp))
+	{
+		return false;
+	}
+
+	time.setMicroStamp(stamp);
+	return true;
+}
+
+size_t StampSequence::decode(int64 * stamps, size_t capacity)
+{
+	size_t count = 0;
+	while (count < capacity && next(stamps[count]))
+	{
+		++count;
+	}
+	return count;
+}
+
+
+Decoder::Decoder(const char * data, size_t size)
+{
+	_data = data;
+	_end = data + size;
+}
+
+Decoder::Decoder(const std::string & buffer)
+{
+	_data = buffer.data();
+	_end = _data + buffer.size();
+}
+
+Decoder::~Decoder()
+{
+}
+
+bool Decoder::getFixed32(uint32_t & value)
+{
+	if (remaining() < 4)
+	{
+		return false;
+	}
+
+	const unsigned char * p = reinterpret_cast<const unsigned char *>(_data);
+	value = static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8)
+		| (static_cast<uint32_t>(p[2]) << 16) | (static_cast<uint32_t>(p[3]) << 24);
+	_data += 4;
+	return true;
+}
+
+bool Decoder::getFixed64(uint64_t & value)
+{
+	if (remaining() < 8)
+	{
+		return false;
+	}
+
+	FixedStamps view;
+	view._data = _data;
+	view._count = 1;
+	value = static_cast<uint64_t>(view[0]);
+	_data += 8;
+	return true;
+}
+
+bool Decoder::getVarint(uint64_t & value)
+{
+	return readVarint(_data, _end, value);
+}
+
+bool Decoder::getSignedVarint(int64 & value)
+{
+	uint64_t raw = 0;
+	if (!readVarint(_data, _end, raw))
+	{
+		return false;
+	}
+
+	value = unzigzag(raw);
+	return true;
+}
+
+bool Decoder::getTime(Time & time)
+{
+	uint64_t stamp = 0;
+	if (!getFixed64(stamp))
+	{
+		return false;
+	}
+
+	time.setMicroStamp(static_cast<int64>(stamp));
+	return true;
+}
+
+bool Decoder::getDate(Date & date)
+{
+	const char * begin = _data;
+	int64 stamp = 0;
+	if (!getSignedVarint(stamp) || remaining() < 1)
+	{
+		_data = begin;
+		return false;
+	}
+
+	date = Date(static_cast<time_t>(stamp), 0 != *_data++);
+	return true;
+}
+
+bool Decoder::getDuration(Duration & duration)
+{
+	const char * begin = _data;
+	int64 value = 0;
+	if (remaining() < 1)
+	{
+		return false;
+	}
+
+	Duration::Period period = Duration::Second;
+	if (!readPeriod(_data, period) || !getSignedVarint(value))
+	{
+		_data = begin;
+		return false;
+	}
+
+	duration.set(value, period);
+	return true;
+}
+
+bool Decoder::getFixedStamps(FixedStamps & stamps)
+{
+	const char * begin = _data;
+	uint64_t count = 0;
+	if (!getVarint(count) || remaining() / 8 < count)
+	{
+		_data = begin;
+		return false;
+	}
+
+	stamps._data = _data;
+	stamps._count = static_cast<size_t>(count);
+	_data += count * 8;
+	return true;
+}
+
+bool Decoder::getStamps(StampSequence & stamps)
+{
+	const char * begin = _data;
+	uint64_t count = 0;
+	uint64_t size = 0;
+	if (!getVarint(count) || !getVarint(size) || remaining() < size || size < count)
+	{
+		_data = begin;
+		return false;
+	}
+
+	stamps._data = _data;
+	stamps._end = _data + size;
+	stamps._remaining = static_cast<size_t>(count);
+	stamps._last = 0;
+	_data += size;
+	return true;
+}
+
+bool Decoder::getTimes(std::vector<Time> & times)
+{
+	const char * begin = _data;
+	StampSequence stamps;
+	if (!getStamps(stamps))
+	{
+		return false;
+	}
+
+	const size_t size = times.size();
+	times.resize(size + stamps.remaining());
+	for (size_t i = size; i < times.size(); ++i)
+	{
+		if (!stamps.next(times[i]))
+		{
+			times.resize(size);
+			_data = begin;
+			return false;
+		}
+	}
+	return true;
+}
+
+bool Decoder::getDurations(std::vector<Duration> & durations)
+{
+	const char * begin = _data;
+	const size_t size = durations.size();
+	uint64_t count = 0;
+	bool ok = getVarint(count) && count <= remaining();
+	while (ok && durations.size() - size < count)
+	{
+		uint64_t runLength = 0;
+		ok = remaining() > 0;
+		if (!ok)
+		{
+			break;
+		}
+
+		Duration::Period period = Duration::Second;
+		ok = readPeriod(_data, period) && getVarint(runLength) && runLength <= count - (durations.size() - size);
+		int64 last = 0;
+		for (uint64_t i = 0; ok && i < runLength; ++i)
+		{
+			int64 value = 0;
+			ok = getSignedVarint(value);
+			last = accumulate(last, value);
+			durations.push_back(Duration(last, period));
+		}
+	}
+
+	if (!ok)
+	{
+		durations.resize(size);
+		_data = begin;
+	}
+	return ok;
+}
+
+} /* namespace ec */
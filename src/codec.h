@@ -0,0 +1,202 @@
+﻿/*
+ * codec.h
+ *
+ *  Created on: 2026年10月19日
+ *      Author: havesnag
+ */
+
+#ifndef INCLUDE_EC_CODEC_H_
+#define INCLUDE_EC_CODEC_H_
+
+#include "date.h"
+#include <stddef.h>
+#include <string.h>
+#include <vector>
+
+namespace ec
+{
+
+/**
+ * @brief 二进制编码器，追加写入到字符串缓冲区
+ * @details
+ *     定长整数按小端序存储，有符号整数使用zigzag变长编码，
+ *     时间序列存储首个值和相邻差值，有序或接近有序时每个Time只需1~3个字节。
+ *     所有Time均按微秒时间戳编码 @see Time::microStamp
+ */
+class Encoder
+{
+public:
+	/** @brief zigzag编码，将有符号整数映射为无符号整数，绝对值小的数编码后也小 */
+	static inline uint64_t zigzag(int64 value)
+	{
+		return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+	}
+
+public:
+	/** @brief 以缓冲区构造，编码结果追加到buffer末尾 */
+	Encoder(std::string & buffer);
+	~Encoder();
+
+	/** @brief 缓冲区 */
+	inline std::string & buffer()
+	{
+		return _buffer;
+	}
+
+	/** @brief 小端序4字节 */
+	Encoder & putFixed32(uint32_t value);
+	/** @brief 小端序8字节 */
+	Encoder & putFixed64(uint64_t value);
+	/** @brief 无符号变长整数，每字节7位，[1,10]字节 */
+	Encoder & putVarint(uint64_t value);
+	/** @brief 有符号变长整数，zigzag编码 */
+	Encoder & putSignedVarint(int64 value);
+
+	/** @brief 定长8字节的微秒时间戳 */
+	Encoder & putTime(const Time & time);
+	/**
+	 * @brief 时刻的时间戳(秒)和是否为UTC，变长
+	 * @note 不保存时区，带时区的Date解码为同一时刻的系统本地日历时间
+	 */
+	Encoder & putDate(const Date & date);
+	/** @brief 1字节周期和变长数值 */
+	Encoder & putDuration(const Duration & duration);
+
+	/** @brief 个数和定长8字节的微秒时间戳数组，可以零拷贝访问 @see FixedStamps */
+	Encoder & putFixedStamps(const int64 * stamps, size_t count);
+	/** @brief 个数、首个微秒时间戳和相邻差值 @see StampSequence */
+	Encoder & putStamps(const int64 * stamps, size_t count);
+	/** @brief 个数、首个时间和相邻差值 @see putStamps */
+	Encoder & putTimes(const Time * times, size_t count);
+	/** @brief 个数，之后按相同周期分段，每段为周期、段长和相邻差值 */
+	Encoder & putDurations(const Duration * durations, size_t count);
+
+private:
+	Encoder(const Encoder &);
+	Encoder & operator = (const Encoder &);
+
+	std::string & _buffer;
+};
+
+/**
+ * @brief 定长微秒时间戳数组的视图，直接读取缓冲区，不复制
+ * @see Encoder::putFixedStamps
+ */
+class FixedStamps
+{
+public:
+	FixedStamps();
+
+	/** @brief 个数 */
+	inline size_t size() const
+	{
+		return _count;
+	}
+
+	/** @brief 第index个微秒时间戳 */
+	inline int64 operator [] (size_t index) const
+	{
+		const unsigned char * p = reinterpret_cast<const unsigned char *>(_data + index * 8);
+		uint64_t value = 0;
+		for (int i = 7; i >= 0; --i)
+		{
+			value = (value << 8) | p[i];
+		}
+		return static_cast<int64>(value);
+	}
+
+private:
+	friend class Decoder;
+
+	const char * _data;
+	size_t _count;
+};
+
+/**
+ * @brief 差值编码的微秒时间戳序列的视图，顺序解码，不复制
+ * @see Encoder::putStamps
+ */
+class StampSequence
+{
+public:
+	StampSequence();
+
+	/** @brief 剩余个数 */
+	inline size_t remaining() const
+	{
+		return _remaining;
+	}
+
+	/** @brief 解码下一个，没有剩余或数据损坏时返回false */
+	bool next(int64 & stamp);
+	/** @brief 解码下一个为Time对象 */
+	bool next(Time & time);
+	/** @brief 批量解码，返回解码的个数 */
+	size_t decode(int64 * stamps, size_t capacity);
+
+private:
+	friend class Decoder;
+
+	const char * _data;
+	const char * _end;
+	size_t _remaining;
+	int64 _last;
+};
+
+/**
+ * @brief 二进制解码器，直接读取外部缓冲区，缓冲区的生命周期必须长于解码器和它返回的视图
+ * @details 数据不足或格式错误时返回false，且不移动读取位置
+ * @see Encoder
+ */
+class Decoder
+{
+public:
+	/** @brief zigzag解码 @see Encoder::zigzag */
+	static inline int64 unzigzag(uint64_t value)
+	{
+		return static_cast<int64>(value >> 1) ^ -static_cast<int64>(value & 1);
+	}
+
+public:
+	Decoder(const char * data, size_t size);
+	Decoder(const std::string & buffer);
+	~Decoder();
+
+	/** @brief 剩余字节数 */
+	inline size_t remaining() const
+	{
+		return static_cast<size_t>(_end - _data);
+	}
+
+	/** @brief 当前读取位置 */
+	inline const char * data() const
+	{
+		return _data;
+	}
+
+	bool getFixed32(uint32_t & value);
+	bool getFixed64(uint64_t & value);
+	bool getVarint(uint64_t & value);
+	bool getSignedVarint(int64 & value);
+
+	bool getTime(Time & time);
+	bool getDate(Date & date);
+	bool getDuration(Duration & duration);
+
+	/** @brief 获取定长微秒时间戳数组的视图 */
+	bool getFixedStamps(FixedStamps & stamps);
+	/** @brief 获取差值编码的微秒时间戳序列的视图，跳过整个序列 */
+	bool getStamps(StampSequence & stamps);
+	/** @brief 解码差值编码的时间序列，追加到times末尾 */
+	bool getTimes(std::vector<Time> & times);
+	/** @brief 解码时间段序列，追加到durations末尾 */
+	bool getDurations(std::vector<Duration> & durations);
+
+private:
+	const char * _data;
+	const char * _end;
+};
+
+} /* namespace ec */
+
+#endif /* INCLUDE_EC_CODEC_H_ */
@@ -6,12 +6,20 @@
  */
 
 #include "date.h"
+#include "clock.h"
+#include "zone.h"
 #include <limits.h>
 #include <sstream>
 #include <iomanip>
 #include <string.h>
+#include <atomic>
 using namespace std;
 
+#ifndef EC_DATE_HEADER_ONLY
+#define EC_DATE_INLINE
+#include "date_inl.h"
+#endif // EC_DATE_HEADER_ONLY
+
 #ifdef PLATFORM_WINDOWS
 
 #define localtime_r(t, tm) localtime_s(tm, t)
@@ -40,298 +48,263 @@ int gettimeofday(struct timeval *tp, void *tzp)
 namespace ec
 {
 
-Duration::Duration(int64 value, Period period)
-{
-	_value = value;
-	_period = period;
-}
-
-Duration::Duration(const Duration &duration)
-{
-	_value = duration._value;
-	_period = duration._period;
-}
-
-Duration::~Duration()
+namespace
 {
-}
 
-Duration Duration::clone() const
-{
-	return Duration(*this);
-}
+/** @brief 系统时区缓存的版本，Date::resetZoneCache()时递增 */
+std::atomic<uint32_t> zoneGeneration(0);
 
-Duration & Duration::set(int64 value, Period period)
+/** @brief 按UTC天数和当天秒数填充tm，不处理时区字段 */
+void fillTm(struct tm & tm, int64 days, int seconds)
 {
-	_value = value;
-	_period = period;
-	return *this;
+	int year = 0, month = 0, day = 0;
+	Date::civilFromDays(days, year, month, day);
+	tm.tm_year = year - 1900;
+	tm.tm_mon = month - 1;
+	tm.tm_mday = day;
+	tm.tm_hour = seconds / 3600;
+	tm.tm_min = seconds / 60 % 60;
+	tm.tm_sec = seconds % 60;
+	tm.tm_wday = Calendar::weekDay(days) % 7;
+	tm.tm_yday = static_cast<int>(days - Calendar::daysFromCivil(year, 1, 1));
 }
 
-Duration & Duration::setValue(int64 value)
+/** @brief 按localtime计算系统时区的偏移 */
+int systemOffset(time_t stamp)
 {
-	_value = value;
-	return *this;
-}
-
-Duration & Duration::setPeriod(Period period)
-{
-	_period = period;
-	return *this;
+	struct tm tm;
+	localtime_r(&stamp, &tm);
+	const int64 local = Date::daysFromCivil(tm.tm_year + 1900, tm.tm_mon + 1, tm.tm_mday) * 86400
+		+ tm.tm_hour * 3600 + tm.tm_min * 60 + tm.tm_sec;
+	return static_cast<int>(local - static_cast<int64>(stamp));
 }
 
-Duration & Duration::rase()
+/** @brief 按mktime转换系统时区的本地日历时间，由mktime判断夏令时，重叠的时间取较早的时刻 */
+time_t systemLocalToUTC(time_t local)
 {
-	switch (_period)
-	{
-	case Duration::MicroSecond:
-		_period = Duration::MilliSecond;
-		_value /= 1000;
-		break;
-	case Duration::MilliSecond:
-		_period = Duration::Second;
-		_value /= 1000;
-		break;
-	case Duration::Second:
-		_period = Duration::Minute;
-		_value /= 60;
-		break;
-	case Duration::Minute:
-		_period = Duration::Hour;
-		_value /= 60;
-		break;
-	case Duration::Hour:
-		_period = Duration::Day;
-		_value /= 24;
-		break;
-	case Duration::Day:
-		_period = Duration::Week;
-		_value /= 7;
-		break;
-	case Duration::Week:
-		_period = Duration::Month;
-		_value /= 4;
-		break;
-	case Duration::Month:
-		_period = Duration::Year;
-		_value /= 12;
-		break;
-	default:
-		break;
-	}
-	return *this;
-}
+	const int64 days = Calendar::floorDiv(local, 86400);
+	struct tm tm;
+	memset(&tm, 0, sizeof(struct tm));
+	fillTm(tm, days, static_cast<int>(local - days * 86400));
+	tm.tm_isdst = -1;
+	const time_t stamp = mktime(&tm);
 
-Duration & Duration::down()
-{
-	switch (_period)
+	// 重叠的时间mktime的选择与之前的调用有关，统一取较早的时刻，与Zone::localToUTC一致
+	const time_t earlier = static_cast<time_t>(local - systemOffset(stamp - 7200));
+	if (earlier < stamp && systemOffset(earlier) == static_cast<int>(local - earlier))
 	{
-	case Duration::MilliSecond:
-		_period = Duration::MicroSecond;
-		_value *= 1000;
-		break;
-	case Duration::Second:
-		_period = Duration::MilliSecond;
-		_value *= 1000;
-		break;
-	case Duration::Minute:
-		_period = Duration::Second;
-		_value *= 60;
-		break;
-	case Duration::Hour:
-		_period = Duration::Minute;
-		_value *= 60;
-		break;
-	case Duration::Day:
-		_period = Duration::Hour;
-		_value *= 24;
-		break;
-	case Duration::Week:
-		_period = Duration::Day;
-		_value *= 7;
-		break;
-	case Duration::Month:
-		_period = Duration::Week;
-		_value *= 4;
-		break;
-	case Duration::Year:
-		_period = Duration::Month;
-		_value *= 12;
-		break;
-	default:
-		break;
+		return earlier;
 	}
-	return *this;
+	return stamp;
 }
 
-Duration & Duration::as(Period period)
+/** @brief 设置tm的时区字段 */
+void fillTmZone(struct tm & tm, const Zone::Info & info)
 {
-	if (_period < period)
-	{
-		for (; _period < period; )
-		{
-			rase();
-		}
-	}
-	else if (_period > period)
-	{
-		for (; _period > period; )
-		{
-			down();
-		}
-	}
-	return *this;
+	tm.tm_isdst = info.isDst ? 1 : 0;
+#ifndef PLATFORM_WINDOWS
+# if defined(__USE_BSD) || defined(__USE_MISC)
+	tm.tm_gmtoff = info.offset;
+	tm.tm_zone = info.abbr;
+# else
+	tm.__tm_gmtoff = info.offset;
+	tm.__tm_zone = info.abbr;
+# endif//__USE_BSD __USE_MISC 
+#endif // PLATFORM_WINDOWS
 }
 
-int64 Duration::valueAs(Period period) const
-{
-	return clone().as(period).value();
-}
+} /* namespace */
 
-Duration Duration::operator + (const Duration &other)
-{
-	return Duration(_value + other.valueAs(_period), _period);
-}
 
-Duration Duration::operator + (int64 value)
-{
-	return Duration(_value + value, _period);
-}
 
-Duration Duration::operator - (const Duration &other)
-{
-	return Duration(_value - other.valueAs(_period), _period);
-}
 
-Duration Duration::operator - (int64 value)
+time_t Date::localTimeZoneOffset()
 {
-	return Duration(_value - value, _period);
+	return localTimeZone() * -3600;
 }
 
-Duration & Duration::operator += (const Duration &other)
+int Date::localTimeZone()
 {
-	_value += other.valueAs(_period);
-	return *this;
+	// UTC以西的时区1970-01-01 00:00:00 UTC落在前一天
+	static int tz = (1970 == Date(0).year()) ? Date(0).hour() : Date(0).hour() - 24;
+	return tz;
 }
 
-Duration & Duration::operator += (int64 value)
+void Date::resetZoneCache()
 {
-	_value += value;
-	return *this;
+	zoneGeneration.fetch_add(1, std::memory_order_release);
 }
 
-Duration & Duration::operator -= (const Duration &other)
+int Date::localOffset(time_t stamp)
 {
-	_value -= other.valueAs(_period);
-	return *this;
-}
+	static thread_local int64 cachedHour = INT64_MIN;
+	static thread_local int cachedOffset = 0;
+	static thread_local uint32_t cachedGeneration = 0;
+	const int64 hour = Calendar::floorDiv(stamp, 3600);
+	const uint32_t generation = zoneGeneration.load(std::memory_order_acquire);
+	if (hour == cachedHour && generation == cachedGeneration)
+	{
+		return cachedOffset;
+	}
 
-Duration & Duration::operator -= (int64 value)
-{
-	_value -= value;
-	return *this;
+	const int offset = systemOffset(stamp);
+	// 小时的首尾偏移相同时整个小时都不跨越切换
+	const time_t first = static_cast<time_t>(hour * 3600);
+	const int head = (first == stamp) ? offset : systemOffset(first);
+	if (head == offset && head == systemOffset(first + 3599))
+	{
+		cachedHour = hour;
+		cachedOffset = offset;
+		cachedGeneration = generation;
+	}
+	return offset;
 }
 
-bool Duration::operator > (const Duration & other)
+time_t Date::localToUTC(time_t local)
 {
-	return (_period == other._period) ? (_value > other._value) : (_period > other._period);
-}
+	static thread_local int64 cachedHour = INT64_MIN;
+	static thread_local int64 cachedShift = 0;
+	static thread_local uint32_t cachedGeneration = 0;
+	const int64 hour = Calendar::floorDiv(local, 3600);
+	const uint32_t generation = zoneGeneration.load(std::memory_order_acquire);
+	if (hour == cachedHour && generation == cachedGeneration)
+	{
+		return static_cast<time_t>(local + cachedShift);
+	}
 
-bool Duration::operator >= (const Duration & other)
-{
-	return (_period == other._period) ? (_value >= other._value) : (_period > other._period);
+	const time_t first = static_cast<time_t>(hour * 3600);
+	const time_t head = systemLocalToUTC(first);
+	if (systemLocalToUTC(first + 3599) - head == 3599)
+	{
+		cachedHour = hour;
+		cachedShift = static_cast<int64>(head) - first;
+		cachedGeneration = generation;
+		return static_cast<time_t>(local + cachedShift);
+	}
+	return systemLocalToUTC(local);
 }
 
-bool Duration::operator == (const Duration & other)
+void Date::isoWeekFromDays(int64 days, int & year, int & week, int & weekDay)
 {
-	return (_period == other._period) && (_value == other._value);
+	// 所在周的星期四决定ISO周年
+	const int64 index = Calendar::weekDay(days) - 1;
+	const int64 thursday = days - index + 3;
+	int month = 0, day = 0;
+	civilFromDays(thursday, year, month, day);
+	week = static_cast<int>((thursday - daysFromCivil(year, 1, 1)) / 7 + 1);
+	weekDay = static_cast<int>(index + 1);
 }
 
-bool Duration::operator != (const Duration & other)
+int64 Date::daysFromIsoWeek(int year, int week, int weekDay)
 {
-	return (_period != other._period) && (_value != other._value);
+	// 1月4日总在第1周
+	const int64 jan4 = daysFromCivil(year, 1, 4);
+	const int64 monday = jan4 - (Calendar::weekDay(jan4) - 1);
+	return monday + static_cast<int64>(week - 1) * 7 + (weekDay - 1);
 }
 
-bool Duration::operator < (const Duration & other)
+int64 Date::weekStartDays(int64 days, int firstWeekDay)
 {
-	return (_period == other._period) ? (_value < other._value) : (_period < other._period);
+	const int64 back = days + 3 - (firstWeekDay - 1);
+	return days - (back - Calendar::floorDiv(back, 7) * 7);
 }
 
-bool Duration::operator <= (const Duration & other)
+void Date::formatZones(time_t stamp, const Zone * const * zones, size_t count,
+	std::string * out, const char * fmt)
 {
-	return (_period == other._period) ? (_value <= other._value) : (_period < other._period);
-}
-
+	const int64 days = Calendar::floorDiv(stamp, 86400);
+	const int seconds = static_cast<int>(stamp - days * 86400);
 
+	// 偏移不超过±26小时，本地日期只可能落在UTC日期前后2天内
+	struct tm cache[5];
+	bool cached[5] = {false, false, false, false, false};
 
-time_t Date::localTimeZoneOffset()
-{
-	return localTimeZone() * -3600;
-}
-
-int Date::localTimeZone()
-{
-	static int tz = Date(0).hour();
-	return tz;
-}
+	char buf[256];
+	for (size_t i = 0; i < count; ++i)
+	{
+		const Zone & zone = (NULL != zones[i]) ? *zones[i] : Zone::utc();
+		const Zone::Info info = zone.lookup(stamp);
+		const int64 local = seconds + info.offset;
+		const int64 shift = Calendar::floorDiv(local, 86400);
+		const int slot = static_cast<int>(shift + 2);
 
-bool Date::isLeapYear(int year)
-{
-	return (year % 4 == 0 && ((year % 400 == 0) || (year % 100 != 0)));
-}
+		struct tm tm;
+		if (slot >= 0 && slot < 5)
+		{
+			if (!cached[slot])
+			{
+				memset(&cache[slot], 0, sizeof(struct tm));
+				fillTm(cache[slot], days + shift, 0);
+				cached[slot] = true;
+			}
+			tm = cache[slot];
+			const int daySeconds = static_cast<int>(local - shift * 86400);
+			tm.tm_hour = daySeconds / 3600;
+			tm.tm_min = daySeconds / 60 % 60;
+			tm.tm_sec = daySeconds % 60;
+		}
+		else
+		{
+			memset(&tm, 0, sizeof(struct tm));
+			fillTm(tm, days + shift, static_cast<int>(local - shift * 86400));
+		}
+		fillTmZone(tm, info);
 
-int Date::yearMonthDays(int year, int month)
-{
-	switch (month)
-	{
-	case 1:
-	case 3:
-	case 5:
-	case 7:
-	case 8:
-	case 10:
-	case 12:
-		return 31;
-	case 4:
-	case 6:
-	case 9:
-	case 11:
-		return 30;
-	case 2:
-		//Need to consider a leap year in February
-		return isLeapYear(year) ? 29 : 28;
-	default:
-		return 0;
+		if (0 == strftime(buf, sizeof(buf), fmt, &tm))
+		{
+			buf[0] = '\0';
+		}
+		out[i].assign(buf);
 	}
 }
 
 Date::Date()
 {
 	_isUTC = false;
-	_set(time(NULL));
+	_zone = NULL;
+	_set(Clock::overridden() ? static_cast<time_t>(Calendar::floorDiv(Clock::now(), 1000000)) : time(NULL));
 }
 
 Date::Date(time_t stamp, bool utc)
 {
 	_isUTC = utc;
+	_zone = NULL;
+	_set(stamp);
+}
+
+Date::Date(time_t stamp, const Zone & zone)
+{
+	_isUTC = false;
+	_zone = &zone;
 	_set(stamp);
 }
 
 Date::Date(const Time &time)
 {
 	_isUTC = false;
+	_zone = NULL;
 	_set(time.stamp());
 }
 
 Date::Date(const Date &other)
 {
 	_isUTC = other._isUTC;
+	_zone = other._zone;
 	_tm = other._tm;
 }
 
+Date & Date::operator = (const Date &other)
+{
+	_isUTC = other._isUTC;
+	_zone = other._zone;
+	_tm = other._tm;
+	return *this;
+}
+
 Date::Date(int year, int month, int day, int hour, int minute, int second)
 {
 	_isUTC = false;
+	_zone = NULL;
 	_set(time(NULL));
 
 	_tm.tm_year = year - 1900;
@@ -344,6 +317,24 @@ Date::Date(int year, int month, int day, int hour, int minute, int second)
 	_update();
 }
 
+Date::Date(const Zone & zone, int year, int month, int day, int hour, int minute, int second)
+{
+	_isUTC = false;
+	_zone = &zone;
+	_set(time(NULL));
+
+	// 不沿用当前时刻的夏令时标志，重叠的时间总是取较早的时刻
+	_tm.tm_isdst = -1;
+	_tm.tm_year = year - 1900;
+	_tm.tm_mon = month - 1;
+	_tm.tm_mday = day;
+	_tm.tm_hour = hour;
+	_tm.tm_min = minute;
+	_tm.tm_sec = second;
+
+	_update();
+}
+
 Date::~Date()
 {
 }
@@ -358,6 +349,11 @@ Date Date::toUTC() const
 	return Date(stamp(), true);
 }
 
+Date Date::toZone(const Zone & zone) const
+{
+	return Date(stamp(), zone);
+}
+
 Time Date::toTime() const
 {
 	return Time(*this);
@@ -386,6 +382,13 @@ std::string Date::format(const char * fmt) const
 
 time_t Date::stamp() const
 {
+	if (NULL != _zone)
+	{
+		const int64 days = Date::daysFromCivil(year(), month(), 1) + _tm.tm_mday - 1;
+		return _zone->localToUTC(static_cast<time_t>(days * 86400
+			+ _tm.tm_hour * 3600 + _tm.tm_min * 60 + _tm.tm_sec), _tm.tm_isdst);
+	}
+
 #ifdef PLATFORM_WINDOWS
 	if (_tm.tm_year > 70) // > 1970
 	{
@@ -411,9 +414,27 @@ time_t Date::utcStamp() const
 	return stamp() - Date::localTimeZoneOffset();
 }
 
+int Date::isoWeekYear() const
+{
+	int weekYear = 0, weekNumber = 0, weekDay = 0;
+	isoWeekFromDays(daysFromCivil(year(), month(), day()), weekYear, weekNumber, weekDay);
+	return weekYear;
+}
+
+int Date::isoWeek() const
+{
+	int weekYear = 0, weekNumber = 0, weekDay = 0;
+	isoWeekFromDays(daysFromCivil(year(), month(), day()), weekYear, weekNumber, weekDay);
+	return weekNumber;
+}
+
 int Date::timeZone() const
 {
 #ifdef PLATFORM_WINDOWS
+	if (NULL != _zone)
+	{
+		return _zone->offset(stamp()) / 3600;
+	}
 	return _isUTC ? 0 : Date::localTimeZone();
 #else
 # if defined(__USE_BSD) || defined(__USE_MISC)
@@ -437,9 +458,7 @@ Date & Date::set(int year, int month, int day, int hour, int minute, int second)
 	_tm.tm_mon = (month > 0) ? month : 0;
 
 	day = day % 32;
-	_tm.tm_mon = (day > 1) ? day : 1;
-
-	_update();
+	_tm.tm_mday = (day > 1) ? day : 1;
 
 	hour = hour % 24;
 	_tm.tm_hour = (hour > 0) ? hour : 0;
@@ -450,6 +469,7 @@ Date & Date::set(int year, int month, int day, int hour, int minute, int second)
 	second = second % 60;
 	_tm.tm_sec = (second > 0) ? second : 0;
 
+	_update();
 
 	return *this;
 }
@@ -462,7 +482,7 @@ Date & Date::setDate(int year, int month, int day)
 	_tm.tm_mon = (month > 0) ? month : 0;
 
 	day = day % 32;
-	_tm.tm_mon = (day > 1) ? day : 1;
+	_tm.tm_mday = (day > 1) ? day : 1;
 
 	_update();
 	return *this;
@@ -529,8 +549,8 @@ Date & Date::zeroSet(Duration::Period period)
 		_tm.tm_sec = 0;
 		break;
 	case Duration::Week:
-		_set(toTime().zeroSet(period).stamp());
-		break;	
+		zeroSetWeek(1);
+		break;
 	case Duration::Month:
 		_tm.tm_mday = 1;
 		_tm.tm_hour = 0;
@@ -551,6 +571,15 @@ Date & Date::zeroSet(Duration::Period period)
 	return *this;
 }
 
+Date & Date::zeroSetWeek(int firstWeekDay)
+{
+	const int64 days = daysFromCivil(year(), month(), day());
+	const int64 start = weekStartDays(days, firstWeekDay);
+	int y = 0, m = 0, d = 0;
+	civilFromDays(start, y, m, d);
+	return set(y, m, d, 0, 0, 0);
+}
+
 Date & Date::add(int64 value, Duration::Period period)
 {
 	switch (period)
@@ -566,7 +595,7 @@ Date & Date::add(int64 value, Duration::Period period)
 		addMonth(int(value));
 		break;
 	case Duration::Year:
-		addMonth((int)value);
+		addYear(static_cast<int>(value));
 		break;
 	default:
 		break;
@@ -617,7 +646,7 @@ Date & Date::addMonth(int value)
 	return *this;
 }
 
-int64 Date::diff(const Date & other, Duration::Period period)
+int64 Date::diff(const Date & other, Duration::Period period) const
 {
 	switch (period)
 	{
@@ -658,27 +687,17 @@ int Date::getUTCFullYears() const
 	return year() - 1970;
 }
 
-bool Date::isLeapYear() const
-{
-	return Date::isLeapYear(year());
-}
-
-bool Date::isLastDayOfMonth() const
-{
-	return day() >= Date::yearMonthDays(year(), month());
-}
-
-Date Date::operator + (const Duration & duration)
+Date Date::operator + (const Duration & duration) const
 {
 	return clone().add(duration.value(), duration.period());
 }
 
-Date Date::operator - (const Duration & duration)
+Date Date::operator - (const Duration & duration) const
 {
 	return clone().add(-duration.value(), duration.period());
 }
 
-Duration Date::operator - (const Date & other)
+Duration Date::operator - (const Date & other) const
 {
 	return Duration(static_cast<int64>(stamp() - other.stamp()));
 }
@@ -693,7 +712,7 @@ Date & Date::operator -= (const Duration & duration)
 	return add(-duration.value(), duration.period());
 }
 
-bool Date::operator < (const Date & other)
+bool Date::operator < (const Date & other) const
 {
 	if (_tm.tm_year != other._tm.tm_year)
 	{
@@ -723,7 +742,7 @@ bool Date::operator < (const Date & other)
 	return _tm.tm_sec < other._tm.tm_sec;
 }
 
-bool Date::operator == (const Date & other)
+bool Date::operator == (const Date & other) const
 {
 	return (_tm.tm_year == other._tm.tm_year) &&
 			(_tm.tm_mon == other._tm.tm_mon) &&
@@ -733,8 +752,23 @@ bool Date::operator == (const Date & other)
 			(_tm.tm_sec == other._tm.tm_sec);
 }
 
+bool Date::operator != (const Date & other) const
+{
+	return !(*this == other);
+}
+
 void Date::_set(time_t stamp)
 {
+	if (NULL != _zone)
+	{
+		const Zone::Info info = _zone->lookup(stamp);
+		const int64 local = static_cast<int64>(stamp) + info.offset;
+		const int64 days = Calendar::floorDiv(local, 86400);
+		fillTm(_tm, days, static_cast<int>(local - days * 86400));
+		fillTmZone(_tm, info);
+		return;
+	}
+
 #ifdef PLATFORM_WINDOWS
 	if (stamp >= 0)
 	{
@@ -783,33 +817,19 @@ void Date::_update()
 
 Time::Time()
 {
+	if (Clock::overridden())
+	{
+		setMicroStamp(Clock::now());
+		return;
+	}
 	gettimeofday(&_tv, NULL);
 }
 
-Time::Time(time_t stamp)
-{
-	set(stamp);
-}
-
 Time::Time(const Date &date)
 {
 	set(date.stamp());
 }
 
-Time::Time(const Time &time)
-{
-	_tv = time._tv;
-}
-
-Time::~Time()
-{
-}
-
-Time Time::clone() const
-{
-	return Time(*this);
-}
-
 Date Time::toDate() const
 {
 	return Date(*this);
@@ -820,45 +840,9 @@ Date Time::utcDate() const
 	return Date(stamp(), true);
 }
 
-
-time_t Time::utcStamp() const
-{
-	return _tv.tv_sec - Date::localTimeZoneOffset();
-}
-
-Time & Time::set(time_t seconds, long microSeconds)
-{
-	_tv.tv_sec = static_cast<long>(seconds);
-	if (microSeconds < 0)
-	{
-		microSeconds = 0;
-	}
-	else if (microSeconds >= 1000000)
-	{
-		microSeconds = 1000000 - 1;
-	}
-	return *this;
-}
-
-Time & Time::setSeconds(time_t seconds)
+Date Time::toDate(const Zone & zone) const
 {
-	_tv.tv_sec = static_cast<long>(seconds);
-	return *this;
-}
-
-Time & Time::setMicroSeconds(long microSeconds)
-{
-	if (microSeconds < 0)
-	{
-		microSeconds = 0;
-	}
-	else if (microSeconds >= 1000000)
-	{
-		microSeconds = 1000000 - 1;
-	}
-
-	_tv.tv_usec = microSeconds;
-	return *this;
+	return Date(stamp(), zone);
 }
 
 Time & Time::zeroSet(Duration::Period period)
@@ -880,46 +864,12 @@ Time & Time::zeroSet(Duration::Period period)
 		_tv.tv_usec = 0;
 		break;
 	case Duration::Day:
-	case Duration::Week:
 	case Duration::Month:
 	case Duration::Year:
 		setSeconds(toDate().zeroSet(period).stamp());
 		break;
-	default:
-		break;
-	}
-
-	return *this;
-}
-
-Time & Time::add(int64 value, Duration::Period period)
-{
-	switch (period)
-	{
-	case Duration::MicroSecond:
-		addMicroSecond(long(value));
-		break;
-	case Duration::MilliSecond:
-		addMilliSecond(long(value));
-		break;
-	case Duration::Second:
-		addSecond(int(value));
-		break;
-	case Duration::Minute:
-		addMinute(int(value));
-		break;
-	case Duration::Hour:
-		addHour(int(value));
-		break;
-	case Duration::Day:
-		addDay(int(value));
-		break;
 	case Duration::Week:
-		addWeek(int(value));
-		break;
-	case Duration::Month:
-	case Duration::Year:
-		setSeconds(toDate().add(value, period).stamp());
+		zeroSetWeek(1);
 		break;
 	default:
 		break;
@@ -928,173 +878,8 @@ Time & Time::add(int64 value, Duration::Period period)
 	return *this;
 }
 
-Time & Time::add(const Duration & duration)
-{
-	return add(duration.value(), duration.period());
-}
-
-Time & Time::addWeek(int value)
-{
-	_tv.tv_sec += value * 3600 * 24 * 7;
-	return *this;
-}
-
-Time & Time::addDay(int value)
-{
-	_tv.tv_sec += value * 3600 * 24;
-	return *this;
-}
-
-Time & Time::addHour(int value)
+Time & Time::zeroSetWeek(int firstWeekDay)
 {
-	_tv.tv_sec += value * 3600;
-	return *this;
-}
-
-Time & Time::addMinute(int value)
-{
-	_tv.tv_sec += value * 60;
-	return *this;
+	return set(toDate().zeroSetWeek(firstWeekDay).stamp(), 0);
 }
-
-Time & Time::addSecond(long value)
-{
-	_tv.tv_sec += value;
-	return *this;
-}
-
-Time & Time::addMilliSecond(long value)
-{
-	_tv.tv_usec += value * 1000;
-	_tv.tv_sec += _tv.tv_usec / 1000000;
-	_tv.tv_usec %= 1000000;
-	if (_tv.tv_usec < 0)
-	{
-		_tv.tv_sec -= 1;
-		_tv.tv_usec += 1000000;
-	}
-	return *this;
-}
-
-Time & Time::addMicroSecond(long value)
-{
-	_tv.tv_usec += value;
-	_tv.tv_sec += _tv.tv_usec / 1000000;
-	_tv.tv_usec %= 1000000;
-	if (_tv.tv_usec < 0)
-	{
-		_tv.tv_sec -= 1;
-		_tv.tv_usec += 1000000;
-	}
-	return *this;
-}
-
-int64 Time::diff(const Time & other, Duration::Period period)
-{
-	switch (period)
-	{
-	case Duration::MicroSecond:
-		return static_cast<int64>(microStamp() - other.microStamp());
-	case Duration::MilliSecond:
-		return static_cast<int64>(milliStamp() - other.milliStamp());
-	case Duration::Second:
-		return static_cast<int64>(stamp() - other.stamp());
-	case Duration::Minute:
-		return static_cast<int64>(stamp() / 60 - other.stamp() / 60);
-	case Duration::Hour:
-		return static_cast<int64>(stamp() / 3600 - other.stamp() / 3600);
-	case Duration::Day:
-		return static_cast<int64>(getUTCFullDays() - other.getUTCFullDays());
-	case Duration::Week:
-		return static_cast<int64>(getUTCFullWeeks() - other.getUTCFullWeeks());
-	case Duration::Month:
-	case Duration::Year:
-		return toDate().diff(other.toDate(), period);
-	default:
-		return 0;
-	}
-}
-
-int64 Time::getUTCFullMicroSeconds() const
-{
-	return microStamp() + Date::localTimeZoneOffset() * 1000000;
-}
-
-int64 Time::getUTCFullMilliSeconds() const
-{
-	return milliStamp() + Date::localTimeZoneOffset() * 1000;
-}
-
-time_t Time::getUTCFullSeconds() const
-{
-	return seconds();
-}
-
-int Time::getUTCFullMinutes() const
-{
-	return static_cast<int>((utcStamp() / 60));
-}
-
-int Time::getUTCFullHours() const
-{
-	return static_cast<int>((utcStamp() / 3600));
-}
-
-int Time::getUTCFullDays() const
-{
-	return static_cast<int>((utcStamp() / 86400));
-}
-
-int Time::getUTCFullWeeks() const
-{
-	int days = getUTCFullDays() + 4;
-	int weeks = (days - 1) / 7;
-	int weekDay = days % 7;
-	if (weekDay < 0) {
-		weeks -= 1;
-	}
-	return weeks;
-}
-
-Time Time::operator + (const Duration & duration)
-{
-	return clone().add(duration.value(), duration.period());
-}
-
-Time Time::operator - (const Duration & duration)
-{
-	return clone().add(-duration.value(), duration.period());
-}
-
-Duration Time::operator - (const Time & other)
-{
-	return Duration(static_cast<int64>(stamp() - other.stamp()));
-}
-
-Time & Time::operator += (const Duration & duration)
-{
-	return add(duration.value(), duration.period());
-}
-
-Time & Time::operator -= (const Duration & duration)
-{
-	return add(-duration.value(), duration.period());
-}
-
-bool Time::operator < (const Time & other)
-{
-	if (_tv.tv_sec != other._tv.tv_sec)
-	{
-		return _tv.tv_sec < other._tv.tv_sec;
-	}
-
-	return _tv.tv_usec < other._tv.tv_usec;
-
-}
-
-bool Time::operator = (const Time & other)
-{
-	return (_tv.tv_sec == other._tv.tv_sec) && (_tv.tv_usec == other._tv.tv_usec);
-}
-
 } /* namespace ec */
@@ -11,6 +11,7 @@
 #include <time.h>
 #include <string>
 #include <cstdint>
+#include "calendar.h"
 
 #if (defined _WIN32) || (defined WIN32) || (defined _WIN64) || (defined WIN64)
 #define PLATFORM_WINDOWS
@@ -30,6 +31,7 @@ namespace ec
 class Time;
 class Date;
 class Duration;
+class Zone;
 
 /**
 * @brief 表示时间段
@@ -95,20 +97,20 @@ public:
 	/** @brief 获取值转换成某种类型后的值 */
 	int64 valueAs(Period period) const;
 
-	Duration operator + (const Duration &other);
-	Duration operator + (int64 value);
-	Duration operator - (const Duration &other);
-	Duration operator - (int64 value);
+	Duration operator + (const Duration &other) const;
+	Duration operator + (int64 value) const;
+	Duration operator - (const Duration &other) const;
+	Duration operator - (int64 value) const;
 	Duration & operator += (const Duration &other);
 	Duration & operator += (int64 value);
 	Duration & operator -= (const Duration &other);
 	Duration & operator -= (int64 value);
-	bool operator > (const Duration & other);
-	bool operator >= (const Duration & other);
-	bool operator == (const Duration & other);
-	bool operator != (const Duration & other);
-	bool operator < (const Duration & other);
-	bool operator <= (const Duration & other);
+	bool operator > (const Duration & other) const;
+	bool operator >= (const Duration & other) const;
+	bool operator == (const Duration & other) const;
+	bool operator != (const Duration & other) const;
+	bool operator < (const Duration & other) const;
+	bool operator <= (const Duration & other) const;
 private:
 	int64 _value;
 	Period _period;
@@ -125,13 +127,77 @@ public:
 	static int localTimeZone();
 	/** @brief 返回当前系统时区偏移，以秒为单位，比如UTC+8的时区为-28800 */
 	static time_t localTimeZoneOffset();
+	/**
+	 * @brief 系统时区在某一时刻的UTC偏移，以秒为单位，含夏令时和非整点时区，比如UTC+5:30为19800
+	 * @details 与localtime的结果一致，偏移在一小时内不变时每个线程按小时缓存 @see resetZoneCache
+	 */
+	static int localOffset(time_t stamp);
+	/**
+	 * @brief 系统时区的本地日历时间(按UTC编码的秒数)转换为时间戳
+	 * @details 与tm_isdst为-1的mktime一致，重叠的时间取较早的时刻，每个线程按本地小时缓存 @see resetZoneCache
+	 */
+	static time_t localToUTC(time_t local);
+	/**
+	 * @brief 使所有线程中localOffset和localToUTC的缓存失效
+	 * @details 缓存不会感知系统时区的变化，修改TZ并调用tzset()后需要调用，之后各线程在下次使用时重新计算
+	 */
+	static void resetZoneCache();
 	/** @brief 判断是否是闰年 */
-	static bool isLeapYear(int year);
-	/** @brief 某年某月一共有多少天 */
-	static int yearMonthDays(int year, int month);
+	static constexpr bool isLeapYear(int year)
+	{
+		return Calendar::isLeapYear(year);
+	}
+
+	/** @brief 某年某月一共有多少天，月份超出[1,12]时为0 */
+	static constexpr int yearMonthDays(int year, int month)
+	{
+		return Calendar::monthDays(year, month);
+	}
+
+	/** @brief 某年某月某日距离1970-01-01的天数，月份超出[1,12]时自动进位 */
+	static constexpr int64 daysFromCivil(int year, int month, int day)
+	{
+		return Calendar::daysFromCivil(year, month, day);
+	}
+
+	/** @brief 距离1970-01-01的天数对应的年月日 */
+	static void civilFromDays(int64 days, int & year, int & month, int & day)
+	{
+		const CivilDate civil = Calendar::civilFromDays(days);
+		year = civil.year;
+		month = civil.month;
+		day = civil.day;
+	}
+
+	/**
+	 * @brief 距离1970-01-01的天数对应的ISO 8601周日期
+	 * @param year ISO周年，年初或年末的几天可能属于相邻的年
+	 * @param week 周，[1,53]，包含星期四的周属于该年
+	 * @param weekDay 星期，[1,7]，1为星期一
+	 */
+	static void isoWeekFromDays(int64 days, int & year, int & week, int & weekDay);
+	/** @brief ISO 8601周日期距离1970-01-01的天数 @see isoWeekFromDays */
+	static int64 daysFromIsoWeek(int year, int week, int weekDay);
+	/**
+	 * @brief 距离1970-01-01的天数所在周的第一天
+	 * @param firstWeekDay 一周的第一天，[1,7]，1为星期一，7为星期日
+	 */
+	static int64 weekStartDays(int64 days, int firstWeekDay = 1);
+
+	/**
+	 * @brief 将同一时刻按多个时区格式化
+	 * @details 只计算一次UTC日期，每个时区仅叠加偏移，比逐个构造Date更高效
+	 * @param stamp 时间戳
+	 * @param zones 时区数组，为NULL的元素按UTC处理
+	 * @param count 时区个数
+	 * @param out 输出数组，长度不小于count
+	 * @param fmt 格式 @see format
+	 */
+	static void formatZones(time_t stamp, const Zone * const * zones, size_t count,
+		std::string * out, const char * fmt = "%Y-%m-%d %H:%M:%S");
 
 public:
-	/** @brief 以当前时间构造 */
+	/** @brief 以当前时间构造，安装了时钟时读取它 @see Clock */
 	Date();
 	/**
 	 * @brief 以时间戳(秒)构造
@@ -141,8 +207,15 @@ public:
 	Date(time_t stamp, bool utc = false);
 	/** @brief 以Time对象构造 */
 	Date(const Time &time);
+	/**
+	 * @brief 以时间戳(秒)构造指定时区的日历时间
+	 * @note 不复制时区，zone的生命周期必须长于Date对象，ZoneRegistry中的时区总是满足 @see ZoneRegistry
+	 */
+	Date(time_t stamp, const Zone & zone);
 	/** @brief 以Date对象复制 */
 	Date(const Date &other);
+	/** @brief 以Date对象赋值 */
+	Date & operator = (const Date &other);
 
 	/**
 	 * @brief 以指定时间构造
@@ -155,6 +228,11 @@ public:
 	 * @param second 秒，取值范围[0,60]，默认为0
 	 */
 	Date(int year, int month, int day, int hour = 0, int minute = 0, int second = 0);
+	/**
+	 * @brief 以指定时区的指定时间构造 @see Date(time_t, const Zone &)
+	 * @details 与当前时刻无关：重叠的时间取较早的时刻，跳过的时间按切换前的偏移计算 @see Zone::localToUTC
+	 */
+	Date(const Zone & zone, int year, int month, int day, int hour = 0, int minute = 0, int second = 0);
 
 	~Date();
 
@@ -162,6 +240,8 @@ public:
 	Date clone() const;
 	/** @brief 转换为UTC时间 */
 	Date toUTC() const;
+	/** @brief 转换为指定时区的时间 */
+	Date toZone(const Zone & zone) const;
 
 	/** @brief 转换为Time对象 */
 	Time toTime() const;
@@ -179,6 +259,9 @@ public:
 	 *     %M 分钟(00-59)
 	 *     %S 秒钟(00-59)
 	 *     %X标准时间字符串（如：23:01:59）
+	 *     %G ISO 8601周年 @see isoWeekYear
+	 *     %V ISO 8601周(01-53) @see isoWeek
+	 *     %u 星期(1-7)，1为星期一
 	 *     %% 百分号
 	 *
 	 * @return 如果发生错误返回空字符串
@@ -227,12 +310,28 @@ public:
 		return (_tm.tm_wday > 0) ? _tm.tm_wday : 7;
 	}
 
+	/** @brief ISO 8601周年，1月初或12月末的几天可能属于相邻的年 @see isoWeekFromDays */
+	int isoWeekYear() const;
+	/** @brief ISO 8601周，[1,53] */
+	int isoWeek() const;
+	/** @brief ISO 8601星期，[1,7]，1为星期一，与week()相同 */
+	inline int isoWeekDay() const
+	{
+		return week();
+	}
+
 	/** @brief 是否是UTC基准时间 */
 	inline bool isUTC() const
 	{
 		return _isUTC;
 	}
 
+	/** @brief 所在时区，为NULL时表示本地时区或UTC @see isUTC */
+	inline const Zone * zone() const
+	{
+		return _zone;
+	}
+
 	/** @brief 转换为时间戳 @note 按本地时间（时区）转换，比如在东8区(UTC+8)时1970-01-01 00:00:00为-28800 */
 	time_t stamp() const;
 	/** @brief 转换为UTC时间戳 @note 比如1970-01-01 00:00:00为0 */
@@ -271,6 +370,12 @@ public:
 	 *      为Second/MilliSecond/MicroSecond时无效果，
 	 */
 	Date & zeroSet(Duration::Period period);
+	/**
+	 * @brief 设置为所在周的开始
+	 * @param firstWeekDay 一周的第一天，[1,7]，1为星期一，7为星期日
+	 * @note zeroSet(Duration::Week)从星期一开始
+	 */
+	Date & zeroSetWeek(int firstWeekDay = 1);
 
 	/** @brief 加/减 一段时间 */
 	Date & add(int64 value, Duration::Period period);
@@ -296,7 +401,7 @@ public:
 	 *     为MicroSecond表示两者相差微秒数，Date的精度为秒，所以只是将相差秒数*1000000
 	 * @return 返回this - other的相应差值
 	 */
-	int64 diff(const Date & other, Duration::Period period = Duration::Second);
+	int64 diff(const Date & other, Duration::Period period = Duration::Second) const;
 
 	/** @brief 获取一年中的天，[1,366] */
 	int getYearDay() const;
@@ -310,13 +415,15 @@ public:
 	/** @brief 是否是一月的最后一天 */
 	bool isLastDayOfMonth() const;
 
-	Date operator + (const Duration & duration);
-	Date operator - (const Duration & duration);
-	Duration operator - (const Date & other);
+	Date operator + (const Duration & duration) const;
+	Date operator - (const Duration & duration) const;
+	Duration operator - (const Date & other) const;
 	Date & operator += (const Duration & duration);
 	Date & operator -= (const Duration & duration);
-	bool operator < (const Date & other);
-	bool operator == (const Date & other);
+	/** @brief 按年月日时分秒比较，不考虑时区 */
+	bool operator < (const Date & other) const;
+	bool operator == (const Date & other) const;
+	bool operator != (const Date & other) const;
 
 protected:
 	void _set(time_t stamp);
@@ -325,6 +432,7 @@ protected:
 private:
 	struct tm _tm;
 	bool _isUTC;
+	const Zone * _zone;
 };
 
 /**
@@ -335,14 +443,15 @@ private:
 class Time
 {
 public:
+	/** @brief 以当前时间构造，安装了时钟时读取它 @see Clock */
 	Time();
 	/** @brief 以时间戳构造 */
 	Time(time_t stamp);
 	/** @brief 以Date对象构造 */
 	Time(const Date &date);
-	/** @brief 以Time对象复制 */
-	Time(const Time &time);
-	~Time();
+	/** @brief 以Time对象复制，与赋值和析构都是平凡的，Time可以按字节复制 */
+	Time(const Time &time) = default;
+	~Time() = default;
 
 	/** @brief 克隆当前对象 */
 	Time clone() const;
@@ -351,6 +460,8 @@ public:
 	Date toDate() const;
 	/** @brief 转换成UTC基准时间的Date对象 */
 	Date utcDate() const;
+	/** @brief 转换成指定时区的Date对象 */
+	Date toDate(const Zone & zone) const;
 
 	/** @brief 获取秒数，等同于时间戳 */
 	inline time_t seconds() const
@@ -361,7 +472,7 @@ public:
 	/** @brief 获取微秒数, [0,1000000) @details 微秒部分小于一秒 */
 	inline long microSeconds() const
 	{
-		return _tv.tv_sec;
+		return _tv.tv_usec;
 	}
 
 	/** @brief 获取毫秒时间戳 */
@@ -391,6 +502,8 @@ public:
 	Time & setSeconds(time_t seconds);
 	/** @brief 获取微秒数, [0,1000000) */
 	Time & setMicroSeconds(long microSeconds);
+	/** @brief 以微秒时间戳设置 @see microStamp */
+	Time & setMicroStamp(int64 microStamp);
 
 	/** 
 	 * @brief 设置为某个时间的开始
@@ -406,6 +519,8 @@ public:
 	 *	   为MicroSecond时置零为一微秒的开始
 	 */
 	Time & zeroSet(Duration::Period period);
+	/** @brief 设置为本地日历所在周的开始 @see Date::zeroSetWeek */
+	Time & zeroSetWeek(int firstWeekDay = 1);
 
 	/** @brief 加/减 一段时间 */
 	Time & add(int64 value, Duration::Period period = Duration::Period::MilliSecond);
@@ -441,7 +556,7 @@ public:
 	 *     为MicroSecond表示两者相差微秒数
 	 * @return 返回this - other的相应差值
 	 */
-	int64 diff(const Time & other, Duration::Period period = Duration::Second);
+	int64 diff(const Time & other, Duration::Period period = Duration::Second) const;
 
 	/** @brief 距离1970-01-01 00:00:00的微秒数 */
 	int64 getUTCFullMicroSeconds() const;
@@ -458,13 +573,18 @@ public:
 	/** @brief 距离1970-01-01 00:00:00的周数 @note 从0开始，1970-01-01 00:00:00为第0周星期4 */
 	int getUTCFullWeeks() const;
 
-	Time operator + (const Duration & duration);
-	Time operator - (const Duration & duration);
-	Duration operator - (const Time & other);
+	Time operator + (const Duration & duration) const;
+	Time operator - (const Duration & duration) const;
+	Duration operator - (const Time & other) const;
 	Time & operator += (const Duration & duration);
 	Time & operator -= (const Duration & duration);
-	bool operator < (const Time & other);
-	bool operator = (const Time & other);
+	bool operator < (const Time & other) const;
+	bool operator > (const Time & other) const;
+	bool operator <= (const Time & other) const;
+	bool operator >= (const Time & other) const;
+	bool operator == (const Time & other) const;
+	bool operator != (const Time & other) const;
+	Time & operator = (const Time & other) = default;
 
 private:
 	struct timeval _tv;
@@ -472,4 +592,13 @@ private:
 
 } /* namespace ec */
 
+/**
+ * 定义EC_DATE_HEADER_ONLY时，Duration、Time的存取与算术、比较等开销很小的函数在头文件中定义为inline，
+ * 调用处可以内联，其余仍在date.cpp中 @see date_inl.h
+ */
+#ifdef EC_DATE_HEADER_ONLY
+#define EC_DATE_INLINE inline
+#include "date_inl.h"
+#endif // EC_DATE_HEADER_ONLY
+
 #endif /* INCLUDE_EC_DATE_H_ */
@@ -0,0 +1,540 @@
+﻿/*
+ * date_inl.h
+ *
+ *  Created on: 2026年10月19日
+ *      Author: havesnag
+ */
+
+/**
+ * @file
+ * @brief Duration的全部、Time的存取与算术、比较等开销很小的函数的定义
+ * @details
+ *     定义了EC_DATE_HEADER_ONLY时由date.h包含，函数为inline，调用处可以内联；
+ *     否则由date.cpp包含，编译进库中。两种方式的库与使用者必须以相同的EC_DATE_HEADER_ONLY编译。
+ *     时区、格式化、Date的换算等较重的函数总是在date.cpp中。
+ * @note 不要直接包含这个文件
+ */
+
+#ifndef INCLUDE_EC_DATE_INL_H_
+#define INCLUDE_EC_DATE_INL_H_
+
+#include "date.h"
+
+namespace ec
+{
+
+EC_DATE_INLINE Duration::Duration(int64 value, Period period)
+{
+	_value = value;
+	_period = period;
+}
+
+EC_DATE_INLINE Duration::Duration(const Duration &duration)
+{
+	_value = duration._value;
+	_period = duration._period;
+}
+
+EC_DATE_INLINE Duration::~Duration()
+{
+}
+
+EC_DATE_INLINE Duration Duration::clone() const
+{
+	return Duration(*this);
+}
+
+EC_DATE_INLINE Duration & Duration::set(int64 value, Period period)
+{
+	_value = value;
+	_period = period;
+	return *this;
+}
+
+EC_DATE_INLINE Duration & Duration::setValue(int64 value)
+{
+	_value = value;
+	return *this;
+}
+
+EC_DATE_INLINE Duration & Duration::setPeriod(Period period)
+{
+	_period = period;
+	return *this;
+}
+
+EC_DATE_INLINE Duration & Duration::rase()
+{
+	switch (_period)
+	{
+	case Duration::MicroSecond:
+		_period = Duration::MilliSecond;
+		_value /= 1000;
+		break;
+	case Duration::MilliSecond:
+		_period = Duration::Second;
+		_value /= 1000;
+		break;
+	case Duration::Second:
+		_period = Duration::Minute;
+		_value /= 60;
+		break;
+	case Duration::Minute:
+		_period = Duration::Hour;
+		_value /= 60;
+		break;
+	case Duration::Hour:
+		_period = Duration::Day;
+		_value /= 24;
+		break;
+	case Duration::Day:
+		_period = Duration::Week;
+		_value /= 7;
+		break;
+	case Duration::Week:
+		_period = Duration::Month;
+		_value /= 4;
+		break;
+	case Duration::Month:
+		_period = Duration::Year;
+		_value /= 12;
+		break;
+	default:
+		break;
+	}
+	return *this;
+}
+
+EC_DATE_INLINE Duration & Duration::down()
+{
+	switch (_period)
+	{
+	case Duration::MilliSecond:
+		_period = Duration::MicroSecond;
+		_value *= 1000;
+		break;
+	case Duration::Second:
+		_period = Duration::MilliSecond;
+		_value *= 1000;
+		break;
+	case Duration::Minute:
+		_period = Duration::Second;
+		_value *= 60;
+		break;
+	case Duration::Hour:
+		_period = Duration::Minute;
+		_value *= 60;
+		break;
+	case Duration::Day:
+		_period = Duration::Hour;
+		_value *= 24;
+		break;
+	case Duration::Week:
+		_period = Duration::Day;
+		_value *= 7;
+		break;
+	case Duration::Month:
+		_period = Duration::Week;
+		_value *= 4;
+		break;
+	case Duration::Year:
+		_period = Duration::Month;
+		_value *= 12;
+		break;
+	default:
+		break;
+	}
+	return *this;
+}
+
+EC_DATE_INLINE Duration & Duration::as(Period period)
+{
+	if (_period < period)
+	{
+		for (; _period < period; )
+		{
+			rase();
+		}
+	}
+	else if (_period > period)
+	{
+		for (; _period > period; )
+		{
+			down();
+		}
+	}
+	return *this;
+}
+
+EC_DATE_INLINE int64 Duration::valueAs(Period period) const
+{
+	return clone().as(period).value();
+}
+
+EC_DATE_INLINE Duration Duration::operator + (const Duration &other) const
+{
+	return Duration(_value + other.valueAs(_period), _period);
+}
+
+EC_DATE_INLINE Duration Duration::operator + (int64 value) const
+{
+	return Duration(_value + value, _period);
+}
+
+EC_DATE_INLINE Duration Duration::operator - (const Duration &other) const
+{
+	return Duration(_value - other.valueAs(_period), _period);
+}
+
+EC_DATE_INLINE Duration Duration::operator - (int64 value) const
+{
+	return Duration(_value - value, _period);
+}
+
+EC_DATE_INLINE Duration & Duration::operator += (const Duration &other)
+{
+	_value += other.valueAs(_period);
+	return *this;
+}
+
+EC_DATE_INLINE Duration & Duration::operator += (int64 value)
+{
+	_value += value;
+	return *this;
+}
+
+EC_DATE_INLINE Duration & Duration::operator -= (const Duration &other)
+{
+	_value -= other.valueAs(_period);
+	return *this;
+}
+
+EC_DATE_INLINE Duration & Duration::operator -= (int64 value)
+{
+	_value -= value;
+	return *this;
+}
+
+EC_DATE_INLINE bool Duration::operator > (const Duration & other) const
+{
+	return (_period == other._period) ? (_value > other._value) : (_period > other._period);
+}
+
+EC_DATE_INLINE bool Duration::operator >= (const Duration & other) const
+{
+	return (_period == other._period) ? (_value >= other._value) : (_period > other._period);
+}
+
+EC_DATE_INLINE bool Duration::operator == (const Duration & other) const
+{
+	return (_period == other._period) && (_value == other._value);
+}
+
+EC_DATE_INLINE bool Duration::operator != (const Duration & other) const
+{
+	return (_period != other._period) || (_value != other._value);
+}
+
+EC_DATE_INLINE bool Duration::operator < (const Duration & other) const
+{
+	return (_period == other._period) ? (_value < other._value) : (_period < other._period);
+}
+
+EC_DATE_INLINE bool Duration::operator <= (const Duration & other) const
+{
+	return (_period == other._period) ? (_value <= other._value) : (_period < other._period);
+}
+
+EC_DATE_INLINE bool Date::isLeapYear() const
+{
+	return Date::isLeapYear(year());
+}
+
+EC_DATE_INLINE bool Date::isLastDayOfMonth() const
+{
+	return day() >= Date::yearMonthDays(year(), month());
+}
+
+EC_DATE_INLINE Time::Time(time_t stamp)
+{
+	set(stamp);
+}
+
+EC_DATE_INLINE Time Time::clone() const
+{
+	return Time(*this);
+}
+
+
+EC_DATE_INLINE time_t Time::utcStamp() const
+{
+	return _tv.tv_sec - Date::localTimeZoneOffset();
+}
+
+EC_DATE_INLINE Time & Time::set(time_t seconds, long microSeconds)
+{
+	_tv.tv_sec = static_cast<long>(seconds);
+	if (microSeconds < 0)
+	{
+		microSeconds = 0;
+	}
+	else if (microSeconds >= 1000000)
+	{
+		microSeconds = 1000000 - 1;
+	}
+
+	_tv.tv_usec = microSeconds;
+	return *this;
+}
+
+EC_DATE_INLINE Time & Time::setSeconds(time_t seconds)
+{
+	_tv.tv_sec = static_cast<long>(seconds);
+	return *this;
+}
+
+EC_DATE_INLINE Time & Time::setMicroSeconds(long microSeconds)
+{
+	if (microSeconds < 0)
+	{
+		microSeconds = 0;
+	}
+	else if (microSeconds >= 1000000)
+	{
+		microSeconds = 1000000 - 1;
+	}
+
+	_tv.tv_usec = microSeconds;
+	return *this;
+}
+
+EC_DATE_INLINE Time & Time::setMicroStamp(int64 microStamp)
+{
+	const int64 seconds = (microStamp >= 0) ? (microStamp / 1000000) : ((microStamp - 999999) / 1000000);
+	_tv.tv_sec = static_cast<long>(seconds);
+	_tv.tv_usec = static_cast<long>(microStamp - seconds * 1000000);
+	return *this;
+}
+
+EC_DATE_INLINE Time & Time::add(int64 value, Duration::Period period)
+{
+	switch (period)
+	{
+	case Duration::MicroSecond:
+		addMicroSecond(long(value));
+		break;
+	case Duration::MilliSecond:
+		addMilliSecond(long(value));
+		break;
+	case Duration::Second:
+		addSecond(int(value));
+		break;
+	case Duration::Minute:
+		addMinute(int(value));
+		break;
+	case Duration::Hour:
+		addHour(int(value));
+		break;
+	case Duration::Day:
+		addDay(int(value));
+		break;
+	case Duration::Week:
+		addWeek(int(value));
+		break;
+	case Duration::Month:
+	case Duration::Year:
+		setSeconds(toDate().add(value, period).stamp());
+		break;
+	default:
+		break;
+	}
+
+	return *this;
+}
+
+EC_DATE_INLINE Time & Time::add(const Duration & duration)
+{
+	return add(duration.value(), duration.period());
+}
+
+EC_DATE_INLINE Time & Time::addWeek(int value)
+{
+	_tv.tv_sec += value * 3600 * 24 * 7;
+	return *this;
+}
+
+EC_DATE_INLINE Time & Time::addDay(int value)
+{
+	_tv.tv_sec += value * 3600 * 24;
+	return *this;
+}
+
+EC_DATE_INLINE Time & Time::addHour(int value)
+{
+	_tv.tv_sec += value * 3600;
+	return *this;
+}
+
+EC_DATE_INLINE Time & Time::addMinute(int value)
+{
+	_tv.tv_sec += value * 60;
+	return *this;
+}
+
+EC_DATE_INLINE Time & Time::addSecond(long value)
+{
+	_tv.tv_sec += value;
+	return *this;
+}
+
+EC_DATE_INLINE Time & Time::addMilliSecond(long value)
+{
+	_tv.tv_usec += value * 1000;
+	_tv.tv_sec += _tv.tv_usec / 1000000;
+	_tv.tv_usec %= 1000000;
+	if (_tv.tv_usec < 0)
+	{
+		_tv.tv_sec -= 1;
+		_tv.tv_usec += 1000000;
+	}
+	return *this;
+}
+
+EC_DATE_INLINE Time & Time::addMicroSecond(long value)
+{
+	_tv.tv_usec += value;
+	_tv.tv_sec += _tv.tv_usec / 1000000;
+	_tv.tv_usec %= 1000000;
+	if (_tv.tv_usec < 0)
+	{
+		_tv.tv_sec -= 1;
+		_tv.tv_usec += 1000000;
+	}
+	return *this;
+}
+
+EC_DATE_INLINE int64 Time::diff(const Time & other, Duration::Period period) const
+{
+	switch (period)
+	{
+	case Duration::MicroSecond:
+		return static_cast<int64>(microStamp() - other.microStamp());
+	case Duration::MilliSecond:
+		return static_cast<int64>(milliStamp() - other.milliStamp());
+	case Duration::Second:
+		return static_cast<int64>(stamp() - other.stamp());
+	case Duration::Minute:
+		return static_cast<int64>(stamp() / 60 - other.stamp() / 60);
+	case Duration::Hour:
+		return static_cast<int64>(stamp() / 3600 - other.stamp() / 3600);
+	case Duration::Day:
+		return static_cast<int64>(getUTCFullDays() - other.getUTCFullDays());
+	case Duration::Week:
+		return static_cast<int64>(getUTCFullWeeks() - other.getUTCFullWeeks());
+	case Duration::Month:
+	case Duration::Year:
+		return toDate().diff(other.toDate(), period);
+	default:
+		return 0;
+	}
+}
+
+EC_DATE_INLINE int64 Time::getUTCFullMicroSeconds() const
+{
+	return microStamp() + Date::localTimeZoneOffset() * 1000000;
+}
+
+EC_DATE_INLINE int64 Time::getUTCFullMilliSeconds() const
+{
+	return milliStamp() + Date::localTimeZoneOffset() * 1000;
+}
+
+EC_DATE_INLINE time_t Time::getUTCFullSeconds() const
+{
+	return seconds();
+}
+
+EC_DATE_INLINE int Time::getUTCFullMinutes() const
+{
+	return static_cast<int>((utcStamp() / 60));
+}
+
+EC_DATE_INLINE int Time::getUTCFullHours() const
+{
+	return static_cast<int>((utcStamp() / 3600));
+}
+
+EC_DATE_INLINE int Time::getUTCFullDays() const
+{
+	return static_cast<int>((utcStamp() / 86400));
+}
+
+EC_DATE_INLINE int Time::getUTCFullWeeks() const
+{
+	int days = getUTCFullDays() + 4;
+	int weeks = (days - 1) / 7;
+	int weekDay = days % 7;
+	if (weekDay < 0) {
+		weeks -= 1;
+	}
+	return weeks;
+}
+
+EC_DATE_INLINE Time Time::operator + (const Duration & duration) const
+{
+	return clone().add(duration.value(), duration.period());
+}
+
+EC_DATE_INLINE Time Time::operator - (const Duration & duration) const
+{
+	return clone().add(-duration.value(), duration.period());
+}
+
+EC_DATE_INLINE Duration Time::operator - (const Time & other) const
+{
+	return Duration(static_cast<int64>(stamp() - other.stamp()));
+}
+
+EC_DATE_INLINE Time & Time::operator += (const Duration & duration)
+{
+	return add(duration.value(), duration.period());
+}
+
+EC_DATE_INLINE Time & Time::operator -= (const Duration & duration)
+{
+	return add(-duration.value(), duration.period());
+}
+
+EC_DATE_INLINE bool Time::operator < (const Time & other) const
+{
+	return (_tv.tv_sec != other._tv.tv_sec) ? (_tv.tv_sec < other._tv.tv_sec) : (_tv.tv_usec < other._tv.tv_usec);
+}
+
+EC_DATE_INLINE bool Time::operator > (const Time & other) const
+{
+	return other < *this;
+}
+
+EC_DATE_INLINE bool Time::operator <= (const Time & other) const
+{
+	return !(other < *this);
+}
+
+EC_DATE_INLINE bool Time::operator >= (const Time & other) const
+{
+	return !(*this < other);
+}
+
+EC_DATE_INLINE bool Time::operator == (const Time & other) const
+{
+	return (_tv.tv_sec == other._tv.tv_sec) && (_tv.tv_usec == other._tv.tv_usec);
+}
+
+EC_DATE_INLINE bool Time::operator != (const Time & other) const
+{
+	return !(*this == other);
+}
+
+} /* namespace ec */
+
+#endif /* INCLUDE_EC_DATE_INL_H_ */
@@ -0,0 +1,649 @@
+﻿/*
+ * eventlog.cpp
+ *
+ *  Created on: 2026年10月19日
+ *      Author: havesnag
+ */
+
+#include "eventlog.h"
+
+#ifndef PLATFORM_WINDOWS
+
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <limits>
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+using namespace std;
+
+namespace ec
+{
+
+namespace
+{
+
+typedef std::vector<std::pair<int64, uint64_t> > Index;
+
+const char segmentMagic[8] = {'E', 'C', 'E', 'V', 'T', 'L', 'O', 'G'};
+const char indexMagic[8] = {'E', 'C', 'E', 'V', 'T', 'I', 'D', 'X'};
+const uint32_t segmentVersion = 1;
+
+/** @brief 段文件头 */
+struct SegmentHeader
+{
+	char magic[8];
+	uint32_t version;
+	uint32_t indexInterval;
+	int64 start;
+	int64 indexPeriod;
+};
+
+/** @brief 记录头，之后为按8字节对齐的数据 */
+struct RecordHeader
+{
+	int64 stamp;
+	uint32_t size;
+	/** @brief 校验值，区分记录与写了一半的索引 */
+	uint32_t check;
+};
+
+/** @brief 索引项 */
+struct IndexEntry
+{
+	int64 stamp;
+	uint64_t offset;
+};
+
+/** @brief 段文件尾，写入索引后才有 */
+struct SegmentTrailer
+{
+	uint64_t indexOffset;
+	uint64_t indexCount;
+	uint64_t recordCount;
+	char magic[8];
+};
+
+inline uint32_t recordCheck(int64 stamp, uint32_t size)
+{
+	return static_cast<uint32_t>(stamp) ^ static_cast<uint32_t>(static_cast<uint64_t>(stamp) >> 32) ^ size ^ 0x9E3779B9u;
+}
+
+inline uint64_t align8(uint64_t size)
+{
+	return (size + 7) & ~static_cast<uint64_t>(7);
+}
+
+std::string segmentPath(const std::string & dir, int64 start)
+{
+	char name[32];
+	snprintf(name, sizeof(name), "%020lld.log", static_cast<long long>(start));
+	return dir + "/" + name;
+}
+
+/** @brief 是否需要为第count条记录记录索引 */
+inline bool needIndex(const Index & index, uint64_t count, int64 stamp, uint32_t interval, int64 period)
+{
+	return index.empty() || (interval > 0 && 0 == count % interval)
+		|| (period > 0 && Calendar::floorDiv(stamp, period) != Calendar::floorDiv(index.back().first, period));
+}
+
+/** @brief 文件尾，未写入索引时返回NULL */
+const SegmentTrailer * trailer(const char * data, size_t size)
+{
+	if (size < sizeof(SegmentHeader) + sizeof(SegmentTrailer) || 0 != size % 8)
+	{
+		return NULL;
+	}
+
+	const SegmentTrailer * tail = reinterpret_cast<const SegmentTrailer *>(data + size - sizeof(SegmentTrailer));
+	if (0 != memcmp(tail->magic, indexMagic, sizeof(indexMagic)) || tail->indexOffset < sizeof(SegmentHeader)
+		|| 0 != tail->indexOffset % 8 || tail->indexOffset > size
+		|| (size - sizeof(SegmentTrailer) - tail->indexOffset) != tail->indexCount * sizeof(IndexEntry))
+	{
+		return NULL;
+	}
+	return tail;
+}
+
+/**
+ * @brief 从offset开始扫描记录，补充索引
+ * @details 遇到不完整或时间倒退的记录时停止，返回有效记录的结束位置
+ */
+uint64_t scan(const char * data, uint64_t limit, uint64_t offset, uint64_t & count, Index & index)
+{
+	const SegmentHeader * head = reinterpret_cast<const SegmentHeader *>(data);
+	int64 last = head->start;
+	if (count > 0)
+	{
+		// 上一条记录的时间戳由索引中的最后一项开始扫描得到
+		for (uint64_t pos = index.back().second; pos < offset; )
+		{
+			const RecordHeader * record = reinterpret_cast<const RecordHeader *>(data + pos);
+			last = record->stamp;
+			pos += sizeof(RecordHeader) + align8(record->size);
+		}
+	}
+
+	while (limit - offset >= sizeof(RecordHeader))
+	{
+		const RecordHeader * record = reinterpret_cast<const RecordHeader *>(data + offset);
+		if (record->check != recordCheck(record->stamp, record->size) || record->stamp < last
+			|| (limit - offset - sizeof(RecordHeader)) < align8(record->size))
+		{
+			break;
+		}
+
+		if (needIndex(index, count, record->stamp, head->indexInterval, head->indexPeriod))
+		{
+			index.push_back(std::make_pair(record->stamp, offset));
+		}
+
+		last = record->stamp;
+		offset += sizeof(RecordHeader) + align8(record->size);
+		++count;
+	}
+	return offset;
+}
+
+/** @brief 映射整个文件 */
+const char * mapFile(const std::string & path, size_t & size)
+{
+	const int fd = ::open(path.c_str(), O_RDONLY);
+	if (fd < 0)
+	{
+		return NULL;
+	}
+
+	struct stat info;
+	void * addr = MAP_FAILED;
+	if (0 == fstat(fd, &info) && static_cast<size_t>(info.st_size) >= sizeof(SegmentHeader))
+	{
+		size = static_cast<size_t>(info.st_size);
+		addr = mmap(NULL, size, PROT_READ, MAP_SHARED, fd, 0);
+	}
+	::close(fd);
+
+	if (MAP_FAILED == addr)
+	{
+		return NULL;
+	}
+
+	const SegmentHeader * head = static_cast<const SegmentHeader *>(addr);
+	if (0 != memcmp(head->magic, segmentMagic, sizeof(segmentMagic)) || segmentVersion != head->version)
+	{
+		munmap(addr, size);
+		return NULL;
+	}
+	return static_cast<const char *>(addr);
+}
+
+/**
+ * @brief 读取段中的记录和索引，未写入索引时扫描重建
+ * @return 记录的结束位置，文件无效时返回0
+ */
+uint64_t loadSegment(const std::string & path, uint64_t & count, Index & index, int64 & last)
+{
+	size_t size = 0;
+	const char * data = mapFile(path, size);
+	if (NULL == data)
+	{
+		return 0;
+	}
+
+	count = 0;
+	index.clear();
+	const SegmentTrailer * tail = trailer(data, size);
+	const uint64_t end = scan(data, (NULL != tail) ? tail->indexOffset : size, sizeof(SegmentHeader), count, index);
+
+	last = reinterpret_cast<const SegmentHeader *>(data)->start;
+	for (uint64_t pos = index.empty() ? end : index.back().second; pos < end; )
+	{
+		const RecordHeader * record = reinterpret_cast<const RecordHeader *>(data + pos);
+		last = record->stamp;
+		pos += sizeof(RecordHeader) + align8(record->size);
+	}
+
+	munmap(const_cast<char *>(data), size);
+	return end;
+}
+
+/** @brief 列出目录中的段，按开始时间排序 */
+bool listSegments(const std::string & dir, std::vector<std::pair<int64, std::string> > & segments)
+{
+	DIR * handle = opendir(dir.c_str());
+	if (NULL == handle)
+	{
+		return false;
+	}
+
+	struct dirent * item = NULL;
+	while (NULL != (item = readdir(handle)))
+	{
+		const size_t length = strlen(item->d_name);
+		if (24 != length || 0 != strcmp(item->d_name + 20, ".log"))
+		{
+			continue;
+		}
+
+		char * end = NULL;
+		const long long start = strtoll(item->d_name, &end, 10);
+		if (end == item->d_name + 20)
+		{
+			segments.push_back(std::make_pair(static_cast<int64>(start), dir + "/" + item->d_name));
+		}
+	}
+	closedir(handle);
+
+	std::sort(segments.begin(), segments.end());
+	return true;
+}
+
+/** @brief 在记录之后写入索引和文件尾 */
+bool writeIndex(FILE * file, const Index & index, uint64_t offset, uint64_t count)
+{
+	bool ok = true;
+	for (size_t i = 0; ok && i < index.size(); ++i)
+	{
+		IndexEntry entry;
+		entry.stamp = index[i].first;
+		entry.offset = index[i].second;
+		ok = (1 == fwrite(&entry, sizeof(IndexEntry), 1, file));
+	}
+
+	SegmentTrailer tail;
+	tail.indexOffset = offset;
+	tail.indexCount = index.size();
+	tail.recordCount = count;
+	memcpy(tail.magic, indexMagic, sizeof(indexMagic));
+	return ok && 1 == fwrite(&tail, sizeof(SegmentTrailer), 1, file);
+}
+
+} /* namespace */
+
+EventLogWriter::EventLogWriter()
+{
+	_rollPeriod = 0;
+	_indexPeriod = 0;
+	_indexInterval = 0;
+	_file = NULL;
+	_segmentEnd = 0;
+	_lastStamp = 0;
+	_offset = 0;
+	_recordCount = 0;
+}
+
+EventLogWriter::~EventLogWriter()
+{
+	close();
+}
+
+bool EventLogWriter::open(const std::string & dir, const Duration & rollPeriod,
+	uint32_t indexInterval, const Duration & indexPeriod)
+{
+	close();
+
+	if (0 != mkdir(dir.c_str(), 0755) && EEXIST != errno)
+	{
+		return false;
+	}
+
+	std::vector<std::pair<int64, std::string> > segments;
+	if (!listSegments(dir, segments))
+	{
+		return false;
+	}
+
+	_dir = dir;
+	_rollPeriod = std::max<int64>(rollPeriod.valueAs(Duration::MicroSecond), 1);
+	_indexPeriod = std::max<int64>(indexPeriod.valueAs(Duration::MicroSecond), 0);
+	_indexInterval = indexInterval;
+	_lastStamp = (segments.empty()) ? std::numeric_limits<int64>::min() : segments.back().first;
+
+	// 补写异常退出时未写入的索引，最后一个段留给之后的追加
+	for (size_t i = 0; i + 1 < segments.size(); ++i)
+	{
+		size_t size = 0;
+		const char * data = mapFile(segments[i].second, size);
+		if (NULL == data)
+		{
+			continue;
+		}
+		const bool sealed = (NULL != trailer(data, size));
+		munmap(const_cast<char *>(data), size);
+
+		if (!sealed)
+		{
+			uint64_t count = 0;
+			int64 last = 0;
+			Index index;
+			const uint64_t end = loadSegment(segments[i].second, count, index, last);
+			FILE * file = (0 == truncate(segments[i].second.c_str(), static_cast<off_t>(end)))
+				? fopen(segments[i].second.c_str(), "ab") : NULL;
+			if (NULL != file)
+			{
+				writeIndex(file, index, end, count);
+				fclose(file);
+			}
+		}
+	}
+
+	if (!segments.empty() && !_roll(segments.back().first))
+	{
+		close();
+		return false;
+	}
+	return true;
+}
+
+void EventLogWriter::close()
+{
+	_seal();
+	_dir.clear();
+	_lastStamp = 0;
+}
+
+bool EventLogWriter::append(int64 stamp, const void * data, size_t size)
+{
+	if (!isOpen() || stamp < _lastStamp || size > 0xFFFFFFFFu)
+	{
+		return false;
+	}
+
+	if ((NULL == _file || stamp >= _segmentEnd) && !_roll(stamp))
+	{
+		return false;
+	}
+
+	RecordHeader record;
+	record.stamp = stamp;
+	record.size = static_cast<uint32_t>(size);
+	record.check = recordCheck(stamp, record.size);
+
+	const char padding[8] = {0};
+	const size_t paddingSize = static_cast<size_t>(align8(size) - size);
+	if (1 != fwrite(&record, sizeof(RecordHeader), 1, _file)
+		|| (size > 0 && 1 != fwrite(data, size, 1, _file))
+		|| (paddingSize > 0 && 1 != fwrite(padding, paddingSize, 1, _file)))
+	{
+		return false;
+	}
+
+	if (needIndex(_index, _recordCount, stamp, _indexInterval, _indexPeriod))
+	{
+		_index.push_back(std::make_pair(stamp, _offset));
+	}
+
+	_offset += sizeof(RecordHeader) + align8(size);
+	++_recordCount;
+	_lastStamp = stamp;
+	return true;
+}
+
+bool EventLogWriter::append(const Time & time, const void * data, size_t size)
+{
+	return append(time.microStamp(), data, size);
+}
+
+bool EventLogWriter::flush()
+{
+	return (NULL == _file) || (0 == fflush(_file));
+}
+
+bool EventLogWriter::_roll(int64 stamp)
+{
+	_seal();
+
+	const int64 start = Calendar::floorDiv(stamp, _rollPeriod) * _rollPeriod;
+	const std::string path = segmentPath(_dir, start);
+
+	// 段已存在时(比如重启)去掉索引后继续追加
+	struct stat info;
+	if (0 == stat(path.c_str(), &info))
+	{
+		int64 last = 0;
+		_offset = loadSegment(path, _recordCount, _index, last);
+		if (0 == _offset || 0 != truncate(path.c_str(), static_cast<off_t>(_offset)))
+		{
+			return false;
+		}
+		_lastStamp = std::max(_lastStamp, last);
+		_file = fopen(path.c_str(), "ab");
+	}
+	else
+	{
+		_file = fopen(path.c_str(), "wb");
+		SegmentHeader head;
+		memset(&head, 0, sizeof(SegmentHeader));
+		memcpy(head.magic, segmentMagic, sizeof(segmentMagic));
+		head.version = segmentVersion;
+		head.indexInterval = _indexInterval;
+		head.start = start;
+		head.indexPeriod = _indexPeriod;
+		if (NULL != _file && 1 != fwrite(&head, sizeof(SegmentHeader), 1, _file))
+		{
+			fclose(_file);
+			_file = NULL;
+		}
+		_offset = sizeof(SegmentHeader);
+		_recordCount = 0;
+		_index.clear();
+	}
+
+	_segmentEnd = start + _rollPeriod;
+	return NULL != _file;
+}
+
+bool EventLogWriter::_seal()
+{
+	if (NULL == _file)
+	{
+		return true;
+	}
+
+	const bool ok = writeIndex(_file, _index, _offset, _recordCount);
+	fclose(_file);
+	_file = NULL;
+	_index.clear();
+	_recordCount = 0;
+	return ok;
+}
+
+
+EventLogReader::EventLogReader()
+{
+}
+
+EventLogReader::~EventLogReader()
+{
+	close();
+}
+
+bool EventLogReader::open(const std::string & dir)
+{
+	close();
+	_dir = dir;
+	return refresh();
+}
+
+bool EventLogReader::refresh()
+{
+	std::vector<std::pair<int64, std::string> > segments;
+	if (!listSegments(_dir, segments))
+	{
+		return false;
+	}
+
+	// 保留已映射的段
+	std::vector<Segment> merged(segments.size());
+	size_t j = 0;
+	for (size_t i = 0; i < segments.size(); ++i)
+	{
+		while (j < _segments.size() && _segments[j].start < segments[i].first)
+		{
+			_unmap(_segments[j++]);
+		}
+
+		Segment & segment = merged[i];
+		if (j < _segments.size() && _segments[j].start == segments[i].first)
+		{
+			segment = _segments[j++];
+			continue;
+		}
+
+		segment.path = segments[i].second;
+		segment.start = segments[i].first;
+		segment.data = NULL;
+		segment.size = 0;
+		segment.end = 0;
+		segment.count = 0;
+		segment.sealed = false;
+	}
+
+	for (; j < _segments.size(); ++j)
+	{
+		_unmap(_segments[j]);
+	}
+	_segments.swap(merged);
+	return true;
+}
+
+void EventLogReader::close()
+{
+	for (size_t i = 0; i < _segments.size(); ++i)
+	{
+		_unmap(_segments[i]);
+	}
+	_segments.clear();
+}
+
+size_t EventLogReader::query(int64 from, int64 to, const Visitor & visitor)
+{
+	// 段的开始时间有序，第一个可能包含from的段为开始时间不大于from的最后一个段
+	size_t i = 0;
+	while (i + 1 < _segments.size() && _segments[i + 1].start <= from)
+	{
+		++i;
+	}
+
+	size_t count = 0;
+	bool stop = false;
+	for (; !stop && i < _segments.size() && _segments[i].start < to; ++i)
+	{
+		if (_map(_segments[i]))
+		{
+			count += _query(_segments[i], from, to, visitor, stop);
+		}
+	}
+	return count;
+}
+
+size_t EventLogReader::query(const Time & from, const Time & to, const Visitor & visitor)
+{
+	return query(from.microStamp(), to.microStamp(), visitor);
+}
+
+bool EventLogReader::_map(Segment & segment)
+{
+	if (segment.sealed)
+	{
+		return true;
+	}
+
+	// 未写入索引的段可能仍在追加，文件变长时重新映射并继续扫描
+	struct stat info;
+	if (0 != stat(segment.path.c_str(), &info))
+	{
+		return NULL != segment.data;
+	}
+	if (NULL != segment.data && static_cast<size_t>(info.st_size) == segment.size)
+	{
+		return true;
+	}
+
+	size_t size = 0;
+	const char * data = mapFile(segment.path, size);
+	if (NULL == data)
+	{
+		return NULL != segment.data;
+	}
+
+	if (NULL != segment.data)
+	{
+		munmap(const_cast<char *>(segment.data), segment.size);
+	}
+	segment.data = data;
+	segment.size = size;
+
+	const SegmentTrailer * tail = trailer(data, size);
+	if (NULL != tail)
+	{
+		const IndexEntry * entries = reinterpret_cast<const IndexEntry *>(data + tail->indexOffset);
+		segment.index.resize(static_cast<size_t>(tail->indexCount));
+		for (size_t i = 0; i < segment.index.size(); ++i)
+		{
+			segment.index[i] = std::make_pair(entries[i].stamp, entries[i].offset);
+		}
+		segment.end = tail->indexOffset;
+		segment.count = tail->recordCount;
+		segment.sealed = true;
+	}
+	else
+	{
+		segment.end = scan(data, size, (0 == segment.end) ? sizeof(SegmentHeader) : segment.end,
+			segment.count, segment.index);
+	}
+	return true;
+}
+
+void EventLogReader::_unmap(Segment & segment)
+{
+	if (NULL != segment.data)
+	{
+		munmap(const_cast<char *>(segment.data), segment.size);
+		segment.data = NULL;
+	}
+}
+
+size_t EventLogReader::_query(Segment & segment, int64 from, int64 to, const Visitor & visitor, bool & stop)
+{
+	// 从最后一个小于from的索引项开始扫描，相等的时间戳可能跨越索引项
+	Index::const_iterator it = std::lower_bound(segment.index.begin(), segment.index.end(),
+		std::make_pair(from, static_cast<uint64_t>(0)));
+	uint64_t offset = (segment.index.begin() == it) ? sizeof(SegmentHeader) : (it - 1)->second;
+
+	size_t count = 0;
+	while (offset < segment.end)
+	{
+		const RecordHeader * header = reinterpret_cast<const RecordHeader *>(segment.data + offset);
+		if (header->stamp >= to)
+		{
+			stop = true;
+			break;
+		}
+
+		if (header->stamp >= from)
+		{
+			EventRecord record;
+			record.stamp = header->stamp;
+			record.data = segment.data + offset + sizeof(RecordHeader);
+			record.size = header->size;
+			++count;
+			if (!visitor(record))
+			{
+				stop = true;
+				break;
+			}
+		}
+		offset += sizeof(RecordHeader) + align8(header->size);
+	}
+	return count;
+}
+
+} /* namespace ec */
+
+#endif // PLATFORM_WINDOWS
@@ -0,0 +1,175 @@
+﻿/*
+ * eventlog.h
+ *
+ *  Created on: 2026年10月19日
+ *      Author: havesnag
+ */
+
+#ifndef INCLUDE_EC_EVENTLOG_H_
+#define INCLUDE_EC_EVENTLOG_H_
+
+#include "date.h"
+#include <stdio.h>
+#include <functional>
+#include <utility>
+#include <vector>
+
+namespace ec
+{
+
+/**
+ * @brief 事件日志中的一条记录
+ * @details data直接指向映射的文件，EventLogReader关闭前有效
+ */
+struct EventRecord
+{
+	/** @brief 微秒时间戳 */
+	int64 stamp;
+	/** @brief 数据 */
+	const char * data;
+	/** @brief 数据长度 */
+	uint32_t size;
+
+	/** @brief 记录的时间 */
+	inline Time time() const
+	{
+		return Time(static_cast<time_t>(0)).setMicroStamp(stamp);
+	}
+};
+
+/**
+ * @brief 按时间排序、只追加的事件日志
+ * @details
+ *     日志目录中按固定时长切分为多个段文件，文件名为段开始的微秒时间戳，
+ *     段的开始时间按时长对齐，比如时长为1小时时每个段为整点开始的一小时。
+ *     每条记录为8字节的微秒时间戳、4字节的长度、4字节的校验和按8字节对齐的数据。
+ *     段文件末尾为稀疏索引，每indexInterval条记录或者时间跨越一个indexPeriod时记录一项，
+ *     查询时二分查找索引，再从索引位置顺序扫描，只访问需要的页。
+ *     段在切换或关闭时写入索引，未写入索引的段(正在写或异常退出)读取时扫描一遍重建索引。
+ * @note 仅支持POSIX系统
+ * @see EventLogReader
+ */
+class EventLogWriter
+{
+public:
+	EventLogWriter();
+	~EventLogWriter();
+
+	/**
+	 * @brief 打开日志目录，目录不存在时创建
+	 * @param dir 日志目录
+	 * @param rollPeriod 段的时长，按微秒换算为固定长度，月按4周计算
+	 * @param indexInterval 每多少条记录记录一项索引
+	 * @param indexPeriod 时间跨越多长时记录一项索引，比如每分钟一项，与Time::zeroSet(Minute)对齐
+	 * @details 目录中未写入索引的段会被补写索引，最后一个段截掉不完整的记录后继续追加
+	 */
+	bool open(const std::string & dir,
+		const Duration & rollPeriod = Duration(1, Duration::Hour),
+		uint32_t indexInterval = 256,
+		const Duration & indexPeriod = Duration(1, Duration::Minute));
+	/** @brief 写入索引并关闭 */
+	void close();
+
+	/** @brief 是否已打开 */
+	inline bool isOpen() const
+	{
+		return !_dir.empty();
+	}
+
+	/**
+	 * @brief 追加一条记录
+	 * @param stamp 微秒时间戳，不能小于上一条记录的时间戳
+	 * @return 时间倒退或写入失败时返回false
+	 */
+	bool append(int64 stamp, const void * data, size_t size);
+	/** @brief 追加一条记录 @see append(int64, const void *, size_t) */
+	bool append(const Time & time, const void * data, size_t size);
+	/** @brief 将缓冲的记录写入文件，之后对读取者可见 */
+	bool flush();
+
+private:
+	EventLogWriter(const EventLogWriter &);
+	EventLogWriter & operator = (const EventLogWriter &);
+
+	bool _roll(int64 stamp);
+	bool _seal();
+
+	std::string _dir;
+	int64 _rollPeriod;
+	int64 _indexPeriod;
+	uint32_t _indexInterval;
+
+	FILE * _file;
+	int64 _segmentEnd;
+	int64 _lastStamp;
+	uint64_t _offset;
+	uint64_t _recordCount;
+	std::vector<std::pair<int64, uint64_t> > _index;
+};
+
+/**
+ * @brief 事件日志的读取
+ * @details 段文件按需映射到内存，返回的记录直接指向映射的内存
+ * @note 仅支持POSIX系统
+ * @see EventLogWriter
+ */
+class EventLogReader
+{
+public:
+	/** @brief 访问记录的回调，返回false时停止 */
+	typedef std::function<bool (const EventRecord &)> Visitor;
+
+public:
+	EventLogReader();
+	~EventLogReader();
+
+	/** @brief 打开日志目录 */
+	bool open(const std::string & dir);
+	/** @brief 重新列出目录中的段，用于读取打开之后新增的段 */
+	bool refresh();
+	/** @brief 解除所有映射 */
+	void close();
+
+	/** @brief 段的个数 */
+	inline size_t segmentCount() const
+	{
+		return _segments.size();
+	}
+
+	/**
+	 * @brief 按时间顺序访问[from, to)之间的记录
+	 * @return 访问的记录数
+	 */
+	size_t query(int64 from, int64 to, const Visitor & visitor);
+	/** @brief 按时间顺序访问[from, to)之间的记录 */
+	size_t query(const Time & from, const Time & to, const Visitor & visitor);
+
+private:
+	struct Segment
+	{
+		std::string path;
+		int64 start;
+		const char * data;
+		size_t size;
+		/** @brief 记录的结束位置 */
+		uint64_t end;
+		uint64_t count;
+		bool sealed;
+		/** @brief 索引，未写入索引的段为扫描得到的索引 */
+		std::vector<std::pair<int64, uint64_t> > index;
+	};
+
+	EventLogReader(const EventLogReader &);
+	EventLogReader & operator = (const EventLogReader &);
+
+	bool _map(Segment & segment);
+	void _unmap(Segment & segment);
+	size_t _query(Segment & segment, int64 from, int64 to, const Visitor & visitor, bool & stop);
+
+	std::string _dir;
+	std::vector<Segment> _segments;
+};
+
+} /* namespace ec */
+
+#endif /* INCLUDE_EC_EVENTLOG_H_ */
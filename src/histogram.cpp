@@ -0,0 +1,347 @@
+﻿/*
+ * histogram.cpp
+ *
+ *  Created on: 2026年10月19日
+ *      Author: havesnag
+ */
+
+#include "histogram.h"
+#include "codec.h"
+#include <stdint.h>
+#include <math.h>
+#include <algorithm>
+#include <vector>
+using namespace std;
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif // _MSC_VER
+
+namespace ec
+{
+
+namespace
+{
+
+const uint64_t formatVersion = 1;
+
+/** @brief 前导0的个数，bits不能为0 */
+inline unsigned leadingZeros(uint64_t bits)
+{
+#if defined(__GNUC__)
+	return static_cast<unsigned>(__builtin_clzll(bits));
+#elif defined(_MSC_VER) && defined(_M_X64)
+	unsigned long index = 0;
+	_BitScanReverse64(&index, bits);
+	return 63 - index;
+#else
+	unsigned count = 0;
+	while (0 == (bits & (static_cast<uint64_t>(1) << (63 - count))))
+	{
+		++count;
+	}
+	return count;
+#endif
+}
+
+/** @brief 原子地取较小值 */
+inline void storeMin(std::atomic<int64> & target, int64 value)
+{
+	int64 current = target.load(std::memory_order_relaxed);
+	while (value < current && !target.compare_exchange_weak(current, value, std::memory_order_relaxed))
+	{
+	}
+}
+
+/** @brief 原子地取较大值 */
+inline void storeMax(std::atomic<int64> & target, int64 value)
+{
+	int64 current = target.load(std::memory_order_relaxed);
+	while (value > current && !target.compare_exchange_weak(current, value, std::memory_order_relaxed))
+	{
+	}
+}
+
+} /* namespace */
+
+Histogram::Histogram(const Duration & lowest, const Duration & highest, int digits)
+	: _total(0), _min(INT64_MAX), _max(0)
+{
+	_init(lowest.valueAs(Duration::MicroSecond), highest.valueAs(Duration::MicroSecond), digits);
+}
+
+Histogram::~Histogram()
+{
+}
+
+void Histogram::record(int64 value, int64 count)
+{
+	value = std::min(std::max<int64>(value, 0), _highest);
+	const size_t index = std::min(_index(value), _length - 1);
+	_counts[index].fetch_add(count, std::memory_order_relaxed);
+	_total.fetch_add(count, std::memory_order_relaxed);
+	storeMin(_min, value);
+	storeMax(_max, value);
+}
+
+void Histogram::record(const Duration & duration)
+{
+	record(duration.valueAs(Duration::MicroSecond));
+}
+
+void Histogram::merge(const Histogram & other)
+{
+	if (0 == other.count())
+	{
+		return;
+	}
+
+	const bool same = (_unit == other._unit && _highest == other._highest && _digits == other._digits);
+	for (size_t i = 0; i < other._length; ++i)
+	{
+		const int64 count = other._counts[i].load(std::memory_order_relaxed);
+		if (0 == count)
+		{
+			continue;
+		}
+
+		if (same)
+		{
+			_counts[i].fetch_add(count, std::memory_order_relaxed);
+			_total.fetch_add(count, std::memory_order_relaxed);
+		}
+		else
+		{
+			record(other._lowest(i) + other._width(i) / 2, count);
+		}
+	}
+
+	storeMin(_min, std::min(other._min.load(std::memory_order_relaxed), _highest));
+	storeMax(_max, std::min(other._max.load(std::memory_order_relaxed), _highest));
+}
+
+void Histogram::reset()
+{
+	for (size_t i = 0; i < _length; ++i)
+	{
+		_counts[i].store(0, std::memory_order_relaxed);
+	}
+	_total.store(0);
+	_min.store(INT64_MAX);
+	_max.store(0);
+}
+
+Duration Histogram::min() const
+{
+	return Duration((count() > 0) ? _min.load(std::memory_order_relaxed) : 0, Duration::MicroSecond);
+}
+
+Duration Histogram::max() const
+{
+	return Duration(_max.load(std::memory_order_relaxed), Duration::MicroSecond);
+}
+
+double Histogram::mean() const
+{
+	const int64 total = count();
+	if (0 == total)
+	{
+		return 0;
+	}
+
+	double sum = 0;
+	for (size_t i = 0; i < _length; ++i)
+	{
+		const int64 count = _counts[i].load(std::memory_order_relaxed);
+		if (0 != count)
+		{
+			sum += static_cast<double>(count) * static_cast<double>(_lowest(i) + _width(i) / 2);
+		}
+	}
+	return sum / static_cast<double>(total);
+}
+
+Duration Histogram::percentile(double percent) const
+{
+	const int64 total = count();
+	if (0 == total)
+	{
+		return Duration(0, Duration::MicroSecond);
+	}
+
+	const double ratio = std::min(std::max(percent, 0.0), 100.0) / 100;
+	const int64 target = std::max<int64>(static_cast<int64>(ceil(ratio * static_cast<double>(total))), 1);
+	const int64 largest = _max.load(std::memory_order_relaxed);
+
+	int64 cumulative = 0;
+	for (size_t i = 0; i < _length; ++i)
+	{
+		cumulative += _counts[i].load(std::memory_order_relaxed);
+		if (cumulative >= target)
+		{
+			return Duration(std::min(_lowest(i) + _width(i) - 1, largest), Duration::MicroSecond);
+		}
+	}
+	return Duration(largest, Duration::MicroSecond);
+}
+
+void Histogram::encode(Encoder & out) const
+{
+	size_t used = _length;
+	while (used > 0 && 0 == _counts[used - 1].load(std::memory_order_relaxed))
+	{
+		--used;
+	}
+
+	out.putVarint(formatVersion)
+		.putVarint(static_cast<uint64_t>(_unit))
+		.putVarint(static_cast<uint64_t>(_highest))
+		.putVarint(static_cast<uint64_t>(_digits))
+		.putVarint(static_cast<uint64_t>(min().value()))
+		.putVarint(static_cast<uint64_t>(max().value()))
+		.putVarint(used);
+
+	for (size_t i = 0; i < used; )
+	{
+		const int64 count = _counts[i].load(std::memory_order_relaxed);
+		if (0 != count)
+		{
+			out.putSignedVarint(count);
+			++i;
+			continue;
+		}
+
+		size_t zeros = 0;
+		while (i < used && 0 == _counts[i].load(std::memory_order_relaxed))
+		{
+			++zeros;
+			++i;
+		}
+		out.putSignedVarint(-static_cast<int64>(zeros));
+	}
+}
+
+bool Histogram::decode(Decoder & in)
+{
+	Decoder reader = in;
+	uint64_t version = 0, unit = 0, highest = 0, digits = 0, smallest = 0, largest = 0, used = 0;
+	if (!reader.getVarint(version) || formatVersion != version
+		|| !reader.getVarint(unit) || !reader.getVarint(highest) || !reader.getVarint(digits)
+		|| !reader.getVarint(smallest) || !reader.getVarint(largest) || !reader.getVarint(used)
+		|| unit < 1 || unit > static_cast<uint64_t>(INT64_MAX) || highest > static_cast<uint64_t>(INT64_MAX)
+		|| digits < 1 || digits > 5)
+	{
+		return false;
+	}
+
+	// 先按编码的配置确认长度，再替换当前内容
+	const Histogram layout(Duration(static_cast<int64>(unit), Duration::MicroSecond),
+		Duration(static_cast<int64>(highest), Duration::MicroSecond), static_cast<int>(digits));
+	if (used > layout._length || static_cast<int64>(highest) != layout._highest)
+	{
+		return false;
+	}
+
+	std::vector<int64> counts(static_cast<size_t>(used), 0);
+	int64 total = 0;
+	for (size_t i = 0; i < counts.size(); )
+	{
+		int64 value = 0;
+		if (!reader.getSignedVarint(value) || value < -static_cast<int64>(counts.size() - i))
+		{
+			return false;
+		}
+
+		if (value >= 0)
+		{
+			counts[i++] = value;
+			total += value;
+		}
+		else
+		{
+			i += static_cast<size_t>(-value);
+		}
+	}
+
+	_init(static_cast<int64>(unit), static_cast<int64>(highest), static_cast<int>(digits));
+	for (size_t i = 0; i < counts.size(); ++i)
+	{
+		_counts[i].store(counts[i], std::memory_order_relaxed);
+	}
+	_total.store(total);
+	_min.store((total > 0) ? static_cast<int64>(smallest) : INT64_MAX);
+	_max.store(static_cast<int64>(largest));
+
+	in = reader;
+	return true;
+}
+
+void Histogram::_init(int64 lowest, int64 highest, int digits)
+{
+	_unit = std::max<int64>(lowest, 1);
+	_highest = std::max(highest, _unit * 2);
+	_digits = std::min(std::max(digits, 1), 5);
+
+	// 子桶数为不小于2 * 10^digits的2的幂，保证相对误差不超过10^-digits
+	int64 largest = 2;
+	for (int i = 0; i < _digits; ++i)
+	{
+		largest *= 10;
+	}
+	const unsigned subMagnitude = 64 - leadingZeros(static_cast<uint64_t>(largest - 1));
+	_unitMagnitude = std::min(63 - leadingZeros(static_cast<uint64_t>(_unit)), 61 - subMagnitude);
+	_halfMagnitude = subMagnitude - 1;
+	_halfCount = static_cast<int64>(1) << _halfMagnitude;
+	_subBucketMask = ((_halfCount << 1) - 1) << _unitMagnitude;
+
+	// 每段的范围翻倍，直到覆盖最大值
+	int64 smallest = (_halfCount << 1) << _unitMagnitude;
+	size_t buckets = 1;
+	while (smallest <= _highest)
+	{
+		++buckets;
+		if (smallest > INT64_MAX / 2)
+		{
+			break;
+		}
+		smallest <<= 1;
+	}
+
+	_length = (buckets + 1) * static_cast<size_t>(_halfCount);
+	_counts.reset(new std::atomic<int64>[_length]);
+	for (size_t i = 0; i < _length; ++i)
+	{
+		_counts[i].store(0, std::memory_order_relaxed);
+	}
+	_total.store(0);
+	_min.store(INT64_MAX);
+	_max.store(0);
+}
+
+size_t Histogram::_index(int64 value) const
+{
+	const unsigned bucket = 64 - leadingZeros(static_cast<uint64_t>(value | _subBucketMask))
+		- (_unitMagnitude + _halfMagnitude + 1);
+	const int64 sub = value >> (bucket + _unitMagnitude);
+	return (static_cast<size_t>(bucket + 1) << _halfMagnitude) + static_cast<size_t>(sub - _halfCount);
+}
+
+int64 Histogram::_lowest(size_t index) const
+{
+	int bucket = static_cast<int>(index >> _halfMagnitude) - 1;
+	int64 sub = static_cast<int64>(index & static_cast<size_t>(_halfCount - 1)) + _halfCount;
+	if (bucket < 0)
+	{
+		sub -= _halfCount;
+		bucket = 0;
+	}
+	return sub << (bucket + static_cast<int>(_unitMagnitude));
+}
+
+int64 Histogram::_width(size_t index) const
+{
+	const int bucket = std::max(static_cast<int>(index >> _halfMagnitude) - 1, 0);
+	return static_cast<int64>(1) << (bucket + static_cast<int>(_unitMagnitude));
+}
+
+} /* namespace ec */
@@ -0,0 +1,114 @@
+﻿/*
+ * histogram.h
+ *
+ *  Created on: 2026年10月19日
+ *      Author: havesnag
+ */
+
+#ifndef INCLUDE_EC_HISTOGRAM_H_
+#define INCLUDE_EC_HISTOGRAM_H_
+
+#include "date.h"
+#include <stddef.h>
+#include <atomic>
+#include <memory>
+
+namespace ec
+{
+
+class Encoder;
+class Decoder;
+
+/**
+ * @brief 时间段的直方图，按HDR Histogram的对数-线性方式分桶
+ * @details
+ *     数值以微秒为单位，按2的幂分为若干段，每段再线性分为相同个数的子桶，
+ *     任意数值的相对误差不超过10^-digits，内存在构造时固定。
+ *     计数为原子变量，记录为O(1)的无锁操作；也可以每个线程一个实例，需要时merge合并。
+ */
+class Histogram
+{
+public:
+	/**
+	 * @brief 构造
+	 * @param lowest 可区分的最小值，小于它的值与0在同一个桶
+	 * @param highest 可记录的最大值，更大的值按最大值记录
+	 * @param digits 有效数字位数，[1,5]
+	 */
+	Histogram(const Duration & lowest = Duration(1, Duration::MicroSecond),
+		const Duration & highest = Duration(1, Duration::Hour), int digits = 3);
+	~Histogram();
+
+	/** @brief 记录一个微秒数，负数按0记录 */
+	void record(int64 value, int64 count = 1);
+	/** @brief 记录一个时间段 */
+	void record(const Duration & duration);
+
+	/** @brief 将other的计数合并进来，两者的配置不同时按other每个桶的中间值重新记录 */
+	void merge(const Histogram & other);
+	/** @brief 清空计数 */
+	void reset();
+
+	/** @brief 记录的总个数 */
+	inline int64 count() const
+	{
+		return _total.load(std::memory_order_relaxed);
+	}
+
+	/** @brief 记录的最小值，没有记录时为0 */
+	Duration min() const;
+	/** @brief 记录的最大值，没有记录时为0 */
+	Duration max() const;
+	/** @brief 平均值，按各桶的中间值计算，微秒 */
+	double mean() const;
+
+	/**
+	 * @brief 百分位数
+	 * @param percent [0,100]，比如99.9
+	 * @return 该百分位所在桶的上界，不超过最大值，以微秒表示
+	 */
+	Duration percentile(double percent) const;
+
+	/** @brief 桶的个数 */
+	inline size_t bucketCount() const
+	{
+		return _length;
+	}
+
+	/** @brief 编码，只保存非0的计数，连续的0记为一个负数 */
+	void encode(Encoder & out) const;
+	/**
+	 * @brief 解码，替换当前的配置和计数
+	 * @note 不能与record同时调用
+	 * @return 数据不足或格式错误时返回false且不改变当前内容
+	 */
+	bool decode(Decoder & in);
+
+private:
+	Histogram(const Histogram &);
+	Histogram & operator = (const Histogram &);
+
+	void _init(int64 lowest, int64 highest, int digits);
+	size_t _index(int64 value) const;
+	/** @brief 桶的下界 */
+	int64 _lowest(size_t index) const;
+	/** @brief 桶的宽度 */
+	int64 _width(size_t index) const;
+
+	int64 _unit;
+	int64 _highest;
+	int _digits;
+	unsigned _unitMagnitude;
+	unsigned _halfMagnitude;
+	int64 _halfCount;
+	int64 _subBucketMask;
+	size_t _length;
+	std::unique_ptr<std::atomic<int64>[]> _counts;
+	std::atomic<int64> _total;
+	std::atomic<int64> _min;
+	std::atomic<int64> _max;
+};
+
+} /* namespace ec */
+
+#endif /* INCLUDE_EC_HISTOGRAM_H_ */
@@ -0,0 +1,97 @@
+﻿/*
+ * hybridclock.cpp
+ *
+ *  Created on: 2026年10月19日
+ *      Author: havesnag
+ */
+
+#include "hybridclock.h"
+#include <algorithm>
+
+namespace ec
+{
+
+namespace
+{
+
+/** @brief 物理时间的上限，48位 */
+const int64 physicalMax = (static_cast<int64>(1) << (64 - HybridClock::LogicalBits - 1)) - 1;
+
+inline int64 clampPhysical(int64 physical)
+{
+	return std::min(std::max<int64>(physical, 0), physicalMax);
+}
+
+} /* namespace */
+
+Time HybridClock::toTime(int64 stamp)
+{
+	Time time(0);
+	time.setMicroStamp(physical(stamp) * 1000);
+	return time;
+}
+
+int64 HybridClock::fromTime(const Time & time)
+{
+	return pack(clampPhysical(time.milliStamp()), 0);
+}
+
+HybridClock::HybridClock(const Duration & maxDrift, const Source & source)
+{
+	_maxDrift = std::max<int64>(maxDrift.valueAs(Duration::MilliSecond), 0);
+	_source = source;
+	_state.store(0);
+	_rejected.store(0);
+}
+
+int64 HybridClock::now()
+{
+	return now(_physical());
+}
+
+int64 HybridClock::now(int64 physical)
+{
+	return _advance(pack(clampPhysical(physical), 0));
+}
+
+int64 HybridClock::update(int64 remote)
+{
+	return update(remote, _physical());
+}
+
+int64 HybridClock::update(int64 remote, int64 physical)
+{
+	physical = clampPhysical(physical);
+	if (remote < 0 || HybridClock::physical(remote) - physical > _maxDrift)
+	{
+		_rejected.fetch_add(1, std::memory_order_relaxed);
+		return Invalid;
+	}
+
+	// 对方的时间戳也要严格超过，与本地物理时间取较大的一个作为下限
+	return _advance(std::max(pack(physical, 0), remote + 1));
+}
+
+int64 HybridClock::drift() const
+{
+	return std::max<int64>(physical(last()) - clampPhysical(_physical()), 0);
+}
+
+int64 HybridClock::_physical() const
+{
+	return _source ? _source() : Time().milliStamp();
+}
+
+int64 HybridClock::_advance(int64 floor)
+{
+	// 上次 + 1在计数满时自然进位到物理部分
+	int64 state = _state.load(std::memory_order_relaxed);
+	int64 next = std::max(floor, state + 1);
+	while (!_state.compare_exchange_weak(state, next, std::memory_order_acq_rel, std::memory_order_relaxed))
+	{
+		next = std::max(floor, state + 1);
+	}
+	return next;
+}
+
+} /* namespace ec */
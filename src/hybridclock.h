@@ -0,0 +1,127 @@
+﻿/*
+ * hybridclock.h
+ *
+ *  Created on: 2026年10月19日
+ *      Author: havesnag
+ */
+
+#ifndef INCLUDE_EC_HYBRIDCLOCK_H_
+#define INCLUDE_EC_HYBRIDCLOCK_H_
+
+#include "date.h"
+#include <stdint.h>
+#include <atomic>
+#include <functional>
+
+namespace ec
+{
+
+/**
+ * @brief 混合逻辑时钟(HLC)
+ * @details
+ *     时间戳为64位：高48位为物理时间(毫秒时间戳，同Time::milliStamp()，最高位为0，可表示到公元6400年)，低16位为逻辑计数，
+ *     按整数比较即为因果顺序。同一个时钟产生的时间戳严格递增，收到的时间戳之后产生的时间戳都比它大，
+ *     物理时钟回拨时物理部分保持不变，只增加计数。
+ *
+ *     状态只有一个64位原子变量，本地事件和收到消息都是一次CAS循环，不加锁。
+ *     规则合并为取最大值：本地事件取max(物理时间 << 16, 上次 + 1)，收到消息再与对方 + 1取最大值，
+ *     计数满65535后进位到物理部分。
+ *
+ *     收到的时间戳超前本地物理时钟maxDrift以上时认为对方(或本地)时钟异常，拒绝而不更新，以免把时钟推向未来。
+ * @note 物理时钟可以注入，便于测试
+ */
+class HybridClock
+{
+public:
+	/** @brief 物理时钟，返回毫秒时间戳 */
+	typedef std::function<int64 ()> Source;
+
+	/** @brief 被拒绝的时间戳 */
+	static const int64 Invalid = INT64_MIN;
+	/** @brief 逻辑计数的位数 */
+	static const int LogicalBits = 16;
+	/** @brief 逻辑计数的掩码 */
+	static const int64 LogicalMask = (static_cast<int64>(1) << LogicalBits) - 1;
+
+	/** @brief 由物理时间和逻辑计数组成时间戳 */
+	static inline int64 pack(int64 physical, int64 logical)
+	{
+		return (physical << LogicalBits) | (logical & LogicalMask);
+	}
+
+	/** @brief 时间戳的物理时间，毫秒 */
+	static inline int64 physical(int64 stamp)
+	{
+		return stamp >> LogicalBits;
+	}
+
+	/** @brief 时间戳的逻辑计数 */
+	static inline int64 logical(int64 stamp)
+	{
+		return stamp & LogicalMask;
+	}
+
+	/** @brief 时间戳的物理时间，精度为毫秒 */
+	static Time toTime(int64 stamp);
+	/** @brief 时间对应的最小时间戳，逻辑计数为0 */
+	static int64 fromTime(const Time & time);
+
+public:
+	/**
+	 * @brief 构造
+	 * @param maxDrift 允许收到的时间戳超前本地物理时钟的最大值
+	 * @param source 物理时钟，为空时使用Time
+	 */
+	HybridClock(const Duration & maxDrift = Duration(500, Duration::MilliSecond), const Source & source = Source());
+
+	/** @brief 允许的最大超前，毫秒 */
+	inline int64 maxDrift() const
+	{
+		return _maxDrift;
+	}
+
+	/** @brief 本地事件或发送消息，返回新的时间戳 */
+	int64 now();
+	/** @brief 以指定的物理时间(毫秒)产生时间戳 */
+	int64 now(int64 physical);
+
+	/**
+	 * @brief 收到消息，合并对方的时间戳
+	 * @return 新的时间戳，大于remote和之前的所有时间戳；remote超前过多时返回Invalid且不更新
+	 */
+	int64 update(int64 remote);
+	/** @brief 以指定的物理时间(毫秒)合并对方的时间戳 */
+	int64 update(int64 remote, int64 physical);
+
+	/** @brief 最近产生的时间戳，不产生新的 */
+	inline int64 last() const
+	{
+		return _state.load(std::memory_order_acquire);
+	}
+
+	/** @brief 逻辑时钟超前物理时钟的毫秒数，正常时为0 */
+	int64 drift() const;
+	/** @brief 因超前过多被拒绝的次数 */
+	inline int64 rejected() const
+	{
+		return _rejected.load(std::memory_order_relaxed);
+	}
+
+private:
+	HybridClock(const HybridClock &);
+	HybridClock & operator = (const HybridClock &);
+
+	/** @brief 物理时钟的毫秒时间戳 */
+	int64 _physical() const;
+	/** @brief 推进到不小于floor的时间戳 */
+	int64 _advance(int64 floor);
+
+	int64 _maxDrift;
+	Source _source;
+	std::atomic<int64> _state;
+	std::atomic<int64> _rejected;
+};
+
+} /* namespace ec */
+
+#endif /* INCLUDE_EC_HYBRIDCLOCK_H_ */
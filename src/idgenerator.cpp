@@ -0,0 +1,184 @@
+﻿/*
+ * idgenerator.cpp
+ *
+ *  Created on: 2026年10月19日
+ *      Author: havesnag
+ */
+
+#include "idgenerator.h"
+#include <algorithm>
+#include <chrono>
+#include <thread>
+
+namespace ec
+{
+
+namespace
+{
+
+/** @brief 线程当前的序号段 */
+struct Block
+{
+	/** @brief 所属生成器的编号，0为无效 */
+	uint64_t owner;
+	/** @brief 相对于纪元的毫秒数 */
+	int64 stamp;
+	int64 next;
+	int64 end;
+	/** @brief 下次取的段的大小 */
+	int64 size;
+};
+
+thread_local Block block = { 0, 0, 0, 0, 1 };
+
+std::atomic<uint64_t> serials(1);
+
+} /* namespace */
+
+IdGenerator::IdGenerator(int64 node, int64 epoch, int timestampBits, int nodeBits, int sequenceBits,
+	const Source & source)
+{
+	_serial = serials.fetch_add(1, std::memory_order_relaxed);
+	_epoch = epoch;
+	_sequenceBits = std::min(std::max(sequenceBits, 1), 30);
+	_nodeBits = std::min(std::max(nodeBits, 0), 30);
+	_timestampBits = std::max(std::min(timestampBits, 63 - _nodeBits - _sequenceBits), 1);
+	_node = node & ((static_cast<int64>(1) << _nodeBits) - 1);
+	_source = source;
+	_state.store(0);
+	_waits.store(0);
+}
+
+int64 IdGenerator::next()
+{
+	const int64 stamp = _physical() - _epoch;
+	if (stamp < 0 || stamp >= (static_cast<int64>(1) << _timestampBits))
+	{
+		return Invalid;
+	}
+
+	if (block.owner != _serial)
+	{
+		block.owner = _serial;
+		block.stamp = -1;
+		block.next = 0;
+		block.end = 0;
+		block.size = 1;
+	}
+	else if (block.next < block.end)
+	{
+		// 时钟回拨时继续使用原来的毫秒，保持递增
+		if (stamp <= block.stamp)
+		{
+			return (block.stamp << (_nodeBits + _sequenceBits)) | (_node << _sequenceBits) | block.next++;
+		}
+
+		// 换毫秒时段还没用完，说明取多了
+		block.size = std::max<int64>(block.size / 2, 1);
+	}
+	else if (stamp == block.stamp)
+	{
+		block.size = std::min<int64>(block.size * 2, static_cast<int64>(1) << _sequenceBits);
+	}
+
+	int64 first = 0;
+	int64 size = block.size;
+	block.stamp = _acquire(stamp, first, size);
+	block.next = first + 1;
+	block.end = first + size;
+	return (block.stamp << (_nodeBits + _sequenceBits)) | (_node << _sequenceBits) | first;
+}
+
+Time IdGenerator::timeOf(int64 id) const
+{
+	Time time(0);
+	time.setMicroStamp(milliStampOf(id) * 1000);
+	return time;
+}
+
+int64 IdGenerator::milliStampOf(int64 id) const
+{
+	return (id >> (_nodeBits + _sequenceBits)) + _epoch;
+}
+
+int64 IdGenerator::nodeOf(int64 id) const
+{
+	return (id >> _sequenceBits) & ((static_cast<int64>(1) << _nodeBits) - 1);
+}
+
+int64 IdGenerator::sequenceOf(int64 id) const
+{
+	return id & ((static_cast<int64>(1) << _sequenceBits) - 1);
+}
+
+int64 IdGenerator::lowerBound(const Time & time) const
+{
+	const int64 stamp = std::min(std::max<int64>(time.milliStamp() - _epoch, 0),
+		(static_cast<int64>(1) << _timestampBits) - 1);
+	return stamp << (_nodeBits + _sequenceBits);
+}
+
+int64 IdGenerator::_physical() const
+{
+	return _source ? _source() : Time().milliStamp();
+}
+
+int64 IdGenerator::_acquire(int64 now, int64 & first, int64 & size)
+{
+	const uint64_t limit = static_cast<uint64_t>(1) << _sequenceBits;
+	const uint64_t usedMask = (limit << 1) - 1;
+	int64 stamp = now;
+	for (;;)
+	{
+		uint64_t state = _state.load(std::memory_order_relaxed);
+		const int64 last = static_cast<int64>(state >> (_sequenceBits + 1));
+		const uint64_t used = state & usedMask;
+
+		if (stamp > last)
+		{
+			const uint64_t take = std::min(static_cast<uint64_t>(size), limit);
+			if (_state.compare_exchange_weak(state, (static_cast<uint64_t>(stamp) << (_sequenceBits + 1)) | take,
+				std::memory_order_relaxed, std::memory_order_relaxed))
+			{
+				first = 0;
+				size = static_cast<int64>(take);
+				return stamp;
+			}
+			continue;
+		}
+
+		if (stamp == last && used < limit)
+		{
+			const uint64_t take = std::min(static_cast<uint64_t>(size), limit - used);
+			if (_state.compare_exchange_weak(state, state + take, std::memory_order_relaxed, std::memory_order_relaxed))
+			{
+				first = static_cast<int64>(used);
+				size = static_cast<int64>(take);
+				return stamp;
+			}
+			continue;
+		}
+
+		// 这一毫秒的序号用完时等到下一毫秒，时钟回拨时等到追上
+		_waits.fetch_add(1, std::memory_order_relaxed);
+		const int64 target = (stamp == last) ? last + 1 : last;
+		for (;;)
+		{
+			stamp = _physical() - _epoch;
+			if (stamp >= target)
+			{
+				break;
+			}
+			if (target - stamp > 1)
+			{
+				std::this_thread::sleep_for(std::chrono::milliseconds(target - stamp - 1));
+			}
+			else
+			{
+				std::this_thread::yield();
+			}
+		}
+	}
+}
+
+} /* namespace ec */
@@ -0,0 +1,108 @@
+﻿/*
+ * idgenerator.h
+ *
+ *  Created on: 2026年10月19日
+ *      Author: havesnag
+ */
+
+#ifndef INCLUDE_EC_IDGENERATOR_H_
+#define INCLUDE_EC_IDGENERATOR_H_
+
+#include "date.h"
+#include <stdint.h>
+#include <atomic>
+#include <functional>
+
+namespace ec
+{
+
+/**
+ * @brief 按时间排序的唯一ID生成器(Snowflake)
+ * @details
+ *     ID为非负的int64，从高到低依次为：距离纪元的毫秒数(timestampBits位)、节点号(nodeBits位)、序号(sequenceBits位)，
+ *     按整数比较即大致按生成时间排序(同一毫秒内的顺序不定)。
+ *
+ *     每个线程从共享状态中一次取一段序号，之后在这一段内生成不需要任何原子操作，
+ *     同一毫秒内用完时下次取的段加倍，换毫秒时段还没用完则减半，线程多时也不会浪费太多序号。
+ *     共享状态为一个64位原子变量，保存最近的毫秒和其中已分配到的序号。
+ *
+ *     一毫秒内的序号用完时等到下一毫秒；时钟回拨到已经分配过的毫秒之前时，等到时钟追上。
+ *     已取到的序号段在回拨后仍然使用原来的毫秒，所以每个线程生成的ID严格递增。
+ * @note 不同的生成器可以在同一个线程中使用，但交替使用时每次都要重新取段
+ */
+class IdGenerator
+{
+public:
+	/** @brief 物理时钟，返回毫秒时间戳 */
+	typedef std::function<int64 ()> Source;
+
+	/** @brief 时间戳超出timestampBits位时返回的ID */
+	static const int64 Invalid = INT64_MIN;
+	/** @brief 默认纪元，2020-01-01 00:00:00 UTC的毫秒时间戳 */
+	static const int64 DefaultEpoch = 1577836800000LL;
+
+public:
+	/**
+	 * @brief 构造，三部分的位数之和不能超过63，超过时依次减少时间戳的位数
+	 * @param node 节点号，只保留低nodeBits位
+	 * @param epoch 纪元的毫秒时间戳
+	 * @param source 物理时钟，为空时使用Time
+	 */
+	IdGenerator(int64 node, int64 epoch = DefaultEpoch, int timestampBits = 41, int nodeBits = 10,
+		int sequenceBits = 12, const Source & source = Source());
+
+	/** @brief 节点号 */
+	inline int64 node() const
+	{
+		return _node;
+	}
+
+	/** @brief 生成一个ID */
+	int64 next();
+
+	/** @brief ID中的时间，精度为毫秒 */
+	Time timeOf(int64 id) const;
+	/** @brief ID中的毫秒时间戳 */
+	int64 milliStampOf(int64 id) const;
+	/** @brief ID中的节点号 */
+	int64 nodeOf(int64 id) const;
+	/** @brief ID中的序号 */
+	int64 sequenceOf(int64 id) const;
+	/** @brief 不早于time生成的ID都不小于它，用于按时间范围查询 */
+	int64 lowerBound(const Time & time) const;
+
+	/** @brief 因序号用完或时钟回拨而等待的次数 */
+	inline int64 waits() const
+	{
+		return _waits.load(std::memory_order_relaxed);
+	}
+
+private:
+	IdGenerator(const IdGenerator &);
+	IdGenerator & operator = (const IdGenerator &);
+
+	/** @brief 物理时钟的毫秒时间戳 */
+	int64 _physical() const;
+	/**
+	 * @brief 从共享状态中取一段序号
+	 * @param size 段的大小，返回时为实际取到的个数
+	 * @return 所在的毫秒时间戳
+	 */
+	int64 _acquire(int64 now, int64 & first, int64 & size);
+
+	/** @brief 区分不同生成器的编号，不重复使用 */
+	uint64_t _serial;
+	int64 _epoch;
+	int64 _node;
+	int _timestampBits;
+	int _nodeBits;
+	int _sequenceBits;
+	Source _source;
+	/** @brief 最近的毫秒(相对于纪元) << (sequenceBits + 1) | 已分配到的序号 */
+	std::atomic<uint64_t> _state;
+	std::atomic<int64> _waits;
+};
+
+} /* namespace ec */
+
+#endif /* INCLUDE_EC_IDGENERATOR_H_ */
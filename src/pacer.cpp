@@ -0,0 +1,167 @@
+﻿/*
+ * pacer.cpp
+ *
+ *  Created on: 2026年10月19日
+ *      Author: havesnag
+ */
+
+#include "pacer.h"
+#include <algorithm>
+#include <chrono>
+#include <thread>
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define PACER_PAUSE() __builtin_ia32_pause()
+#elif (defined(__GNUC__) || defined(__clang__)) && (defined(__aarch64__) || defined(__arm__))
+#define PACER_PAUSE() __asm__ __volatile__("yield")
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#define PACER_PAUSE() _mm_pause()
+#else
+#define PACER_PAUSE() ((void)0)
+#endif
+
+namespace ec
+{
+
+const int64 Pacer::MaxEstimate;
+
+int64 Pacer::steadyNanos()
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+Pacer::Pacer(const Duration & spinThreshold, bool adaptive)
+{
+	_spinThreshold = 0;
+	_adaptive = adaptive;
+	_estimate = 0;
+	_originStamp = 0;
+	_originSteady = steadyNanos();
+	_speed = 1.0;
+	setSpinThreshold(spinThreshold);
+	resetStats();
+}
+
+void Pacer::setSpinThreshold(const Duration & threshold)
+{
+	_spinThreshold = std::max<int64>(threshold.valueAs(Duration::MicroSecond), 0) * 1000;
+}
+
+void Pacer::setAdaptive(bool adaptive)
+{
+	_adaptive = adaptive;
+	if (!adaptive)
+	{
+		_estimate = 0;
+	}
+}
+
+void Pacer::calibrate(int rounds)
+{
+	int64 highest = 0;
+	for (int i = 0; i < rounds; ++i)
+	{
+		const int64 begin = steadyNanos();
+		std::this_thread::sleep_for(std::chrono::microseconds(100));
+		highest = std::max(highest, steadyNanos() - begin - 100000);
+	}
+	_estimate = std::min(highest, std::max(MaxEstimate, 4 * _spinThreshold));
+}
+
+void Pacer::sleepUntil(const Time & deadline)
+{
+	const int64 remaining = (deadline.microStamp() - Time().microStamp()) * 1000;
+	sleepUntilSteady(steadyNanos() + remaining);
+}
+
+void Pacer::sleepFor(const Duration & duration)
+{
+	sleepUntilSteady(steadyNanos() + duration.valueAs(Duration::MicroSecond) * 1000);
+}
+
+void Pacer::sleepUntilSteady(int64 deadline)
+{
+	++_stats.count;
+	int64 now = steadyNanos();
+	if (now >= deadline)
+	{
+		++_stats.late;
+		return;
+	}
+
+	// 粗睡到离截止时间还有自旋距离时，睡得不够时再睡
+	bool slept = false;
+	for (;;)
+	{
+		const int64 margin = _spinThreshold + _estimate;
+		const int64 request = deadline - now - margin;
+		if (request <= 0)
+		{
+			break;
+		}
+
+		std::this_thread::sleep_for(std::chrono::nanoseconds(request));
+		const int64 woke = steadyNanos();
+		_stats.sleepTime += woke - now;
+		if (_adaptive)
+		{
+			_updateEstimate(std::max<int64>(woke - now - request, 0));
+		}
+		slept = true;
+		now = woke;
+	}
+
+	// 估计值超过等待间隔时不再睡眠，没有新的超出量，按0下降，否则会一直自旋
+	if (_adaptive && !slept)
+	{
+		_updateEstimate(0);
+	}
+
+	const int64 spinBegin = now;
+	while (now < deadline)
+	{
+		PACER_PAUSE();
+		now = steadyNanos();
+	}
+	_stats.spinTime += now - spinBegin;
+
+	const int64 overshoot = now - deadline;
+	_stats.overshoot += overshoot;
+	_stats.maxOvershoot = std::max(_stats.maxOvershoot, overshoot);
+}
+
+void Pacer::_updateEstimate(int64 overshoot)
+{
+	// 变大时立即跟上，变小时每次下降1/16
+	const int64 estimate = (overshoot > _estimate) ? overshoot : _estimate - (_estimate - overshoot) / 16;
+	_estimate = std::min(estimate, std::max(MaxEstimate, 4 * _spinThreshold));
+}
+
+void Pacer::start(const Time & origin, double speed)
+{
+	_originStamp = origin.microStamp();
+	_originSteady = steadyNanos();
+	_speed = (speed > 0.0) ? speed : 1.0;
+}
+
+int64 Pacer::pace(const Time & time)
+{
+	const int64 offset = static_cast<int64>(static_cast<double>(time.microStamp() - _originStamp) * 1000.0 / _speed);
+	const int64 deadline = _originSteady + offset;
+	sleepUntilSteady(deadline);
+	return std::max<int64>(steadyNanos() - deadline, 0);
+}
+
+void Pacer::resetStats()
+{
+	_stats.count = 0;
+	_stats.late = 0;
+	_stats.overshoot = 0;
+	_stats.maxOvershoot = 0;
+	_stats.sleepTime = 0;
+	_stats.spinTime = 0;
+}
+
+} /* namespace ec */
@@ -0,0 +1,133 @@
+﻿/*
+ * pacer.h
+ *
+ *  Created on: 2026年10月19日
+ *      Author: havesnag
+ */
+
+#ifndef INCLUDE_EC_PACER_H_
+#define INCLUDE_EC_PACER_H_
+
+#include "date.h"
+
+namespace ec
+{
+
+/**
+ * @brief 精确的睡眠和按时间回放
+ * @details
+ *     nanosleep通常会多睡几十微秒，所以先粗睡到离截止时间还有一段距离时醒来，剩下的用pause指令自旋等待。
+ *     自旋的距离为固定的spinThreshold加上估计的nanosleep超出量，超出量在每次睡眠后更新：
+ *     变大时立即取新值，变小时缓慢下降，也可以用calibrate()预先测量。只自旋没有睡眠的等待也让估计值下降，
+ *     估计值不超过250微秒和4倍spinThreshold中的较大者，偶尔一次大的抖动不会让之后的等待一直自旋。
+ *     截止时间换算为单调时钟，睡眠期间系统时间的调整不影响等待。
+ *
+ *     回放时start()指定第一个事件的时间，之后pace()按事件时间与它的差值等待，可以按speed倍速回放。
+ * @note 非线程安全，每个线程使用自己的实例
+ */
+class Pacer
+{
+public:
+	/** @brief 统计，时间单位为纳秒 */
+	struct Stats
+	{
+		/** @brief 等待次数 */
+		int64 count;
+		/** @brief 调用时已经过了截止时间的次数 */
+		int64 late;
+		/** @brief 醒来时超过截止时间的总和，不含late */
+		int64 overshoot;
+		/** @brief 醒来时超过截止时间的最大值，不含late */
+		int64 maxOvershoot;
+		/** @brief 粗睡的总时间 */
+		int64 sleepTime;
+		/** @brief 自旋的总时间 */
+		int64 spinTime;
+
+		/** @brief 平均超出 */
+		inline double meanOvershoot() const
+		{
+			return (count > late) ? static_cast<double>(overshoot) / (count - late) : 0.0;
+		}
+	};
+
+	/** @brief 单调时钟的纳秒数 */
+	static int64 steadyNanos();
+
+public:
+	/**
+	 * @brief 构造
+	 * @param spinThreshold 自旋的最小距离，为0时只靠估计的超出量决定
+	 * @param adaptive 是否按测得的nanosleep超出量增加自旋距离
+	 */
+	Pacer(const Duration & spinThreshold = Duration(20, Duration::MicroSecond), bool adaptive = true);
+
+	/** @brief 设置自旋的最小距离 */
+	void setSpinThreshold(const Duration & threshold);
+	/** @brief 自旋的最小距离，纳秒 */
+	inline int64 spinThreshold() const
+	{
+		return _spinThreshold;
+	}
+
+	/** @brief 设置是否按测得的超出量增加自旋距离 */
+	void setAdaptive(bool adaptive);
+	/** @brief 估计的nanosleep超出量，纳秒 */
+	inline int64 estimate() const
+	{
+		return _estimate;
+	}
+
+	/**
+	 * @brief 测量nanosleep的超出量作为初始估计
+	 * @param rounds 测量次数，每次睡眠约100微秒
+	 */
+	void calibrate(int rounds = 20);
+
+	/** @brief 等待到指定的时间 */
+	void sleepUntil(const Time & deadline);
+	/** @brief 等待一段时间 */
+	void sleepFor(const Duration & duration);
+	/** @brief 等待到单调时钟的纳秒数 @see steadyNanos */
+	void sleepUntilSteady(int64 deadline);
+
+	/**
+	 * @brief 开始回放
+	 * @param origin 第一个事件的时间，对应调用时的当前时间
+	 * @param speed 回放的倍速，大于1时更快
+	 */
+	void start(const Time & origin, double speed = 1.0);
+	/** @brief 等待到事件时间对应的时刻，返回醒来时超过的纳秒数 */
+	int64 pace(const Time & time);
+
+	/** @brief 统计 */
+	inline const Stats & stats() const
+	{
+		return _stats;
+	}
+
+	/** @brief 清空统计 */
+	void resetStats();
+
+private:
+	Pacer(const Pacer &);
+	Pacer & operator = (const Pacer &);
+
+	/** @brief 估计值的上限，纳秒 */
+	static const int64 MaxEstimate = 250000;
+
+	/** @brief 按一次睡眠的超出量更新估计值 */
+	void _updateEstimate(int64 overshoot);
+
+	int64 _spinThreshold;
+	bool _adaptive;
+	int64 _estimate;
+	int64 _originStamp;
+	int64 _originSteady;
+	double _speed;
+	Stats _stats;
+};
+
+} /* namespace ec */
+
+#endif /* INCLUDE_EC_PACER_H_ */
@@ -0,0 +1,266 @@
+﻿/*
+ * ratelimit.cpp
+ *
+ *  Created on: 2026年10月19日
+ *      Author: havesnag
+ */
+
+#include "ratelimit.h"
+#include "clock.h"
+#include <algorithm>
+using namespace std;
+
+namespace ec
+{
+
+namespace
+{
+
+const int64 timeMask = (static_cast<int64>(1) << 48) - 1;
+const uint64_t tokenMask = 0xFFFF;
+
+} /* namespace */
+
+int64 CoarseClock::microStamp()
+{
+	if (Clock::overridden())
+	{
+		return Clock::now();
+	}
+
+#if defined(CLOCK_REALTIME_COARSE) && !defined(PLATFORM_WINDOWS)
+	struct timespec ts;
+	clock_gettime(CLOCK_REALTIME_COARSE, &ts);
+	return static_cast<int64>(ts.tv_sec) * 1000000 + ts.tv_nsec / 1000;
+#else
+	return Time().microStamp();
+#endif
+}
+
+#ifdef PLATFORM_WINDOWS
+ReadWriteLock::ReadWriteLock()
+{
+	InitializeSRWLock(&_lock);
+}
+
+ReadWriteLock::~ReadWriteLock()
+{
+}
+
+void ReadWriteLock::lockShared()
+{
+	AcquireSRWLockShared(&_lock);
+}
+
+void ReadWriteLock::unlockShared()
+{
+	ReleaseSRWLockShared(&_lock);
+}
+
+void ReadWriteLock::lock()
+{
+	AcquireSRWLockExclusive(&_lock);
+}
+
+void ReadWriteLock::unlock()
+{
+	ReleaseSRWLockExclusive(&_lock);
+}
+#else
+ReadWriteLock::ReadWriteLock()
+{
+	pthread_rwlock_init(&_lock, NULL);
+}
+
+ReadWriteLock::~ReadWriteLock()
+{
+	pthread_rwlock_destroy(&_lock);
+}
+
+void ReadWriteLock::lockShared()
+{
+	pthread_rwlock_rdlock(&_lock);
+}
+
+void ReadWriteLock::unlockShared()
+{
+	pthread_rwlock_unlock(&_lock);
+}
+
+void ReadWriteLock::lock()
+{
+	pthread_rwlock_wrlock(&_lock);
+}
+
+void ReadWriteLock::unlock()
+{
+	pthread_rwlock_unlock(&_lock);
+}
+#endif // PLATFORM_WINDOWS
+
+TokenBucket::TokenBucket(int64 tokens, const Duration & period, int64 burst, bool coarse)
+{
+	_tokens = std::max<int64>(tokens, 1);
+	_period = std::max<int64>(period.valueAs(Duration::MicroSecond), 1);
+	_burst = std::min<int64>(std::max<int64>(burst, 1), static_cast<int64>(tokenMask));
+	_coarse = coarse;
+	_base = _now();
+	_state.store(static_cast<uint64_t>(_burst));
+}
+
+bool TokenBucket::tryAcquire(int64 count)
+{
+	return tryAcquire(_now(), count);
+}
+
+bool TokenBucket::tryAcquire(int64 now, int64 count)
+{
+	if (count <= 0)
+	{
+		return true;
+	}
+
+	uint64_t state = _state.load(std::memory_order_relaxed);
+	for (;;)
+	{
+		const uint64_t next = _refill(state, now);
+		if (static_cast<int64>(next & tokenMask) < count)
+		{
+			return false;
+		}
+
+		if (_state.compare_exchange_weak(state, next - static_cast<uint64_t>(count),
+			std::memory_order_acq_rel, std::memory_order_relaxed))
+		{
+			return true;
+		}
+	}
+}
+
+bool TokenBucket::tryAcquire(const Time & now, int64 count)
+{
+	return tryAcquire(now.microStamp(), count);
+}
+
+int64 TokenBucket::available() const
+{
+	return available(_now());
+}
+
+int64 TokenBucket::available(int64 now) const
+{
+	return static_cast<int64>(_refill(_state.load(std::memory_order_relaxed), now) & tokenMask);
+}
+
+void TokenBucket::reset()
+{
+	const int64 relative = std::max<int64>(_now() - _base, 0) & timeMask;
+	_state.store((static_cast<uint64_t>(relative) << 16) | static_cast<uint64_t>(_burst));
+}
+
+int64 TokenBucket::_now() const
+{
+	return _coarse ? CoarseClock::microStamp() : Time().microStamp();
+}
+
+uint64_t TokenBucket::_refill(uint64_t state, int64 now) const
+{
+	const int64 relative = std::max<int64>(now - _base, 0) & timeMask;
+	const int64 last = static_cast<int64>(state >> 16);
+	const int64 tokens = static_cast<int64>(state & tokenMask);
+	const int64 elapsed = relative - last;
+
+	// 时间倒退时不补充
+	if (elapsed <= 0)
+	{
+		return state;
+	}
+
+	// 满了之后时间不再积累
+	if (tokens >= _burst)
+	{
+		return (static_cast<uint64_t>(relative) << 16) | static_cast<uint64_t>(tokens);
+	}
+
+	const int64 missing = _burst - tokens;
+	const int64 added = (elapsed >= (missing * _period + _tokens - 1) / _tokens) ? missing : (elapsed * _tokens / _period);
+	if (0 == added)
+	{
+		return state;
+	}
+
+	// 只推进补充这些令牌所用的时间(向上取整)，不足一个令牌的部分留到下次
+	const int64 refilled = (added == missing) ? relative
+		: std::min(last + (added * _period + _tokens - 1) / _tokens, relative);
+	return (static_cast<uint64_t>(refilled) << 16) | static_cast<uint64_t>(tokens + added);
+}
+
+
+LeakyBucket::LeakyBucket(int64 tokens, const Duration & period, int64 burst, bool coarse)
+{
+	_interval = std::max<int64>(period.valueAs(Duration::MicroSecond) * 1000 / std::max<int64>(tokens, 1), 1);
+	_tolerance = std::max<int64>(burst, 1) * _interval;
+	_coarse = coarse;
+	_base = _now();
+	_tat.store(0);
+}
+
+bool LeakyBucket::tryAcquire(int64 count)
+{
+	return tryAcquire(_now(), count);
+}
+
+bool LeakyBucket::tryAcquire(int64 now, int64 count)
+{
+	if (count <= 0)
+	{
+		return true;
+	}
+
+	const int64 relative = (now - _base) * 1000;
+	const int64 increment = count * _interval;
+	int64 tat = _tat.load(std::memory_order_relaxed);
+	for (;;)
+	{
+		const int64 next = std::max(tat, relative) + increment;
+		if (next - relative > _tolerance)
+		{
+			return false;
+		}
+
+		if (_tat.compare_exchange_weak(tat, next, std::memory_order_acq_rel, std::memory_order_relaxed))
+		{
+			return true;
+		}
+	}
+}
+
+bool LeakyBucket::tryAcquire(const Time & now, int64 count)
+{
+	return tryAcquire(now.microStamp(), count);
+}
+
+int64 LeakyBucket::waitTime(int64 count) const
+{
+	return waitTime(_now(), count);
+}
+
+int64 LeakyBucket::waitTime(int64 now, int64 count) const
+{
+	const int64 relative = (now - _base) * 1000;
+	const int64 next = std::max(_tat.load(std::memory_order_relaxed), relative) + count * _interval;
+	const int64 wait = next - relative - _tolerance;
+	return (wait > 0) ? (wait + 999) / 1000 : 0;
+}
+
+void LeakyBucket::reset()
+{
+	_tat.store(0);
+}
+
+int64 LeakyBucket::_now() const
+{
+	return _coarse ? CoarseClock::microStamp() : Time().microStamp();
+}
+
+} /* namespace ec */
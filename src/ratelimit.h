@@ -0,0 +1,280 @@
+﻿/*
+ * ratelimit.h
+ *
+ *  Created on: 2026年10月19日
+ *      Author: havesnag
+ */
+
+#ifndef INCLUDE_EC_RATELIMIT_H_
+#define INCLUDE_EC_RATELIMIT_H_
+
+#include "date.h"
+#include <stddef.h>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#ifndef PLATFORM_WINDOWS
+#include <pthread.h>
+#endif // PLATFORM_WINDOWS
+
+namespace ec
+{
+
+/**
+ * @brief 粗粒度的时钟
+ * @details Linux下读取CLOCK_REALTIME_COARSE，精度为一个时钟中断(1~4毫秒)，开销只有几纳秒，其他系统等同于Time。
+ *     安装了时钟时读取它 @see Clock
+ */
+class CoarseClock
+{
+public:
+	/** @brief 微秒时间戳，与Time::microStamp()同一基准 */
+	static int64 microStamp();
+
+private:
+	CoarseClock();
+};
+
+/**
+ * @brief 读写锁
+ * @details 多个读者可以同时持有，写者独占。C++11没有std::shared_mutex，Windows下为SRWLOCK，其他系统为pthread_rwlock_t。
+ *     lock和unlock可用于std::lock_guard。
+ */
+class ReadWriteLock
+{
+public:
+	ReadWriteLock();
+	~ReadWriteLock();
+
+	/** @brief 加读锁 */
+	void lockShared();
+	/** @brief 释放读锁 */
+	void unlockShared();
+	/** @brief 加写锁 */
+	void lock();
+	/** @brief 释放写锁 */
+	void unlock();
+
+private:
+	ReadWriteLock(const ReadWriteLock &);
+	ReadWriteLock & operator = (const ReadWriteLock &);
+
+#ifdef PLATFORM_WINDOWS
+	SRWLOCK _lock;
+#else
+	pthread_rwlock_t _lock;
+#endif // PLATFORM_WINDOWS
+};
+
+/**
+ * @brief 令牌桶
+ * @details
+ *     每period补充tokens个令牌，最多积累burst个。
+ *     剩余令牌数和上次补充的时间打包在一个64位的原子变量中，高48位为相对于构造时的微秒数(约8.9年)，
+ *     低16位为令牌数，所以burst不超过65535，获取令牌只需一次CAS循环。
+ */
+class TokenBucket
+{
+public:
+	/**
+	 * @brief 构造
+	 * @param tokens 每个周期补充的令牌数
+	 * @param period 周期
+	 * @param burst 最多积累的令牌数，初始为满
+	 * @param coarse 是否使用CoarseClock读取时间
+	 */
+	TokenBucket(int64 tokens, const Duration & period, int64 burst, bool coarse = false);
+
+	/** @brief 尝试获取count个令牌，不足时返回false且不消耗 */
+	bool tryAcquire(int64 count = 1);
+	/** @brief 以指定的微秒时间戳尝试获取令牌 */
+	bool tryAcquire(int64 now, int64 count);
+	/** @brief 以指定的时间尝试获取令牌 */
+	bool tryAcquire(const Time & now, int64 count = 1);
+
+	/** @brief 当前可用的令牌数 */
+	int64 available() const;
+	/** @brief 指定的微秒时间戳时可用的令牌数 */
+	int64 available(int64 now) const;
+
+	/** @brief 恢复为满 */
+	void reset();
+
+private:
+	TokenBucket(const TokenBucket &);
+	TokenBucket & operator = (const TokenBucket &);
+
+	int64 _now() const;
+	/** @brief 补充令牌后的状态 */
+	uint64_t _refill(uint64_t state, int64 now) const;
+
+	int64 _tokens;
+	int64 _period;
+	int64 _burst;
+	bool _coarse;
+	int64 _base;
+	std::atomic<uint64_t> _state;
+};
+
+/**
+ * @brief 漏桶，按GCRA(通用信元速率算法)实现
+ * @details
+ *     记录理论到达时间(TAT)，每个请求使TAT后移一个间隔(period / tokens)，
+ *     TAT超前当前时间不超过burst个间隔时允许。
+ *     状态只有一个64位的纳秒数，与令牌桶相比请求被均匀地放行，没有积累后的集中放行。
+ */
+class LeakyBucket
+{
+public:
+	/**
+	 * @brief 构造
+	 * @param tokens 每个周期允许的请求数
+	 * @param period 周期
+	 * @param burst 允许的突发请求数
+	 * @param coarse 是否使用CoarseClock读取时间
+	 */
+	LeakyBucket(int64 tokens, const Duration & period, int64 burst, bool coarse = false);
+
+	/** @brief 尝试通过count个请求，不允许时返回false且不改变状态 */
+	bool tryAcquire(int64 count = 1);
+	/** @brief 以指定的微秒时间戳尝试通过 */
+	bool tryAcquire(int64 now, int64 count);
+	/** @brief 以指定的时间尝试通过 */
+	bool tryAcquire(const Time & now, int64 count = 1);
+
+	/** @brief 还需要等待多少微秒才能通过count个请求，可以立即通过时为0 */
+	int64 waitTime(int64 count = 1) const;
+	/** @brief 以指定的微秒时间戳计算等待时间 */
+	int64 waitTime(int64 now, int64 count) const;
+
+	/** @brief 恢复为初始状态 */
+	void reset();
+
+private:
+	LeakyBucket(const LeakyBucket &);
+	LeakyBucket & operator = (const LeakyBucket &);
+
+	int64 _now() const;
+
+	/** @brief 间隔，纳秒 */
+	int64 _interval;
+	/** @brief 允许超前的纳秒数 */
+	int64 _tolerance;
+	bool _coarse;
+	int64 _base;
+	std::atomic<int64> _tat;
+};
+
+/**
+ * @brief 按键分片的限流器
+ * @details
+ *     键按哈希分到多个分片，每个分片有自己的读写锁。查找已有的限流器只加读锁，多个线程可以同时查找，
+ *     只在创建和删除限流器时加写锁，限流本身为无锁操作。读锁仍要修改分片的读者计数，
+ *     极热的键可以保存get的返回值直接使用。
+ * @tparam Limiter TokenBucket或LeakyBucket
+ */
+template <typename Limiter>
+class RateLimiterMap
+{
+public:
+	/**
+	 * @brief 构造，参数用于创建每个键的限流器
+	 * @param shards 分片数
+	 */
+	RateLimiterMap(int64 tokens, const Duration & period, int64 burst, bool coarse = false, size_t shards = 64)
+		: _tokens(tokens), _period(period), _burst(burst), _coarse(coarse), _shards(shards > 0 ? shards : 1)
+	{
+	}
+
+	/** @brief 键的限流器，不存在时创建，返回的引用在erase或clear之前有效 */
+	Limiter & get(const std::string & key)
+	{
+		Shard & shard = _shard(key);
+		shard.lock.lockShared();
+		typename Limiters::const_iterator found = shard.limiters.find(key);
+		Limiter * limiter = (found != shard.limiters.end()) ? found->second.get() : NULL;
+		shard.lock.unlockShared();
+		if (NULL != limiter)
+		{
+			return *limiter;
+		}
+
+		std::lock_guard<ReadWriteLock> lock(shard.lock);
+		std::unique_ptr<Limiter> & created = shard.limiters[key];
+		if (!created)
+		{
+			created.reset(new Limiter(_tokens, _period, _burst, _coarse));
+		}
+		return *created;
+	}
+
+	/** @brief 对键尝试获取 */
+	bool tryAcquire(const std::string & key, int64 count = 1)
+	{
+		return get(key).tryAcquire(count);
+	}
+
+	/** @brief 删除键 */
+	void erase(const std::string & key)
+	{
+		Shard & shard = _shard(key);
+		std::lock_guard<ReadWriteLock> lock(shard.lock);
+		shard.limiters.erase(key);
+	}
+
+	/** @brief 删除所有键 */
+	void clear()
+	{
+		for (size_t i = 0; i < _shards.size(); ++i)
+		{
+			std::lock_guard<ReadWriteLock> lock(_shards[i].lock);
+			_shards[i].limiters.clear();
+		}
+	}
+
+	/** @brief 键的个数 */
+	size_t size()
+	{
+		size_t count = 0;
+		for (size_t i = 0; i < _shards.size(); ++i)
+		{
+			_shards[i].lock.lockShared();
+			count += _shards[i].limiters.size();
+			_shards[i].lock.unlockShared();
+		}
+		return count;
+	}
+
+private:
+	typedef std::unordered_map<std::string, std::unique_ptr<Limiter> > Limiters;
+
+	/** @brief 分片 */
+	struct Shard
+	{
+		ReadWriteLock lock;
+		Limiters limiters;
+	};
+
+	RateLimiterMap(const RateLimiterMap &);
+	RateLimiterMap & operator = (const RateLimiterMap &);
+
+	inline Shard & _shard(const std::string & key)
+	{
+		return _shards[std::hash<std::string>()(key) % _shards.size()];
+	}
+
+	int64 _tokens;
+	Duration _period;
+	int64 _burst;
+	bool _coarse;
+	std::vector<Shard> _shards;
+};
+
+} /* namespace ec */
+
+#endif /* INCLUDE_EC_RATELIMIT_H_ */
@@ -0,0 +1,228 @@
+﻿/*
+ * threadpool.cpp
+ *
+ *  Created on: 2026年10月19日
+ *      Author: havesnag
+ */
+
+#include "threadpool.h"
+using namespace std;
+
+namespace ec
+{
+
+namespace
+{
+
+/** @brief 当前线程所属的线程池和队列，用于任务中提交的任务进入自己的队列 */
+thread_local const ThreadPool * currentPool = NULL;
+thread_local size_t currentQueue = 0;
+
+} /* namespace */
+
+ThreadPool & ThreadPool::shared()
+{
+	static ThreadPool pool;
+	return pool;
+}
+
+ThreadPool::ThreadPool(size_t threads)
+	: _next(0), _pending(0), _queued(0), _stop(false)
+{
+	if (0 == threads)
+	{
+		threads = std::thread::hardware_concurrency();
+		threads = (threads > 0) ? threads : 1;
+	}
+
+	// 最后一个队列给外部线程提交的任务
+	for (size_t i = 0; i <= threads; ++i)
+	{
+		_queues.push_back(std::unique_ptr<Queue>(new Queue()));
+	}
+
+	for (size_t i = 0; i < threads; ++i)
+	{
+		_threads.push_back(std::thread(&ThreadPool::_work, this, i));
+	}
+}
+
+ThreadPool::~ThreadPool()
+{
+	wait();
+
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_stop = true;
+	}
+	_workCondition.notify_all();
+
+	for (size_t i = 0; i < _threads.size(); ++i)
+	{
+		_threads[i].join();
+	}
+}
+
+void ThreadPool::submit(const Task & task)
+{
+	// 工作线程提交到自己的队列，其他线程轮流提交到各个队列
+	const size_t index = (this == currentPool) ? currentQueue
+		: (_next.fetch_add(1, std::memory_order_relaxed) % _queues.size());
+
+	_pending.fetch_add(1);
+	{
+		Queue & queue = *_queues[index];
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		queue.tasks.push_back(task);
+	}
+	_queued.fetch_add(1);
+
+	{
+		// 加锁后通知，避免工作线程检查条件后、等待前错过通知
+		std::lock_guard<std::mutex> lock(_mutex);
+	}
+	_workCondition.notify_one();
+}
+
+void ThreadPool::wait()
+{
+	const size_t index = (this == currentPool) ? currentQueue : _queues.size() - 1;
+	Task task;
+	while (_pending.load() > 0)
+	{
+		if (_take(index, task))
+		{
+			task();
+			task = Task();
+			_finish();
+			continue;
+		}
+
+		std::unique_lock<std::mutex> lock(_mutex);
+		_doneCondition.wait(lock, [this]() {
+			return 0 == _pending.load() || _queued.load() > 0;
+		});
+	}
+}
+
+void ThreadPool::run(size_t count, const std::function<void (size_t)> & task)
+{
+	if (count <= 1 || _threads.empty())
+	{
+		for (size_t i = 0; i < count; ++i)
+		{
+			task(i);
+		}
+		return;
+	}
+
+	// 只等待本次提交的任务，不受其他线程提交的任务影响
+	std::atomic<size_t> remain(count);
+	std::mutex mutex;
+	std::condition_variable done;
+	for (size_t i = 0; i < count; ++i)
+	{
+		submit([&, i]() {
+			task(i);
+			std::lock_guard<std::mutex> lock(mutex);
+			if (1 == remain.fetch_sub(1))
+			{
+				done.notify_all();
+			}
+		});
+	}
+
+	const size_t index = (this == currentPool) ? currentQueue : _queues.size() - 1;
+	Task job;
+	while (remain.load() > 0)
+	{
+		if (_take(index, job))
+		{
+			job();
+			job = Task();
+			_finish();
+			continue;
+		}
+
+		// 剩余的任务都已被其他线程取走
+		std::unique_lock<std::mutex> lock(mutex);
+		done.wait(lock, [&remain]() {
+			return 0 == remain.load();
+		});
+	}
+
+	// 等最后一个任务释放锁后才能销毁mutex
+	std::lock_guard<std::mutex> lock(mutex);
+}
+
+void ThreadPool::_work(size_t index)
+{
+	currentPool = this;
+	currentQueue = index;
+
+	Task task;
+	for (;;)
+	{
+		if (_take(index, task))
+		{
+			task();
+			task = Task();
+			_finish();
+			continue;
+		}
+
+		std::unique_lock<std::mutex> lock(_mutex);
+		_workCondition.wait(lock, [this]() {
+			return _stop || _queued.load() > 0;
+		});
+		if (_stop && 0 == _queued.load())
+		{
+			return;
+		}
+	}
+}
+
+bool ThreadPool::_take(size_t index, Task & task)
+{
+	if (0 == _queued.load())
+	{
+		return false;
+	}
+
+	// 先取自己队列的队尾，再从下一个队列开始窃取队头
+	const size_t count = _queues.size();
+	for (size_t i = 0; i < count; ++i)
+	{
+		Queue & queue = *_queues[(index + i) % count];
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		if (queue.tasks.empty())
+		{
+			continue;
+		}
+
+		if (0 == i)
+		{
+			task.swap(queue.tasks.back());
+			queue.tasks.pop_back();
+		}
+		else
+		{
+			task.swap(queue.tasks.front());
+			queue.tasks.pop_front();
+		}
+		_queued.fetch_sub(1);
+		return true;
+	}
+	return false;
+}
+
+void ThreadPool::_finish()
+{
+	if (1 == _pending.fetch_sub(1))
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_doneCondition.notify_all();
+	}
+}
+
+} /* namespace ec */
@@ -0,0 +1,93 @@
+﻿/*
+ * threadpool.h
+ *
+ *  Created on: 2026年10月19日
+ *      Author: havesnag
+ */
+
+#ifndef INCLUDE_EC_THREADPOOL_H_
+#define INCLUDE_EC_THREADPOOL_H_
+
+#include <stddef.h>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace ec
+{
+
+/**
+ * @brief 任务窃取的线程池
+ * @details
+ *     每个工作线程有自己的任务队列，从队尾取任务，空闲时从其他队列的队头窃取，
+ *     大小不均的任务会被空闲线程分走。
+ *     wait()的调用线程也会执行任务，任务中可以再提交任务。
+ */
+class ThreadPool
+{
+public:
+	/** @brief 任务 */
+	typedef std::function<void ()> Task;
+
+	/** @brief 进程内共享的线程池，线程数为CPU核数 */
+	static ThreadPool & shared();
+
+public:
+	/** @brief 以线程数构造，为0时取CPU核数 */
+	explicit ThreadPool(size_t threads = 0);
+	/** @brief 等待所有任务完成后结束线程 */
+	~ThreadPool();
+
+	/** @brief 线程数 */
+	inline size_t size() const
+	{
+		return _threads.size();
+	}
+
+	/** @brief 提交任务 */
+	void submit(const Task & task);
+	/** @brief 等待已提交的任务全部完成，期间当前线程也执行任务 */
+	void wait();
+
+	/**
+	 * @brief 并行执行task(0)到task(count - 1)并等待完成
+	 * @details 多个线程同时调用时各自等待所有任务完成
+	 */
+	void run(size_t count, const std::function<void (size_t)> & task);
+
+private:
+	struct Queue
+	{
+		std::mutex mutex;
+		std::deque<Task> tasks;
+	};
+
+	ThreadPool(const ThreadPool &);
+	ThreadPool & operator = (const ThreadPool &);
+
+	void _work(size_t index);
+	bool _take(size_t index, Task & task);
+	void _finish();
+
+	std::vector<std::unique_ptr<Queue> > _queues;
+	std::vector<std::thread> _threads;
+	std::atomic<size_t> _next;
+	/** @brief 未完成的任务数 */
+	std::atomic<size_t> _pending;
+	/** @brief 队列中的任务数 */
+	std::atomic<size_t> _queued;
+
+	std::mutex _mutex;
+	std::condition_variable _workCondition;
+	std::condition_variable _doneCondition;
+	bool _stop;
+};
+
+} /* namespace ec */
+
+#endif /* INCLUDE_EC_THREADPOOL_H_ */
@@ -0,0 +1,290 @@
+﻿/*
+ * timecolumn.cpp
+ *
+ *  Created on: 2026年10月19日
+ *      Author: havesnag
+ */
+
+#include "timecolumn.h"
+#include <algorithm>
+using namespace std;
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif // _MSC_VER
+
+namespace ec
+{
+
+namespace
+{
+
+/** @brief 各档的负载位数，下标为前缀中1的个数 */
+const unsigned payloadBits[6] = {0, 8, 13, 20, 32, 64};
+
+inline uint64_t zigzag(int64 value)
+{
+	return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+}
+
+inline int64 unzigzag(uint64_t value)
+{
+	return static_cast<int64>(value >> 1) ^ -static_cast<int64>(value & 1);
+}
+
+/** @brief 前导0的个数，bits不能为0 */
+inline unsigned leadingZeros(uint64_t bits)
+{
+#if defined(__GNUC__)
+	return static_cast<unsigned>(__builtin_clzll(bits));
+#elif defined(_MSC_VER) && defined(_M_X64)
+	unsigned long index = 0;
+	_BitScanReverse64(&index, bits);
+	return 63 - index;
+#else
+	unsigned count = 0;
+	while (0 == (bits & (static_cast<uint64_t>(1) << (63 - count))))
+	{
+		++count;
+	}
+	return count;
+#endif
+}
+
+/** @brief 前导1的个数，最多计到5 */
+inline unsigned leadingOnes(uint64_t bits)
+{
+	return leadingZeros(~bits | (static_cast<uint64_t>(1) << 58));
+}
+
+/** @brief 从pos位开始的64位，高位在前，words末尾至少多一个字 */
+inline uint64_t peek(const uint64_t * words, uint64_t pos)
+{
+	const uint64_t * p = words + (pos >> 6);
+	const unsigned shift = static_cast<unsigned>(pos & 63);
+	return (0 == shift) ? p[0] : ((p[0] << shift) | (p[1] >> (64 - shift)));
+}
+
+} /* namespace */
+
+TimeColumn::TimeColumn(size_t blockSize)
+{
+	_blockSize = (blockSize > 0) ? blockSize : 1;
+	clear();
+}
+
+TimeColumn::~TimeColumn()
+{
+}
+
+void TimeColumn::append(int64 stamp)
+{
+	if (0 == _size % _blockSize)
+	{
+		Block block;
+		block.first = stamp;
+		block.bitOffset = _bits;
+		_blocks.push_back(block);
+		_lastDelta = 0;
+	}
+	else
+	{
+		const int64 delta = static_cast<int64>(static_cast<uint64_t>(stamp) - static_cast<uint64_t>(_last));
+		const uint64_t value = zigzag(static_cast<int64>(static_cast<uint64_t>(delta) - static_cast<uint64_t>(_lastDelta)));
+		if (0 == value)
+		{
+			_write(0, 1);
+		}
+		else
+		{
+			unsigned ones = 1;
+			while (ones < 5 && (value >> payloadBits[ones]) != 0)
+			{
+				++ones;
+			}
+
+			// 前缀为ones个1，不足5个时后接一个0
+			_write((ones < 5) ? ((static_cast<uint64_t>(1) << (ones + 1)) - 2) : 31, (ones < 5) ? ones + 1 : 5);
+			_write(value, payloadBits[ones]);
+		}
+		_lastDelta = delta;
+	}
+
+	_last = stamp;
+	++_size;
+}
+
+void TimeColumn::append(const Time & time)
+{
+	append(time.microStamp());
+}
+
+void TimeColumn::clear()
+{
+	_size = 0;
+	_bits = 0;
+	_words.assign(2, 0);
+	_blocks.clear();
+	_last = 0;
+	_lastDelta = 0;
+}
+
+size_t TimeColumn::bytes() const
+{
+	return static_cast<size_t>((_bits + 63) / 64) * sizeof(uint64_t) + _blocks.size() * sizeof(Block);
+}
+
+int64 TimeColumn::at(size_t index) const
+{
+	int64 stamp = 0;
+	_decode(index / _blockSize, index % _blockSize, 1, &stamp);
+	return stamp;
+}
+
+Time TimeColumn::time(size_t index) const
+{
+	Time result;
+	result.setMicroStamp(at(index));
+	return result;
+}
+
+size_t TimeColumn::decodeBlock(size_t index, int64 * out) const
+{
+	return (index < _blocks.size()) ? _decode(index, 0, _blockSize, out) : 0;
+}
+
+size_t TimeColumn::decode(size_t begin, size_t count, int64 * out) const
+{
+	size_t decoded = 0;
+	while (decoded < count && begin < _size)
+	{
+		const size_t n = _decode(begin / _blockSize, begin % _blockSize, count - decoded, out + decoded);
+		decoded += n;
+		begin += n;
+	}
+	return decoded;
+}
+
+size_t TimeColumn::lowerBound(int64 stamp) const
+{
+	// 第一个首值不小于stamp的块之前的那一块包含结果
+	size_t low = 0;
+	size_t high = _blocks.size();
+	while (low < high)
+	{
+		const size_t middle = low + (high - low) / 2;
+		if (_blocks[middle].first < stamp)
+		{
+			low = middle + 1;
+		}
+		else
+		{
+			high = middle;
+		}
+	}
+
+	if (0 == low)
+	{
+		return 0;
+	}
+
+	const size_t index = low - 1;
+	int64 buf[256];
+	size_t offset = 0;
+	for (;;)
+	{
+		const size_t n = _decode(index, offset, 256, buf);
+		const int64 * it = std::lower_bound(buf, buf + n, stamp);
+		if (it != buf + n || n < 256)
+		{
+			return index * _blockSize + offset + (it - buf);
+		}
+		offset += n;
+	}
+}
+
+void TimeColumn::_write(uint64_t value, unsigned count)
+{
+	const size_t word = static_cast<size_t>(_bits >> 6);
+	const unsigned space = 64 - static_cast<unsigned>(_bits & 63);
+	if (_words.size() < word + 3)
+	{
+		_words.resize(std::max<size_t>(word + 3, _words.size() * 2), 0);
+	}
+
+	if (count < 64)
+	{
+		value &= (static_cast<uint64_t>(1) << count) - 1;
+	}
+
+	if (count <= space)
+	{
+		_words[word] |= (count == 64) ? value : (value << (space - count));
+	}
+	else
+	{
+		_words[word] |= value >> (count - space);
+		_words[word + 1] |= value << (64 - (count - space));
+	}
+	_bits += count;
+}
+
+size_t TimeColumn::_decode(size_t index, size_t skip, size_t count, int64 * out) const
+{
+	const size_t blockBegin = index * _blockSize;
+	const size_t blockCount = std::min(_blockSize, _size - blockBegin);
+	if (skip >= blockCount)
+	{
+		return 0;
+	}
+
+	const size_t end = std::min(blockCount, skip + count);
+	const uint64_t * words = &_words[0];
+	uint64_t pos = _blocks[index].bitOffset;
+	int64 stamp = _blocks[index].first;
+	int64 delta = 0;
+
+	if (0 == skip)
+	{
+		*out++ = stamp;
+	}
+
+	for (size_t i = 1; i < end; ++i)
+	{
+		const uint64_t bits = peek(words, pos);
+		const unsigned ones = leadingOnes(bits);
+		if (0 != ones)
+		{
+			const unsigned prefix = (ones < 5) ? ones + 1 : 5;
+			const unsigned size = payloadBits[ones];
+			const uint64_t value = (prefix + size <= 64) ? ((bits << prefix) >> (64 - size))
+				: peek(words, pos + prefix);
+			delta = static_cast<int64>(static_cast<uint64_t>(delta) + static_cast<uint64_t>(unzigzag(value)));
+			pos += prefix + size;
+		}
+		else
+		{
+			// 连续的0表示差值不变，等间隔的数据大多如此，一次处理一段
+			const size_t run = std::min<size_t>((0 == bits) ? 64 : leadingZeros(bits), end - i);
+			pos += run;
+			for (const size_t last = i + run - 1; i < last; ++i)
+			{
+				stamp = static_cast<int64>(static_cast<uint64_t>(stamp) + static_cast<uint64_t>(delta));
+				if (i >= skip)
+				{
+					*out++ = stamp;
+				}
+			}
+		}
+
+		stamp = static_cast<int64>(static_cast<uint64_t>(stamp) + static_cast<uint64_t>(delta));
+		if (i >= skip)
+		{
+			*out++ = stamp;
+		}
+	}
+
+	return end - skip;
+}
+
+} /* namespace ec */
@@ -0,0 +1,130 @@
+﻿/*
+ * timecolumn.h
+ *
+ *  Created on: 2026年10月19日
+ *      Author: havesnag
+ */
+
+#ifndef INCLUDE_EC_TIMECOLUMN_H_
+#define INCLUDE_EC_TIMECOLUMN_H_
+
+#include "date.h"
+#include <stddef.h>
+#include <vector>
+
+namespace ec
+{
+
+/**
+ * @brief 压缩的时间列
+ * @details
+ *     按Gorilla的方式存储相邻差值的差值(delta-of-delta)，等间隔的时间每个只需1位。
+ *     数据按块存储，每块的第一个微秒时间戳和起始位置记录在稀疏索引中，
+ *     可以按块随机访问，只解码需要的块。
+ *     差值的差值经zigzag编码后按大小分为以下几档：
+ *         0                 为0
+ *         10     + 8位      [0, 2^8)
+ *         110    + 13位     [0, 2^13)
+ *         1110   + 20位     [0, 2^20)
+ *         11110  + 32位     [0, 2^32)
+ *         11111  + 64位     其他
+ * @see Time::microStamp
+ */
+class TimeColumn
+{
+public:
+	/** @brief 稀疏索引项 */
+	struct Block
+	{
+		/** @brief 块中第一个微秒时间戳 */
+		int64 first;
+		/** @brief 块在位流中的起始位置 */
+		uint64_t bitOffset;
+	};
+
+public:
+	/** @brief 以每块的个数构造，块越小随机访问越快，压缩率越低 */
+	TimeColumn(size_t blockSize = 1024);
+	~TimeColumn();
+
+	/** @brief 追加微秒时间戳 */
+	void append(int64 stamp);
+	/** @brief 追加时间 */
+	void append(const Time & time);
+	/** @brief 清空 */
+	void clear();
+
+	/** @brief 个数 */
+	inline size_t size() const
+	{
+		return _size;
+	}
+
+	/** @brief 每块的个数 */
+	inline size_t blockSize() const
+	{
+		return _blockSize;
+	}
+
+	/** @brief 块数 */
+	inline size_t blockCount() const
+	{
+		return _blocks.size();
+	}
+
+	/** @brief 第index块的索引项 */
+	inline const Block & block(size_t index) const
+	{
+		return _blocks[index];
+	}
+
+	/** @brief 位流的长度，不含索引 */
+	inline uint64_t bits() const
+	{
+		return _bits;
+	}
+
+	/** @brief 压缩后的字节数，包含索引，不含预留的空间 */
+	size_t bytes() const;
+
+	/** @brief 第index个微秒时间戳，只解码所在块中它之前的部分 */
+	int64 at(size_t index) const;
+	/** @brief 第index个时间 */
+	Time time(size_t index) const;
+
+	/**
+	 * @brief 解码一块
+	 * @param out 输出数组，长度不小于blockSize()
+	 * @return 块中的个数
+	 */
+	size_t decodeBlock(size_t index, int64 * out) const;
+	/**
+	 * @brief 解码连续的一段
+	 * @param out 输出数组，长度不小于count
+	 * @return 实际解码的个数
+	 */
+	size_t decode(size_t begin, size_t count, int64 * out) const;
+
+	/**
+	 * @brief 第一个不小于stamp的位置，要求按时间升序追加
+	 * @details 先在稀疏索引中二分查找所在块，再解码该块
+	 * @return 都小于stamp时返回size()
+	 */
+	size_t lowerBound(int64 stamp) const;
+
+private:
+	void _write(uint64_t value, unsigned count);
+	size_t _decode(size_t index, size_t skip, size_t count, int64 * out) const;
+
+	size_t _blockSize;
+	size_t _size;
+	uint64_t _bits;
+	std::vector<uint64_t> _words;
+	std::vector<Block> _blocks;
+	int64 _last;
+	int64 _lastDelta;
+};
+
+} /* namespace ec */
+
+#endif /* INCLUDE_EC_TIMECOLUMN_H_ */
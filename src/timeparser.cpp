@@ -0,0 +1,702 @@
+﻿/*
+ * timeparser.cpp
+ *
+ *  Created on: 2026年10月19日
+ *      Author: havesnag
+ */
+
+#include "timeparser.h"
+#include "zone.h"
+#include <string.h>
+using namespace std;
+
+namespace ec
+{
+
+const int64 TimeParser::Invalid;
+
+namespace
+{
+
+/** @brief 名称表的一项，key为前三个字母的小写，低字节为第一个字母 */
+struct Name
+{
+	uint32_t key;
+	const char * full;
+	int value;
+};
+
+/**
+ * @brief 月份名的完美哈希表
+ * @details 下标为 (key * 61) >> 15 & 15，由离线搜索得到，12个名称互不冲突
+ */
+const Name MonthNames[16] =
+{
+	{0x706573, "september", 9}, {0x766f6e, "november", 11}, {0x72616d, "march", 3}, {0x6e756a, "june", 6},
+	{0x626566, "february", 2}, {0, NULL, 0}, {0, NULL, 0}, {0x74636f, "october", 10},
+	{0x79616d, "may", 5}, {0x727061, "april", 4}, {0x6e616a, "january", 1}, {0, NULL, 0},
+	{0, NULL, 0}, {0x677561, "august", 8}, {0x636564, "december", 12}, {0x6c756a, "july", 7},
+};
+
+/** @brief 星期名的完美哈希表，下标为 (key * 23) >> 14 & 7 */
+const Name WeekNames[8] =
+{
+	{0x6e6f6d, "monday", 1}, {0x756874, "thursday", 4}, {0x6e7573, "sunday", 7}, {0x746173, "saturday", 6},
+	{0x646577, "wednesday", 3}, {0x697266, "friday", 5}, {0x657574, "tuesday", 2}, {0, NULL, 0},
+};
+
+int lookupName(const Name * table, uint32_t multiplier, int shift, uint32_t mask,
+	const char * name, size_t length)
+{
+	if (length < 3)
+	{
+		return 0;
+	}
+
+	const uint32_t key = (static_cast<uint32_t>(static_cast<unsigned char>(name[0]))
+		| static_cast<uint32_t>(static_cast<unsigned char>(name[1])) << 8
+		| static_cast<uint32_t>(static_cast<unsigned char>(name[2])) << 16) | 0x202020u;
+	const Name & entry = table[(key * multiplier) >> shift & mask];
+	if (entry.key != key)
+	{
+		return 0;
+	}
+
+	// 缩写或全称
+	if (length > 3)
+	{
+		if (length != strlen(entry.full))
+		{
+			return 0;
+		}
+		for (size_t i = 3; i < length; ++i)
+		{
+			if ((name[i] | 0x20) != entry.full[i])
+			{
+				return 0;
+			}
+		}
+	}
+	return entry.value;
+}
+
+inline bool isDigit(char c)
+{
+	return c >= '0' && c <= '9';
+}
+
+inline bool isAlpha(char c)
+{
+	return (c | 0x20) >= 'a' && (c | 0x20) <= 'z';
+}
+
+inline bool isSpace(char c)
+{
+	return ' ' == c || '\t' == c;
+}
+
+/** @brief 与大写的名称比较，不区分大小写 */
+inline bool sameName(const char * name, size_t length, const char * upper)
+{
+	size_t i = 0;
+	for (; i < length && '\0' != upper[i]; ++i)
+	{
+		if ((name[i] & ~0x20) != upper[i])
+		{
+			return false;
+		}
+	}
+	return i == length && '\0' == upper[i];
+}
+
+/** @brief 解析出的各个字段 */
+struct Fields
+{
+	int year;
+	int month;
+	int day;
+	int hour;
+	int minute;
+	int second;
+	int micro;
+	/** @brief 是否带有时区偏移 */
+	bool hasOffset;
+	/** @brief 时区偏移的秒数，UTC+8为28800 */
+	int offset;
+
+	Fields() : year(1970), month(1), day(1), hour(0), minute(0), second(0), micro(0), hasOffset(false), offset(0)
+	{
+	}
+};
+
+/** @brief 输入的游标 */
+class Reader
+{
+public:
+	Reader(const char * p, const char * end) : p(p), end(end)
+	{
+	}
+
+	inline bool has(size_t n) const
+	{
+		return static_cast<size_t>(end - p) >= n;
+	}
+
+	inline char peek() const
+	{
+		return (p < end) ? *p : '\0';
+	}
+
+	inline bool expect(char c)
+	{
+		if (p < end && c == *p)
+		{
+			++p;
+			return true;
+		}
+		return false;
+	}
+
+	/** @brief 跳过空白，返回跳过的个数 */
+	inline size_t spaces()
+	{
+		const char * begin = p;
+		while (p < end && isSpace(*p))
+		{
+			++p;
+		}
+		return static_cast<size_t>(p - begin);
+	}
+
+	/** @brief 读取固定位数的数字 */
+	inline bool fixed(int width, int & value)
+	{
+		if (!has(static_cast<size_t>(width)))
+		{
+			return false;
+		}
+		value = 0;
+		for (int i = 0; i < width; ++i)
+		{
+			if (!isDigit(p[i]))
+			{
+				return false;
+			}
+			value = value * 10 + (p[i] - '0');
+		}
+		p += width;
+		return true;
+	}
+
+	/** @brief 读取[minWidth,maxWidth]位数字，其后不能紧跟数字 */
+	inline bool number(int minWidth, int maxWidth, int & value)
+	{
+		const char * begin = p;
+		value = 0;
+		while (p < end && p - begin < maxWidth && isDigit(*p))
+		{
+			value = value * 10 + (*p++ - '0');
+		}
+		return (p - begin >= minWidth) && !isDigit(peek());
+	}
+
+	/** @brief 读取一个英文单词 */
+	inline size_t word(const char *& begin)
+	{
+		begin = p;
+		while (p < end && isAlpha(*p))
+		{
+			++p;
+		}
+		return static_cast<size_t>(p - begin);
+	}
+
+	/** @brief 小数部分，保留到微秒，多余的位数截断 */
+	inline bool fraction(int & micro)
+	{
+		if (!isDigit(peek()))
+		{
+			return false;
+		}
+		micro = 0;
+		int digits = 0;
+		while (p < end && isDigit(*p))
+		{
+			if (digits < 6)
+			{
+				micro = micro * 10 + (*p - '0');
+				++digits;
+			}
+			++p;
+		}
+		for (; digits < 6; ++digits)
+		{
+			micro *= 10;
+		}
+		return true;
+	}
+
+	/** @brief 时间结束的位置不能紧跟字母或数字 */
+	inline bool boundary() const
+	{
+		return p >= end || (!isDigit(*p) && !isAlpha(*p));
+	}
+
+	const char * p;
+	const char * end;
+};
+
+/** @brief HH:MM[:SS] */
+bool readClock(Reader & r, Fields & f, bool requireSeconds)
+{
+	if (!r.fixed(2, f.hour) || !r.expect(':') || !r.fixed(2, f.minute))
+	{
+		return false;
+	}
+	if (r.expect(':'))
+	{
+		return r.fixed(2, f.second);
+	}
+	return !requireSeconds;
+}
+
+/** @brief RFC 2822的时区，+hhmm或名称 */
+bool readMailZone(Reader & r, Fields & f)
+{
+	const char sign = r.peek();
+	if ('+' == sign || '-' == sign)
+	{
+		++r.p;
+		int value = 0;
+		if (!r.fixed(4, value) || value / 100 > 23 || value % 100 > 59)
+		{
+			return false;
+		}
+		f.hasOffset = true;
+		f.offset = (value / 100 * 3600 + value % 100 * 60) * ('-' == sign ? -1 : 1);
+		return true;
+	}
+
+	const char * name = NULL;
+	const size_t length = r.word(name);
+	static const struct
+	{
+		const char * name;
+		int hours;
+	} zones[] =
+	{
+		{"GMT", 0}, {"UT", 0}, {"UTC", 0}, {"Z", 0},
+		{"EST", -5}, {"EDT", -4}, {"CST", -6}, {"CDT", -5},
+		{"MST", -7}, {"MDT", -6}, {"PST", -8}, {"PDT", -7},
+	};
+	for (size_t i = 0; i < sizeof(zones) / sizeof(zones[0]); ++i)
+	{
+		if (sameName(name, length, zones[i].name))
+		{
+			f.hasOffset = true;
+			f.offset = zones[i].hours * 3600;
+			return true;
+		}
+	}
+	return false;
+}
+
+/** @brief Sun, 06 Nov 1994 08:49:37 GMT，位置固定 */
+bool parseRfc1123(Reader & r, Fields & f)
+{
+	if (!r.has(29))
+	{
+		return false;
+	}
+	const char * p = r.p;
+	if (',' != p[3] || ' ' != p[4] || ' ' != p[7] || ' ' != p[11] || ' ' != p[16] || ' ' != p[25]
+		|| 0 != memcmp(p + 26, "GMT", 3) || 0 == TimeParser::weekDay(p, 3))
+	{
+		return false;
+	}
+	f.month = TimeParser::month(p + 8, 3);
+	r.p += 5;
+	if (0 == f.month || !r.fixed(2, f.day))
+	{
+		return false;
+	}
+	r.p += 5;
+	if (!r.fixed(4, f.year) || !r.expect(' ') || !readClock(r, f, true))
+	{
+		return false;
+	}
+	r.p += 4;
+	f.hasOffset = true;
+	return true;
+}
+
+/** @brief [Sun, ]6 Nov [19]94 08:49[:37] +0000 */
+bool parseRfc2822(Reader & r, Fields & f)
+{
+	const char * name = NULL;
+	size_t length = r.word(name);
+	if (length > 0)
+	{
+		if (0 == TimeParser::weekDay(name, length) || !r.expect(','))
+		{
+			return false;
+		}
+		r.spaces();
+	}
+
+	if (!r.number(1, 2, f.day) || 0 == r.spaces())
+	{
+		return false;
+	}
+	length = r.word(name);
+	f.month = TimeParser::month(name, length);
+	if (0 == f.month || 0 == r.spaces())
+	{
+		return false;
+	}
+
+	const char * yearBegin = r.p;
+	if (!r.number(2, 4, f.year))
+	{
+		return false;
+	}
+	// 两位的年份按RFC 2822的规则补全
+	const long yearDigits = r.p - yearBegin;
+	f.year += (2 == yearDigits) ? ((f.year < 50) ? 2000 : 1900) : ((3 == yearDigits) ? 1900 : 0);
+
+	return 0 != r.spaces() && readClock(r, f, false) && 0 != r.spaces() && readMailZone(r, f);
+}
+
+/** @brief Sun Nov  6 08:49:37 1994 */
+bool parseAsctime(Reader & r, Fields & f)
+{
+	const char * name = NULL;
+	size_t length = r.word(name);
+	if (0 == TimeParser::weekDay(name, length) || 0 == r.spaces())
+	{
+		return false;
+	}
+	length = r.word(name);
+	f.month = TimeParser::month(name, length);
+	if (0 == f.month || 0 == r.spaces() || !r.number(1, 2, f.day) || 0 == r.spaces()
+		|| !readClock(r, f, true) || 0 == r.spaces())
+	{
+		return false;
+	}
+	f.hasOffset = true;
+	return r.fixed(4, f.year);
+}
+
+/** @brief YYYY-MM-DD[<separator>HH:MM[:SS[.ffffff]][Z|+hh[:mm]]] */
+bool parseCivil(Reader & r, Fields & f, char separator)
+{
+	if (!r.fixed(4, f.year) || !r.expect('-') || !r.fixed(2, f.month) || !r.expect('-') || !r.fixed(2, f.day))
+	{
+		return false;
+	}
+
+	const char c = r.peek();
+	const bool matched = ('T' == separator) ? ('T' == c || 't' == c) : (separator == c);
+	if (!matched)
+	{
+		// ISO 8601可以只有日期，但不能是Date::toString()的形式
+		return 'T' == separator && !(' ' == c && r.has(2) && isDigit(r.p[1]));
+	}
+	++r.p;
+	if (!readClock(r, f, 'T' != separator))
+	{
+		return false;
+	}
+	if ((r.expect('.') || r.expect(',')) && !r.fraction(f.micro))
+	{
+		return false;
+	}
+
+	const char sign = r.peek();
+	if ('Z' == sign || 'z' == sign)
+	{
+		++r.p;
+		f.hasOffset = true;
+	}
+	else if ('+' == sign || '-' == sign)
+	{
+		++r.p;
+		int hours = 0, minutes = 0;
+		if (!r.fixed(2, hours))
+		{
+			return false;
+		}
+		if (r.expect(':') ? !r.fixed(2, minutes) : (isDigit(r.peek()) && !r.fixed(2, minutes)))
+		{
+			return false;
+		}
+		if (hours > 23 || minutes > 59)
+		{
+			return false;
+		}
+		f.hasOffset = true;
+		f.offset = (hours * 3600 + minutes * 60) * ('-' == sign ? -1 : 1);
+	}
+	return true;
+}
+
+/** @brief 时间戳，位数在[minDigits,maxDigits]内，scale为每单位的微秒数 */
+bool parseEpoch(Reader & r, int minDigits, int maxDigits, int64 scale, int64 & micro)
+{
+	const bool negative = r.expect('-');
+	const char * begin = r.p;
+	int64 value = 0;
+	while (r.p < r.end && isDigit(*r.p) && r.p - begin <= maxDigits)
+	{
+		value = value * 10 + (*r.p++ - '0');
+	}
+	const long digits = r.p - begin;
+	if (digits < minDigits || digits > maxDigits)
+	{
+		return false;
+	}
+
+	micro = value * scale;
+	int fraction = 0;
+	if (1000000 == scale && '.' == r.peek() && r.has(2) && isDigit(r.p[1]))
+	{
+		++r.p;
+		r.fraction(fraction);
+	}
+	micro = negative ? -(micro + fraction) : (micro + fraction);
+	// 避免把日期或时刻的开头当成时间戳
+	const char c = r.peek();
+	return r.boundary() && '-' != c && ':' != c && '/' != c && '.' != c;
+}
+
+} /* namespace */
+
+TimeParser::TimeParser(const Zone * zone)
+	: _zone(zone), _last(Unknown), _hits(0), _misses(0)
+{
+}
+
+TimeParser::~TimeParser()
+{
+}
+
+int64 TimeParser::parse(const char * data, size_t size, size_t * used)
+{
+	// 时间戳只看位数，短的时间戳与RFC 2822的日(如"6 Nov")无法区分，须先确认开头仍是时间戳
+	if (Unknown != _last && (_last < EpochSeconds || detect(data, size) == _last))
+	{
+		const int64 result = parseAs(_last, data, size, used);
+		if (Invalid != result)
+		{
+			++_hits;
+			return result;
+		}
+	}
+
+	++_misses;
+	const Format format = detect(data, size);
+	if (Unknown == format || format == _last)
+	{
+		return Invalid;
+	}
+
+	const int64 result = parseAs(format, data, size, used);
+	if (Invalid != result)
+	{
+		_last = format;
+	}
+	return result;
+}
+
+int64 TimeParser::parse(const char * text, size_t * used)
+{
+	return parse(text, strlen(text), used);
+}
+
+bool TimeParser::parse(const std::string & text, Time & time)
+{
+	const int64 result = parse(text.data(), text.size());
+	if (Invalid == result)
+	{
+		return false;
+	}
+	time.setMicroStamp(result);
+	return true;
+}
+
+int64 TimeParser::parseAs(Format format, const char * data, size_t size, size_t * used) const
+{
+	Reader r(data, data + size);
+	r.spaces();
+
+	Fields f;
+	int64 micro = 0;
+	bool ok = false;
+	switch (format)
+	{
+	case Rfc1123:
+		ok = parseRfc1123(r, f);
+		break;
+	case Rfc2822:
+		ok = parseRfc2822(r, f);
+		break;
+	case Asctime:
+		ok = parseAsctime(r, f);
+		break;
+	case DateString:
+		ok = parseCivil(r, f, ' ');
+		break;
+	case Iso8601:
+		ok = parseCivil(r, f, 'T');
+		break;
+	case EpochSeconds:
+		ok = parseEpoch(r, 1, 11, 1000000, micro);
+		break;
+	case EpochMillis:
+		ok = parseEpoch(r, 12, 14, 1000, micro);
+		break;
+	case EpochMicros:
+		ok = parseEpoch(r, 15, 17, 1, micro);
+		break;
+	default:
+		break;
+	}
+
+	if (!ok)
+	{
+		return Invalid;
+	}
+
+	if (format < EpochSeconds)
+	{
+		if (!r.boundary() || f.month < 1 || f.month > 12 || f.day < 1 || f.day > Calendar::monthDays(f.year, f.month)
+			|| f.hour > 23 || f.minute > 59 || f.second > 60)
+		{
+			return Invalid;
+		}
+
+		const int64 local = Calendar::stamp(f.year, f.month, f.day, f.hour, f.minute, f.second);
+		int64 stamp = 0;
+		if (f.hasOffset)
+		{
+			stamp = local - f.offset;
+		}
+		else
+		{
+			stamp = static_cast<int64>((NULL != _zone) ? _zone->localToUTC(static_cast<time_t>(local))
+				: Date::localToUTC(static_cast<time_t>(local)));
+		}
+		micro = stamp * 1000000 + f.micro;
+	}
+
+	if (NULL != used)
+	{
+		*used = static_cast<size_t>(r.p - data);
+	}
+	return micro;
+}
+
+TimeParser::Format TimeParser::detect(const char * data, size_t size)
+{
+	Reader r(data, data + size);
+	r.spaces();
+	const char * p = r.p;
+	const size_t left = static_cast<size_t>(r.end - p);
+	if (0 == left)
+	{
+		return Unknown;
+	}
+
+	if (isDigit(p[0]))
+	{
+		size_t digits = 1;
+		while (digits < left && isDigit(p[digits]))
+		{
+			++digits;
+		}
+		const char next = (digits < left) ? p[digits] : '\0';
+
+		if (4 == digits && '-' == next)
+		{
+			// 第10个字节之后是日期与时刻的分隔
+			const char separator = (left > 10) ? p[10] : '\0';
+			return (' ' == separator && left > 11 && isDigit(p[11])) ? DateString : Iso8601;
+		}
+		if (digits <= 2 && isSpace(next))
+		{
+			return Rfc2822;
+		}
+		if ('-' == next || ':' == next)
+		{
+			return Unknown;
+		}
+		return (digits <= 11) ? EpochSeconds : ((digits <= 14) ? EpochMillis : ((digits <= 17) ? EpochMicros : Unknown));
+	}
+
+	if ('-' == p[0])
+	{
+		return (left > 1 && isDigit(p[1])) ? EpochSeconds : Unknown;
+	}
+
+	if (isAlpha(p[0]))
+	{
+		const char * name = NULL;
+		const size_t length = r.word(name);
+		const char next = r.peek();
+		if (',' == next)
+		{
+			// 只有固定的29个字节的形式才走RFC 1123
+			return (3 == length && left >= 29 && ' ' == p[7] && ' ' == p[11] && 0 == memcmp(p + 26, "GMT", 3))
+				? Rfc1123 : Rfc2822;
+		}
+		if (isSpace(next))
+		{
+			return Asctime;
+		}
+	}
+	return Unknown;
+}
+
+const char * TimeParser::formatName(Format format)
+{
+	switch (format)
+	{
+	case Rfc1123:
+		return "RFC1123";
+	case Rfc2822:
+		return "RFC2822";
+	case Asctime:
+		return "asctime";
+	case DateString:
+		return "DateString";
+	case Iso8601:
+		return "ISO8601";
+	case EpochSeconds:
+		return "EpochSeconds";
+	case EpochMillis:
+		return "EpochMillis";
+	case EpochMicros:
+		return "EpochMicros";
+	default:
+		return "Unknown";
+	}
+}
+
+int TimeParser::month(const char * name, size_t length)
+{
+	return lookupName(MonthNames, 61, 15, 15, name, length);
+}
+
+int TimeParser::weekDay(const char * name, size_t length)
+{
+	return lookupName(WeekNames, 23, 14, 7, name, length);
+}
+
+void TimeParser::reset()
+{
+	_last = Unknown;
+	_hits = 0;
+	_misses = 0;
+}
+
+} /* namespace ec */
@@ -0,0 +1,128 @@
+﻿/*
+ * timeparser.h
+ *
+ *  Created on: 2026年10月19日
+ *      Author: havesnag
+ */
+
+#ifndef INCLUDE_EC_TIMEPARSER_H_
+#define INCLUDE_EC_TIMEPARSER_H_
+
+#include "date.h"
+#include <stddef.h>
+#include <string>
+
+namespace ec
+{
+
+/**
+ * @brief 多种格式的时间解析，自动识别格式
+ * @details
+ *     根据开头的几个字节识别格式，并记住上一次成功的格式，同一来源的后续输入直接按该格式解析，
+ *     失败时才重新识别。不使用strptime，英文的月份和星期名按完美哈希查表，不区分大小写。
+ *     时间之后可以有其他内容，解析的长度由used返回。没有时区偏移的格式按构造时的时区计算，
+ *     zone为NULL时按系统时区计算，含夏令时，与Date的构造一致，重叠的时间取较早的时刻。
+ *     每个对象保存一个来源的状态，不是线程安全的，不同的来源(文件、连接)应使用各自的对象。
+ * @code
+ * TimeParser parser;
+ * parser.parse("Sun, 06 Nov 1994 08:49:37 GMT"); // 784111777000000
+ * parser.parse("2024-05-01T08:00:00.250+08:00"); // 1714521600250000
+ * parser.parse("1714521600123");                 // 1714521600123000
+ * @endcode
+ */
+class TimeParser
+{
+public:
+	/** @brief 解析失败时返回的值 */
+	static const int64 Invalid = INT64_MIN;
+
+	enum Format
+	{
+		Unknown = 0,
+		/** @brief RFC 1123，HTTP的日期，Sun, 06 Nov 1994 08:49:37 GMT */
+		Rfc1123,
+		/** @brief RFC 2822，星期和秒可省略，年可以是两位，Sun, 6 Nov 1994 08:49:37 +0800 */
+		Rfc2822,
+		/** @brief C标准库asctime的格式，HTTP也接受，Sun Nov  6 08:49:37 1994，按UTC计算 */
+		Asctime,
+		/** @brief Date::toString()的格式，1994-11-06 08:49:37，可带小数秒和时区偏移 */
+		DateString,
+		/** @brief ISO 8601，1994-11-06T08:49:37.123Z，秒、小数秒和时区偏移可省略，也可以只有日期 */
+		Iso8601,
+		/** @brief 秒数时间戳，不超过11位整数，可带小数 */
+		EpochSeconds,
+		/** @brief 毫秒时间戳，12到14位 */
+		EpochMillis,
+		/** @brief 微秒时间戳，15到17位 */
+		EpochMicros,
+	};
+
+	/** @brief zone用于没有时区偏移的格式 */
+	explicit TimeParser(const Zone * zone = NULL);
+	~TimeParser();
+
+	/**
+	 * @brief 解析开头的时间
+	 * @param used 不为NULL时返回解析的长度，包括开头的空白
+	 * @return 微秒时间戳，失败时为Invalid
+	 */
+	int64 parse(const char * data, size_t size, size_t * used = NULL);
+	/** @brief 解析以'\0'结尾的字符串 @see parse */
+	int64 parse(const char * text, size_t * used = NULL);
+	/** @brief 解析到Time，失败时time不变 @see parse */
+	bool parse(const std::string & text, Time & time);
+
+	/** @brief 按指定的格式解析，不识别也不改变记住的格式 @see parse */
+	int64 parseAs(Format format, const char * data, size_t size, size_t * used = NULL) const;
+
+	/** @brief 根据开头的字节识别格式，无法识别时为Unknown */
+	static Format detect(const char * data, size_t size);
+
+	/** @brief 格式的名称 */
+	static const char * formatName(Format format);
+
+	/**
+	 * @brief 英文月份名的缩写或全称，不区分大小写
+	 * @return [1,12]，不是月份名时为0
+	 */
+	static int month(const char * name, size_t length);
+	/**
+	 * @brief 英文星期名的缩写或全称，不区分大小写
+	 * @return [1,7]，1为星期一，不是星期名时为0
+	 */
+	static int weekDay(const char * name, size_t length);
+
+	/** @brief 上一次成功的格式 */
+	inline Format last() const
+	{
+		return _last;
+	}
+
+	/** @brief 按记住的格式直接解析成功的次数 */
+	inline size_t hits() const
+	{
+		return _hits;
+	}
+
+	/** @brief 重新识别格式的次数 */
+	inline size_t misses() const
+	{
+		return _misses;
+	}
+
+	/** @brief 忘记记住的格式，清空计数 */
+	void reset();
+
+private:
+	TimeParser(const TimeParser &);
+	TimeParser & operator=(const TimeParser &);
+
+	const Zone * _zone;
+	Format _last;
+	size_t _hits;
+	size_t _misses;
+};
+
+} /* namespace ec */
+
+#endif /* INCLUDE_EC_TIMEPARSER_H_ */
@@ -0,0 +1,502 @@
+﻿/*
+ * timerange.cpp
+ *
+ *  Created on: 2026年10月19日
+ *      Author: havesnag
+ */
+
+#include "timerange.h"
+#include <algorithm>
+using namespace std;
+
+namespace ec
+{
+
+namespace
+{
+
+inline Time timeFromMicroStamp(int64 stamp)
+{
+	Time time(0);
+	time.setMicroStamp(stamp);
+	return time;
+}
+
+/** @brief 排序用的区间 */
+struct Entry
+{
+	int64 begin;
+	int64 end;
+	size_t id;
+
+	inline bool operator < (const Entry & other) const
+	{
+		return (begin != other.begin) ? (begin < other.begin) : (end < other.end);
+	}
+};
+
+/**
+ * @brief 收集编号
+ * @details 先预留空间，再无条件写入并按是否匹配移动位置，避免扫描时的分支预测失败
+ */
+struct Collector
+{
+	const std::vector<size_t> & ids;
+	std::vector<size_t> & out;
+	size_t size;
+	size_t count;
+
+	Collector(const std::vector<size_t> & ids, std::vector<size_t> & out)
+		: ids(ids), out(out), size(out.size()), count(0)
+	{
+	}
+
+	inline void prepare(size_t count)
+	{
+		if (out.size() < size + count)
+		{
+			out.resize(std::max(out.size() * 2, size + count));
+		}
+	}
+
+	inline void operator () (size_t index, bool matched)
+	{
+		out[size] = ids[index];
+		size += matched ? 1 : 0;
+		count += matched ? 1 : 0;
+	}
+
+	inline void finish()
+	{
+		out.resize(size);
+	}
+};
+
+/** @brief 计数 */
+struct Counter
+{
+	size_t count;
+
+	Counter() : count(0)
+	{
+	}
+
+	inline void prepare(size_t)
+	{
+	}
+
+	inline void operator () (size_t, bool matched)
+	{
+		count += matched ? 1 : 0;
+	}
+
+	inline void finish()
+	{
+	}
+};
+
+/** @brief 收集完全包含某个区间的编号 */
+template <typename Node>
+struct ContainCollector
+{
+	const std::vector<Node> & nodes;
+	Collector collector;
+	int64 begin;
+	int64 end;
+
+	ContainCollector(const std::vector<Node> & nodes, const std::vector<size_t> & ids,
+		std::vector<size_t> & out, int64 begin, int64 end)
+		: nodes(nodes), collector(ids, out), begin(begin), end(end)
+	{
+	}
+
+	inline void prepare(size_t count)
+	{
+		collector.prepare(count);
+	}
+
+	inline void operator () (size_t index, bool matched)
+	{
+		collector(index, matched && nodes[index].begin <= begin && nodes[index].end >= end);
+	}
+
+	inline void finish()
+	{
+		collector.finish();
+	}
+};
+
+} /* namespace */
+
+TimeRange::TimeRange() : _begin(0), _end(0)
+{
+}
+
+TimeRange::TimeRange(int64 begin, int64 end) : _begin(begin), _end(end)
+{
+}
+
+TimeRange::TimeRange(const Time & begin, const Time & end) : _begin(begin.microStamp()), _end(end.microStamp())
+{
+}
+
+TimeRange::TimeRange(const Time & begin, const Duration & length)
+	: _begin(begin.microStamp()), _end(begin.microStamp() + length.valueAs(Duration::MicroSecond))
+{
+}
+
+Time TimeRange::begin() const
+{
+	return timeFromMicroStamp(_begin);
+}
+
+Time TimeRange::end() const
+{
+	return timeFromMicroStamp(_end);
+}
+
+Duration TimeRange::length() const
+{
+	return Duration(empty() ? 0 : _end - _begin, Duration::MicroSecond);
+}
+
+bool TimeRange::contains(const Time & time) const
+{
+	return contains(time.microStamp());
+}
+
+bool TimeRange::contains(const TimeRange & other) const
+{
+	return other.empty() || (_begin <= other._begin && other._end <= _end);
+}
+
+bool TimeRange::overlaps(const TimeRange & other) const
+{
+	return !empty() && !other.empty() && _begin < other._end && other._begin < _end;
+}
+
+TimeRange TimeRange::intersection(const TimeRange & other) const
+{
+	if (!overlaps(other))
+	{
+		return TimeRange();
+	}
+	return TimeRange(std::max(_begin, other._begin), std::min(_end, other._end));
+}
+
+TimeRange TimeRange::unite(const TimeRange & other) const
+{
+	if (empty())
+	{
+		return other;
+	}
+	if (other.empty())
+	{
+		return *this;
+	}
+	return TimeRange(std::min(_begin, other._begin), std::max(_end, other._end));
+}
+
+TimeRange TimeRange::gap(const TimeRange & other) const
+{
+	if (empty() || other.empty())
+	{
+		return TimeRange();
+	}
+
+	const int64 begin = std::min(_end, other._end);
+	const int64 end = std::max(_begin, other._begin);
+	return (begin < end) ? TimeRange(begin, end) : TimeRange();
+}
+
+bool TimeRange::operator == (const TimeRange & other) const
+{
+	return _begin == other._begin && _end == other._end;
+}
+
+bool TimeRange::operator != (const TimeRange & other) const
+{
+	return !(*this == other);
+}
+
+bool TimeRange::operator < (const TimeRange & other) const
+{
+	return (_begin != other._begin) ? (_begin < other._begin) : (_end < other._end);
+}
+
+TimeRangeIndex::TimeRangeIndex() : _levels(0), _built(true)
+{
+}
+
+TimeRangeIndex::~TimeRangeIndex()
+{
+}
+
+void TimeRangeIndex::reserve(size_t count)
+{
+	_nodes.reserve(count);
+	_ids.reserve(count);
+}
+
+size_t TimeRangeIndex::add(const TimeRange & range)
+{
+	// build之后再添加时，编号仍为添加的顺序
+	const size_t id = _nodes.size();
+	const Node node = {range.beginStamp(), range.endStamp(), range.endStamp()};
+	_nodes.push_back(node);
+	_ids.push_back(id);
+	_built = false;
+	return id;
+}
+
+void TimeRangeIndex::assign(const TimeRange * ranges, size_t count)
+{
+	_nodes.resize(count);
+	_ids.resize(count);
+	for (size_t i = 0; i < count; ++i)
+	{
+		_nodes[i].begin = ranges[i].beginStamp();
+		_nodes[i].end = ranges[i].endStamp();
+		_ids[i] = i;
+	}
+	_built = false;
+	build();
+}
+
+void TimeRangeIndex::clear()
+{
+	_nodes.clear();
+	_ids.clear();
+	_levels = 0;
+	_built = true;
+}
+
+void TimeRangeIndex::build()
+{
+	if (_built)
+	{
+		return;
+	}
+
+	const size_t count = _nodes.size();
+	bool sorted = true;
+	for (size_t i = 1; i < count && sorted; ++i)
+	{
+		const Node & prev = _nodes[i - 1];
+		sorted = (prev.begin < _nodes[i].begin) || (prev.begin == _nodes[i].begin && prev.end <= _nodes[i].end);
+	}
+
+	if (!sorted)
+	{
+		std::vector<Entry> entries(count);
+		for (size_t i = 0; i < count; ++i)
+		{
+			entries[i].begin = _nodes[i].begin;
+			entries[i].end = _nodes[i].end;
+			entries[i].id = _ids[i];
+		}
+		std::sort(entries.begin(), entries.end());
+		for (size_t i = 0; i < count; ++i)
+		{
+			_nodes[i].begin = entries[i].begin;
+			_nodes[i].end = entries[i].end;
+			_ids[i] = entries[i].id;
+		}
+	}
+
+	_augment();
+	_built = true;
+}
+
+size_t TimeRangeIndex::overlaps(const TimeRange & range, std::vector<size_t> & out) const
+{
+	Collector collector(_ids, out);
+	_visit(range.beginStamp(), range.endStamp(), collector);
+	return collector.count;
+}
+
+size_t TimeRangeIndex::countOverlaps(const TimeRange & range) const
+{
+	Counter counter;
+	_visit(range.beginStamp(), range.endStamp(), counter);
+	return counter.count;
+}
+
+size_t TimeRangeIndex::stab(const Time & time, std::vector<size_t> & out) const
+{
+	return stab(time.microStamp(), out);
+}
+
+size_t TimeRangeIndex::stab(int64 stamp, std::vector<size_t> & out) const
+{
+	Collector collector(_ids, out);
+	_visit(stamp, stamp + 1, collector);
+	return collector.count;
+}
+
+size_t TimeRangeIndex::containing(const TimeRange & range, std::vector<size_t> & out) const
+{
+	// 空区间按其开始时刻查询
+	const int64 begin = range.beginStamp();
+	const int64 end = std::max(range.endStamp(), begin + 1);
+	ContainCollector<Node> collector(_nodes, _ids, out, begin, range.endStamp());
+	_visit(begin, end, collector);
+	return collector.collector.count;
+}
+
+size_t TimeRangeIndex::within(const TimeRange & range, std::vector<size_t> & out) const
+{
+	// 二分查找第一个开始不早于range的节点
+	size_t first = 0;
+	for (size_t size = _nodes.size(); size > 0; )
+	{
+		const size_t half = size / 2;
+		if (_nodes[first + half].begin < range.beginStamp())
+		{
+			first += half + 1;
+			size -= half + 1;
+		}
+		else
+		{
+			size = half;
+		}
+	}
+
+	size_t count = 0;
+	for (size_t i = first; i < _nodes.size() && _nodes[i].begin < range.endStamp(); ++i)
+	{
+		if (_nodes[i].begin < _nodes[i].end && _nodes[i].end <= range.endStamp())
+		{
+			out.push_back(_ids[i]);
+			++count;
+		}
+	}
+	return count;
+}
+
+size_t TimeRangeIndex::conflicts(std::vector<std::pair<size_t, size_t> > & out) const
+{
+	size_t count = 0;
+	const size_t size = _nodes.size();
+	for (size_t i = 0; i < size; ++i)
+	{
+		const Node & node = _nodes[i];
+		if (node.begin >= node.end)
+		{
+			continue;
+		}
+
+		// 开始时间不早于i且早于i结束的非空区间都与i重叠
+		for (size_t j = i + 1; j < size && _nodes[j].begin < node.end; ++j)
+		{
+			if (_nodes[j].begin < _nodes[j].end)
+			{
+				out.push_back(std::make_pair(_ids[i], _ids[j]));
+				++count;
+			}
+		}
+	}
+	return count;
+}
+
+void TimeRangeIndex::_augment()
+{
+	const size_t count = _nodes.size();
+	_levels = 0;
+	if (0 == count)
+	{
+		return;
+	}
+
+	// 偶数位置为叶子，第k层的节点i的子节点为i - 2^(k-1)和i + 2^(k-1)，
+	// 右子树超出末尾时用最后一个存在的节点的值代替
+	size_t lastIndex = 0;
+	for (size_t i = 0; i < count; ++i)
+	{
+		_nodes[i].maxEnd = _nodes[i].end;
+		lastIndex = (0 == (i & 1)) ? i : lastIndex;
+	}
+
+	int64 last = _nodes[lastIndex].maxEnd;
+	int level = 1;
+	for (; (static_cast<size_t>(1) << level) <= count; ++level)
+	{
+		const size_t half = static_cast<size_t>(1) << (level - 1);
+		const size_t step = half << 2;
+		for (size_t i = (half << 1) - 1; i < count; i += step)
+		{
+			const int64 left = _nodes[i - half].maxEnd;
+			const int64 right = (i + half < count) ? _nodes[i + half].maxEnd : last;
+			_nodes[i].maxEnd = std::max(_nodes[i].end, std::max(left, right));
+		}
+
+		lastIndex = ((lastIndex >> level) & 1) ? lastIndex - half : lastIndex + half;
+		if (lastIndex < count && _nodes[lastIndex].maxEnd > last)
+		{
+			last = _nodes[lastIndex].maxEnd;
+		}
+	}
+	_levels = level - 1;
+}
+
+template <typename Visitor>
+void TimeRangeIndex::_visit(int64 begin, int64 end, Visitor & visitor) const
+{
+	const size_t count = _nodes.size();
+	if (0 == count || begin >= end)
+	{
+		return;
+	}
+
+	struct Frame
+	{
+		int level;
+		size_t index;
+		bool leftDone;
+	};
+
+	const Node * nodes = &_nodes[0];
+
+	// 每层最多压入两个节点
+	Frame stack[128];
+	int top = 0;
+	const Frame root = {_levels, (static_cast<size_t>(1) << _levels) - 1, false};
+	stack[top++] = root;
+	while (top > 0)
+	{
+		const Frame frame = stack[--top];
+		if (frame.level <= 4)
+		{
+			// 子树较小时直接扫描
+			const size_t first = frame.index >> frame.level << frame.level;
+			const size_t last = std::min(first + (static_cast<size_t>(1) << (frame.level + 1)) - 1, count);
+			visitor.prepare(last - first);
+			for (size_t i = first; i < last && nodes[i].begin < end; ++i)
+			{
+				visitor(i, (begin < nodes[i].end) & (nodes[i].begin < nodes[i].end));
+			}
+		}
+		else if (!frame.leftDone)
+		{
+			const size_t left = frame.index - (static_cast<size_t>(1) << (frame.level - 1));
+			const Frame self = {frame.level, frame.index, true};
+			stack[top++] = self;
+			if (left >= count || nodes[left].maxEnd > begin)
+			{
+				const Frame child = {frame.level - 1, left, false};
+				stack[top++] = child;
+			}
+		}
+		else if (frame.index < count && nodes[frame.index].begin < end)
+		{
+			const Node & node = nodes[frame.index];
+			visitor.prepare(1);
+			visitor(frame.index, (begin < node.end) & (node.begin < node.end));
+			const Frame child = {frame.level - 1, frame.index + (static_cast<size_t>(1) << (frame.level - 1)), false};
+			stack[top++] = child;
+		}
+	}
+	visitor.finish();
+}
+
+} /* namespace ec */
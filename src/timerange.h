@@ -0,0 +1,175 @@
+﻿/*
+ * timerange.h
+ *
+ *  Created on: 2026年10月19日
+ *      Author: havesnag
+ */
+
+#ifndef INCLUDE_EC_TIMERANGE_H_
+#define INCLUDE_EC_TIMERANGE_H_
+
+#include "date.h"
+#include <stddef.h>
+#include <utility>
+#include <vector>
+
+namespace ec
+{
+
+/**
+ * @brief 时间区间[begin, end)，以微秒时间戳保存
+ * @details begin不小于end时为空区间，空区间不与任何区间重叠
+ */
+class TimeRange
+{
+public:
+	/** @brief 空区间 */
+	TimeRange();
+	/** @brief 以微秒时间戳构造 */
+	TimeRange(int64 begin, int64 end);
+	/** @brief 以开始和结束时间构造 */
+	TimeRange(const Time & begin, const Time & end);
+	/** @brief 以开始时间和长度构造 */
+	TimeRange(const Time & begin, const Duration & length);
+
+	/** @brief 开始的微秒时间戳 */
+	inline int64 beginStamp() const
+	{
+		return _begin;
+	}
+
+	/** @brief 结束的微秒时间戳，不包含 */
+	inline int64 endStamp() const
+	{
+		return _end;
+	}
+
+	/** @brief 开始时间 */
+	Time begin() const;
+	/** @brief 结束时间，不包含 */
+	Time end() const;
+	/** @brief 长度，单位为微秒，空区间为0 */
+	Duration length() const;
+
+	/** @brief 是否为空 */
+	inline bool empty() const
+	{
+		return _begin >= _end;
+	}
+
+	/** @brief 是否包含某个微秒时间戳 */
+	inline bool contains(int64 stamp) const
+	{
+		return _begin <= stamp && stamp < _end;
+	}
+
+	/** @brief 是否包含某个时间 */
+	bool contains(const Time & time) const;
+	/** @brief 是否完全包含other，空区间被任何区间包含 */
+	bool contains(const TimeRange & other) const;
+	/** @brief 是否重叠，首尾相接不算重叠 */
+	bool overlaps(const TimeRange & other) const;
+
+	/** @brief 交集，不重叠时为空区间 */
+	TimeRange intersection(const TimeRange & other) const;
+	/** @brief 覆盖两者的最小区间，不相交时包含两者之间的间隔，与空区间合并时为另一个 */
+	TimeRange unite(const TimeRange & other) const;
+	/** @brief 两者之间的间隔，重叠或相接时为空区间 */
+	TimeRange gap(const TimeRange & other) const;
+
+	bool operator == (const TimeRange & other) const;
+	bool operator != (const TimeRange & other) const;
+	/** @brief 先按开始再按结束比较 */
+	bool operator < (const TimeRange & other) const;
+
+private:
+	int64 _begin;
+	int64 _end;
+};
+
+/**
+ * @brief 时间区间的索引，查询与某个区间重叠或包含某个时刻的所有区间
+ * @details
+ *     按开始时间排序后以隐式的平衡二叉树组织(同cgranges)：第i个区间为树的一个节点，
+ *     每个节点额外保存子树中最大的结束时间，查询时跳过不可能重叠的子树，复杂度为O(log n + k)。
+ *     节点连续保存在一个数组中，没有指针，构建时只需一次排序，已排序的输入不再排序。
+ *     每个区间以添加的顺序编号，查询结果为这些编号。
+ * @note 添加之后须调用build再查询；build之后查询可以多线程同时进行
+ */
+class TimeRangeIndex
+{
+public:
+	TimeRangeIndex();
+	~TimeRangeIndex();
+
+	/** @brief 区间个数 */
+	inline size_t size() const
+	{
+		return _nodes.size();
+	}
+
+	/** @brief 预留空间 */
+	void reserve(size_t count);
+	/** @brief 添加一个区间，返回它的编号 */
+	size_t add(const TimeRange & range);
+	/** @brief 替换为一组区间，编号为数组下标，已按开始时间排序时不再排序，之后不必调用build */
+	void assign(const TimeRange * ranges, size_t count);
+	/** @brief 清空 */
+	void clear();
+	/** @brief 排序并构建索引 */
+	void build();
+
+	/**
+	 * @brief 查询与range重叠的区间
+	 * @param out 追加编号，顺序为区间开始时间的顺序
+	 * @return 个数
+	 */
+	size_t overlaps(const TimeRange & range, std::vector<size_t> & out) const;
+	/** @brief 与range重叠的区间个数 */
+	size_t countOverlaps(const TimeRange & range) const;
+	/** @brief 查询包含某个时刻的区间 */
+	size_t stab(const Time & time, std::vector<size_t> & out) const;
+	/** @brief 查询包含某个微秒时间戳的区间 */
+	size_t stab(int64 stamp, std::vector<size_t> & out) const;
+	/** @brief 查询完全包含range的区间 */
+	size_t containing(const TimeRange & range, std::vector<size_t> & out) const;
+	/** @brief 查询完全在range之内的非空区间 */
+	size_t within(const TimeRange & range, std::vector<size_t> & out) const;
+
+	/**
+	 * @brief 查询所有互相重叠的区间对
+	 * @details 按开始时间扫描，每个区间只与之后开始于它结束之前的区间比较，复杂度为O(n + k)
+	 * @param out 追加编号对，first的开始时间不晚于second
+	 * @return 对数
+	 */
+	size_t conflicts(std::vector<std::pair<size_t, size_t> > & out) const;
+
+private:
+	TimeRangeIndex(const TimeRangeIndex &);
+	TimeRangeIndex & operator = (const TimeRangeIndex &);
+
+	/** @brief 计算每个节点子树的最大结束时间 */
+	void _augment();
+	/** @brief 对与[begin, end)重叠的每个非空区间调用visitor(排序后的位置) */
+	template <typename Visitor>
+	void _visit(int64 begin, int64 end, Visitor & visitor) const;
+
+	/** @brief 树的节点，查询时只访问这一个数组 */
+	struct Node
+	{
+		int64 begin;
+		int64 end;
+		/** @brief 子树中最大的结束时间 */
+		int64 maxEnd;
+	};
+
+	std::vector<Node> _nodes;
+	std::vector<size_t> _ids;
+	/** @brief 树的层数 */
+	int _levels;
+	bool _built;
+};
+
+} /* namespace ec */
+
+#endif /* INCLUDE_EC_TIMERANGE_H_ */
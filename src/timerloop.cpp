@@ -0,0 +1,364 @@
+﻿/*
+ * timerloop.cpp
+ *
+ *  Created on: 2026年10月19日
+ *      Author: havesnag
+ */
+
+#include "timerloop.h"
+
+#if __cplusplus >= 202002L && defined(__linux__)
+
+#include <stdint.h>
+#include <sys/epoll.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+#include <algorithm>
+
+namespace ec
+{
+
+namespace
+{
+
+const size_t npos = static_cast<size_t>(-1);
+
+thread_local TimerLoop * running = NULL;
+thread_local TimerLoop * created = NULL;
+
+} /* namespace */
+
+TimerLoop::Waiter::Waiter(TimerLoop & loop, int64 deadline, Timer * timer)
+{
+	_loop = &loop;
+	_timer = timer;
+	_deadline = deadline;
+	_sequence = 0;
+	_index = npos;
+	_cancelled = false;
+}
+
+TimerLoop::Waiter::~Waiter()
+{
+	// 协程帧在等待中被销毁时从堆中移除
+	if (npos != _index)
+	{
+		_loop->_remove(this);
+	}
+	if (NULL != _timer && this == _timer->_waiter)
+	{
+		_timer->_waiter = NULL;
+	}
+}
+
+bool TimerLoop::Waiter::await_ready() const
+{
+	return _deadline <= steadyNanos();
+}
+
+void TimerLoop::Waiter::await_suspend(std::coroutine_handle<> handle)
+{
+	_handle = handle;
+	if (NULL != _timer)
+	{
+		// 同一个定时器的上一次等待被这一次取代
+		if (NULL != _timer->_waiter && this != _timer->_waiter)
+		{
+			_timer->cancel();
+		}
+		_timer->_waiter = this;
+	}
+	_loop->_push(this);
+}
+
+bool TimerLoop::Waiter::await_resume() const
+{
+	if (NULL != _timer && this == _timer->_waiter)
+	{
+		_timer->_waiter = NULL;
+	}
+	return !_cancelled;
+}
+
+
+TimerLoop::Timer::Timer(TimerLoop & loop)
+	: _loop(loop), _waiter(NULL)
+{
+}
+
+TimerLoop::Timer::~Timer()
+{
+	if (NULL != _waiter)
+	{
+		_waiter->_timer = NULL;
+		_loop._cancel(_waiter);
+	}
+}
+
+TimerLoop::Waiter TimerLoop::Timer::until(const Time & deadline)
+{
+	return Waiter(_loop, _steady(deadline), this);
+}
+
+TimerLoop::Waiter TimerLoop::Timer::after(const Duration & duration)
+{
+	return Waiter(_loop, steadyNanos() + duration.valueAs(Duration::MicroSecond) * 1000, this);
+}
+
+bool TimerLoop::Timer::cancel()
+{
+	if (NULL == _waiter)
+	{
+		return false;
+	}
+
+	Waiter * waiter = _waiter;
+	_waiter = NULL;
+	waiter->_timer = NULL;
+	_loop._cancel(waiter);
+	return true;
+}
+
+
+TimerLoop * TimerLoop::current()
+{
+	return (NULL != running) ? running : created;
+}
+
+int64 TimerLoop::steadyNanos()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return static_cast<int64>(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+}
+
+TimerLoop::TimerLoop()
+{
+	_epoll = epoll_create1(EPOLL_CLOEXEC);
+	_timer = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+	_armed = INT64_MAX;
+	_sequence = 0;
+	_stopped = false;
+
+	struct epoll_event event;
+	event.events = EPOLLIN;
+	event.data.fd = _timer;
+	epoll_ctl(_epoll, EPOLL_CTL_ADD, _timer, &event);
+
+	if (NULL == created)
+	{
+		created = this;
+	}
+}
+
+TimerLoop::~TimerLoop()
+{
+	for (size_t i = 0; i < _heap.size(); ++i)
+	{
+		_heap[i]->_index = npos;
+	}
+	if (this == created)
+	{
+		created = NULL;
+	}
+	close(_timer);
+	close(_epoll);
+}
+
+TimerLoop::Waiter TimerLoop::until(const Time & deadline)
+{
+	return Waiter(*this, _steady(deadline));
+}
+
+TimerLoop::Waiter TimerLoop::after(const Duration & duration)
+{
+	return Waiter(*this, steadyNanos() + duration.valueAs(Duration::MicroSecond) * 1000);
+}
+
+void TimerLoop::run()
+{
+	TimerLoop * previous = running;
+	running = this;
+	_stopped = false;
+	while (!_stopped && (!_heap.empty() || !_ready.empty()))
+	{
+		runOnce(-1);
+	}
+	running = previous;
+}
+
+size_t TimerLoop::runOnce(int timeout)
+{
+	size_t count = _dispatch();
+	if (count > 0 || (_heap.empty() && timeout < 0))
+	{
+		return count;
+	}
+
+	_arm();
+	struct epoll_event event;
+	if (epoll_wait(_epoll, &event, 1, timeout) > 0)
+	{
+		uint64_t expirations = 0;
+		if (read(_timer, &expirations, sizeof(expirations)) < 0)
+		{
+			expirations = 0;
+		}
+	}
+	return _dispatch();
+}
+
+void TimerLoop::stop()
+{
+	_stopped = true;
+}
+
+int64 TimerLoop::_steady(const Time & deadline)
+{
+	return steadyNanos() + (deadline.microStamp() - Time().microStamp()) * 1000;
+}
+
+void TimerLoop::_push(Waiter * waiter)
+{
+	waiter->_sequence = _sequence++;
+	waiter->_index = _heap.size();
+	_heap.push_back(waiter);
+	_up(waiter->_index);
+}
+
+void TimerLoop::_remove(Waiter * waiter)
+{
+	const size_t index = waiter->_index;
+	const size_t last = _heap.size() - 1;
+	if (index != last)
+	{
+		_swap(index, last);
+	}
+	_heap.pop_back();
+	waiter->_index = npos;
+	if (index < _heap.size())
+	{
+		_down(index);
+		_up(index);
+	}
+}
+
+void TimerLoop::_cancel(Waiter * waiter)
+{
+	if (npos == waiter->_index)
+	{
+		return;
+	}
+	_remove(waiter);
+	waiter->_cancelled = true;
+	_ready.push_back(waiter->_handle);
+}
+
+void TimerLoop::_arm()
+{
+	const int64 deadline = _heap.empty() ? INT64_MAX : _heap[0]->_deadline;
+	if (deadline == _armed)
+	{
+		return;
+	}
+
+	// 全为0表示解除，截止时间已过时设为1纳秒使其立即到期
+	struct itimerspec spec = {};
+	if (INT64_MAX != deadline)
+	{
+		const int64 at = std::max<int64>(deadline, 1);
+		spec.it_value.tv_sec = static_cast<time_t>(at / 1000000000);
+		spec.it_value.tv_nsec = static_cast<long>(at % 1000000000);
+	}
+	timerfd_settime(_timer, TFD_TIMER_ABSTIME, &spec, NULL);
+	_armed = deadline;
+}
+
+size_t TimerLoop::_dispatch()
+{
+	size_t count = 0;
+	if (!_ready.empty())
+	{
+		std::vector<std::coroutine_handle<> > ready;
+		ready.swap(_ready);
+		for (size_t i = 0; i < ready.size(); ++i)
+		{
+			ready[i].resume();
+		}
+		count += ready.size();
+	}
+
+	// now只取一次，恢复的协程中新加入的等待都晚于now，不会在这一轮恢复
+	const int64 now = steadyNanos();
+	while (!_heap.empty() && _heap[0]->_deadline <= now && !_stopped)
+	{
+		Waiter * waiter = _heap[0];
+		_remove(waiter);
+		waiter->_handle.resume();
+		++count;
+	}
+	return count;
+}
+
+bool TimerLoop::_less(size_t a, size_t b) const
+{
+	const Waiter * x = _heap[a];
+	const Waiter * y = _heap[b];
+	return x->_deadline < y->_deadline || (x->_deadline == y->_deadline && x->_sequence < y->_sequence);
+}
+
+void TimerLoop::_swap(size_t a, size_t b)
+{
+	std::swap(_heap[a], _heap[b]);
+	_heap[a]->_index = a;
+	_heap[b]->_index = b;
+}
+
+void TimerLoop::_up(size_t index)
+{
+	while (index > 0)
+	{
+		const size_t parent = (index - 1) / 2;
+		if (!_less(index, parent))
+		{
+			break;
+		}
+		_swap(index, parent);
+		index = parent;
+	}
+}
+
+void TimerLoop::_down(size_t index)
+{
+	for (;;)
+	{
+		const size_t left = index * 2 + 1;
+		if (left >= _heap.size())
+		{
+			break;
+		}
+		const size_t right = left + 1;
+		const size_t child = (right < _heap.size() && _less(right, left)) ? right : left;
+		if (!_less(child, index))
+		{
+			break;
+		}
+		_swap(index, child);
+		index = child;
+	}
+}
+
+
+TimerLoop::Waiter operator co_await(const Time & deadline)
+{
+	return TimerLoop::current()->until(deadline);
+}
+
+TimerLoop::Waiter operator co_await(const Duration & duration)
+{
+	return TimerLoop::current()->after(duration);
+}
+
+} /* namespace ec */
+
+#endif /* __cplusplus >= 202002L && __linux__ */
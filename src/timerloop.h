@@ -0,0 +1,225 @@
+﻿/*
+ * timerloop.h
+ *
+ *  Created on: 2026年10月19日
+ *      Author: havesnag
+ */
+
+#ifndef INCLUDE_EC_TIMERLOOP_H_
+#define INCLUDE_EC_TIMERLOOP_H_
+
+#include "date.h"
+
+#if __cplusplus >= 202002L && defined(__linux__)
+
+#include <stddef.h>
+#include <coroutine>
+#include <exception>
+#include <vector>
+
+namespace ec
+{
+
+/**
+ * @brief 协程的定时器事件循环(C++20，Linux)
+ * @details
+ *     所有等待中的截止时间放在一个最小堆中，只用一个timerfd，总是设为堆顶的截止时间，
+ *     超时后按(截止时间, 等待的先后)的顺序依次恢复到期的协程。
+ *     timerfd注册在epoll中，fd()可以加入其他事件循环，可读时调用runOnce(0)。
+ *     截止时间换算为单调时钟，等待期间系统时间的调整不影响等待。
+ *
+ *     协程中可以直接co_await一个Time或Duration，使用当前线程的循环 @see current：
+ * @code
+ * TimerLoop::Task tick(int n)
+ * {
+ *     for (int i = 0; i < n; ++i)
+ *     {
+ *         co_await Duration(100, Duration::MilliSecond);
+ *     }
+ * }
+ *
+ * TimerLoop loop;
+ * tick(10);
+ * loop.run();
+ * @endcode
+ *     需要取消时使用Timer，co_await的结果为false表示被取消。
+ * @note 单线程，循环和所有等待都在同一个线程中
+ */
+class TimerLoop
+{
+public:
+	class Timer;
+
+	/** @brief 一次等待，同时是堆中的节点，保存在等待中的协程帧里 */
+	class Waiter
+	{
+	public:
+		Waiter(TimerLoop & loop, int64 deadline, Timer * timer = NULL);
+		~Waiter();
+
+		/** @brief 截止时间已过时不挂起 */
+		bool await_ready() const;
+		void await_suspend(std::coroutine_handle<> handle);
+		/** @brief 到期为true，被取消为false */
+		bool await_resume() const;
+
+	private:
+		Waiter(const Waiter &);
+		Waiter & operator = (const Waiter &);
+
+		friend class TimerLoop;
+		friend class Timer;
+
+		TimerLoop * _loop;
+		Timer * _timer;
+		/** @brief 单调时钟的纳秒数 */
+		int64 _deadline;
+		/** @brief 加入的顺序，截止时间相同时先加入的先恢复 */
+		uint64_t _sequence;
+		/** @brief 在堆中的位置，不在堆中时为npos */
+		size_t _index;
+		bool _cancelled;
+		std::coroutine_handle<> _handle;
+	};
+
+	/** @brief 可以取消的定时器，同一时间只有一个等待 */
+	class Timer
+	{
+	public:
+		explicit Timer(TimerLoop & loop);
+		/** @brief 取消正在进行的等待 */
+		~Timer();
+
+		/** @brief 等待到指定的时间 */
+		Waiter until(const Time & deadline);
+		/** @brief 等待一段时间 */
+		Waiter after(const Duration & duration);
+
+		/** @brief 取消正在进行的等待，等待的协程由循环以false恢复，返回是否有等待被取消 */
+		bool cancel();
+		/** @brief 是否有等待正在进行 */
+		inline bool pending() const
+		{
+			return NULL != _waiter;
+		}
+
+	private:
+		Timer(const Timer &);
+		Timer & operator = (const Timer &);
+
+		friend class Waiter;
+
+		TimerLoop & _loop;
+		Waiter * _waiter;
+	};
+
+	/** @brief 立即开始执行、结束时自动销毁的协程，异常时终止程序 */
+	struct Task
+	{
+		struct promise_type
+		{
+			inline Task get_return_object()
+			{
+				return Task();
+			}
+
+			inline std::suspend_never initial_suspend() noexcept
+			{
+				return std::suspend_never();
+			}
+
+			inline std::suspend_never final_suspend() noexcept
+			{
+				return std::suspend_never();
+			}
+
+			inline void return_void()
+			{
+			}
+
+			inline void unhandled_exception()
+			{
+				std::terminate();
+			}
+		};
+	};
+
+	/** @brief 当前线程的循环：正在run()的循环，否则为这个线程中最先创建且仍然存在的循环，没有时为NULL */
+	static TimerLoop * current();
+	/** @brief 单调时钟的纳秒数 */
+	static int64 steadyNanos();
+
+public:
+	TimerLoop();
+	~TimerLoop();
+
+	/** @brief epoll的文件描述符 */
+	inline int fd() const
+	{
+		return _epoll;
+	}
+
+	/** @brief 等待中的个数 */
+	inline size_t pending() const
+	{
+		return _heap.size();
+	}
+
+	/** @brief 等待到指定的时间 */
+	Waiter until(const Time & deadline);
+	/** @brief 等待一段时间 */
+	Waiter after(const Duration & duration);
+
+	/** @brief 运行直到没有等待或调用了stop()，运行期间current()为这个循环 */
+	void run();
+	/**
+	 * @brief 恢复已到期和被取消的协程，没有时最多等待timeout毫秒
+	 * @param timeout 为-1时一直等待到有协程到期
+	 * @return 恢复的协程个数
+	 */
+	size_t runOnce(int timeout = -1);
+	/** @brief 使run()在当前这一轮之后返回 */
+	void stop();
+
+private:
+	TimerLoop(const TimerLoop &);
+	TimerLoop & operator = (const TimerLoop &);
+
+	/** @brief 截止时间换算为单调时钟 */
+	static int64 _steady(const Time & deadline);
+
+	void _push(Waiter * waiter);
+	void _remove(Waiter * waiter);
+	/** @brief 取消一个等待，移到就绪队列 */
+	void _cancel(Waiter * waiter);
+	/** @brief 将timerfd设为堆顶的截止时间，没有变化时不调用系统调用 */
+	void _arm();
+	/** @brief 按顺序恢复就绪和到期的协程 */
+	size_t _dispatch();
+
+	bool _less(size_t a, size_t b) const;
+	void _swap(size_t a, size_t b);
+	void _up(size_t index);
+	void _down(size_t index);
+
+	int _epoll;
+	int _timer;
+	/** @brief timerfd当前设定的截止时间，未设定时为INT64_MAX */
+	int64 _armed;
+	uint64_t _sequence;
+	bool _stopped;
+	std::vector<Waiter *> _heap;
+	/** @brief 被取消的等待，下一轮恢复 */
+	std::vector<std::coroutine_handle<> > _ready;
+};
+
+/** @brief 在当前线程正在运行的循环中等待到指定的时间 */
+TimerLoop::Waiter operator co_await(const Time & deadline);
+/** @brief 在当前线程正在运行的循环中等待一段时间 */
+TimerLoop::Waiter operator co_await(const Duration & duration);
+
+} /* namespace ec */
+
+#endif /* __cplusplus >= 202002L && __linux__ */
+
+#endif /* INCLUDE_EC_TIMERLOOP_H_ */
@@ -0,0 +1,52 @@
+﻿/*
+ * timesort.cpp
+ *
+ *  Created on: 2026年10月19日
+ *      Author: havesnag
+ */
+
+#include "timesort.h"
+
+namespace ec
+{
+
+namespace
+{
+
+/** @brief Date的键，Date不可平凡复制，sort对每个日期只取一次键，Date::stamp()的mktime不会重复调用 */
+struct DateKey
+{
+	inline int64 operator()(const Date & date) const
+	{
+		return static_cast<int64>(date.stamp());
+	}
+};
+
+} /* namespace */
+
+void TimeSort::sort(int64 * stamps, size_t count)
+{
+	sort(stamps, count, StampKey());
+}
+
+void TimeSort::sort(Time * times, size_t count)
+{
+	sort(times, count, TimeKey());
+}
+
+void TimeSort::sort(Date * dates, size_t count)
+{
+	sort(dates, count, DateKey());
+}
+
+void TimeSort::parallelSort(int64 * stamps, size_t count, ThreadPool * pool)
+{
+	parallelSort(stamps, count, StampKey(), pool);
+}
+
+void TimeSort::parallelSort(Time * times, size_t count, ThreadPool * pool)
+{
+	parallelSort(times, count, TimeKey(), pool);
+}
+
+} /* namespace ec */
@@ -0,0 +1,590 @@
+﻿/*
+ * timesort.h
+ *
+ *  Created on: 2026年10月19日
+ *      Author: havesnag
+ */
+
+#ifndef INCLUDE_EC_TIMESORT_H_
+#define INCLUDE_EC_TIMESORT_H_
+
+#include "date.h"
+#include "threadpool.h"
+#include <stddef.h>
+#include <stdint.h>
+#include <algorithm>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace ec
+{
+
+/**
+ * @brief 按时间排序和归并
+ * @details
+ *     排序为按64位键的LSD基数排序，每轮11位，一次读取统计所有轮的计数，所有记录该位都相同的轮直接跳过，
+ *     跨度在一天以内的微秒时间戳(37位)只需4轮，每轮顺序读一次、分散写一次，不比较。排序是稳定的。
+ *     归并为多路已排序序列的败者树归并，键相同时序号小的序列在前，也是稳定的。
+ *     并行版本在线程池中分块处理：排序时每块各自计数后按(位值, 块)计算写入位置，各块同时分散写入；
+ *     归并时按各序列的采样选出分隔键，每段在各序列中二分确定范围后独立归并到各自的输出位置。
+ *
+ *     键为int64，由Key(const T &)取得，负数也按大小排序，比如：
+ * @code
+ * struct Event { Time time; int id; };
+ * TimeSort::sort(events, count, TimeSort::TimeMemberKey<Event, &Event::time>());
+ * @endcode
+ * @note 可平凡复制(std::is_trivially_copyable)的记录直接按基数排序移动，排序过程中按键的轮数多次调用Key，Key应当足够简单。
+ *     其他记录(比如含有std::string)每个只取一次键，排序(键, 位置)后再按位置移动记录，不使用buffer。
+ *     merge和parallelMerge对可平凡复制的记录可以输出到未构造的内存，其他记录的out必须是已构造的对象，按赋值写入。
+ */
+class TimeSort
+{
+public:
+	/** @brief Time的键，微秒时间戳 */
+	struct TimeKey
+	{
+		inline int64 operator()(const Time & time) const
+		{
+			return time.microStamp();
+		}
+	};
+
+	/** @brief 时间戳本身作为键 */
+	struct StampKey
+	{
+		inline int64 operator()(int64 stamp) const
+		{
+			return stamp;
+		}
+	};
+
+	/** @brief 记录中Time成员的键 */
+	template <typename T, Time T::*Member>
+	struct TimeMemberKey
+	{
+		inline int64 operator()(const T & record) const
+		{
+			return (record.*Member).microStamp();
+		}
+	};
+
+	/** @brief 记录中时间戳成员的键 */
+	template <typename T, int64 T::*Member>
+	struct StampMemberKey
+	{
+		inline int64 operator()(const T & record) const
+		{
+			return record.*Member;
+		}
+	};
+
+public:
+	/** @brief 排序时间戳 */
+	static void sort(int64 * stamps, size_t count);
+	/** @brief 排序时间 */
+	static void sort(Time * times, size_t count);
+	/** @brief 排序日期，先算出每个日期的时间戳再排序 */
+	static void sort(Date * dates, size_t count);
+	/** @brief 并行排序时间戳，pool为NULL时使用ThreadPool::shared() */
+	static void parallelSort(int64 * stamps, size_t count, ThreadPool * pool = NULL);
+	/** @brief 并行排序时间 */
+	static void parallelSort(Time * times, size_t count, ThreadPool * pool = NULL);
+
+	/**
+	 * @brief 按键排序
+	 * @param buffer 与data同样大小的临时空间，可以是未构造的内存，为NULL时内部分配，只用于可平凡复制的记录
+	 */
+	template <typename T, typename Key>
+	static void sort(T * data, size_t count, Key key, T * buffer = NULL)
+	{
+		_sort(data, count, key, buffer, std::is_trivially_copyable<T>());
+	}
+
+	/**
+	 * @brief 并行按键排序，数据量小或只有一个线程时同sort
+	 * @param pool 为NULL时使用ThreadPool::shared()
+	 */
+	template <typename T, typename Key>
+	static void parallelSort(T * data, size_t count, Key key, ThreadPool * pool = NULL, T * buffer = NULL)
+	{
+		_parallelSort(data, count, key, pool, buffer, std::is_trivially_copyable<T>());
+	}
+
+	/**
+	 * @brief 归并k个已按键排序的序列
+	 * @param runs 各序列的开始
+	 * @param sizes 各序列的长度
+	 * @param out 输出，长度为各序列长度之和，不能与输入重叠
+	 */
+	template <typename T, typename Key>
+	static void merge(const T * const * runs, const size_t * sizes, size_t k, T * out, Key key)
+	{
+		_merge(runs, sizes, k, out, key);
+	}
+
+	/**
+	 * @brief 并行归并，结果与merge相同
+	 * @param pool 为NULL时使用ThreadPool::shared()
+	 */
+	template <typename T, typename Key>
+	static void parallelMerge(const T * const * runs, const size_t * sizes, size_t k, T * out, Key key,
+		ThreadPool * pool = NULL)
+	{
+		ThreadPool & workers = (NULL != pool) ? *pool : ThreadPool::shared();
+		size_t total = 0;
+		for (size_t r = 0; r < k; ++r)
+		{
+			total += sizes[r];
+		}
+		const size_t parts = std::min(workers.size() * 4, total / ParallelChunk);
+		if (parts <= 1 || k <= 1)
+		{
+			_merge(runs, sizes, k, out, key);
+			return;
+		}
+
+		// 每个序列按长度等距取parts个样本，每个样本代表sizes[r] / parts个记录，按键排序后取加权的分位点
+		std::vector<std::pair<int64, size_t> > samples;
+		samples.reserve(k * parts);
+		for (size_t r = 0; r < k; ++r)
+		{
+			for (size_t i = 0; sizes[r] > 0 && i < parts; ++i)
+			{
+				samples.push_back(std::make_pair(key(runs[r][(sizes[r] * (2 * i + 1)) / (2 * parts)]), sizes[r]));
+			}
+		}
+		std::sort(samples.begin(), samples.end());
+
+		std::vector<int64> splitters;
+		size_t weight = 0;
+		for (size_t i = 0; i < samples.size() && splitters.size() + 1 < parts; ++i)
+		{
+			weight += samples[i].second;
+			if (weight >= total * (splitters.size() + 1))
+			{
+				splitters.push_back(samples[i].first);
+			}
+		}
+
+		// bounds[j * k + r]为第j段在序列r中的开始，键小于分隔键的在之前，相同的在之后，各段之间保持稳定
+		const size_t count = splitters.size() + 1;
+		std::vector<size_t> bounds((count + 1) * k);
+		std::vector<size_t> offsets(count + 1, 0);
+		for (size_t r = 0; r < k; ++r)
+		{
+			bounds[count * k + r] = sizes[r];
+			offsets[count] += sizes[r];
+		}
+		for (size_t j = 1; j < count; ++j)
+		{
+			const int64 splitter = splitters[j - 1];
+			for (size_t r = 0; r < k; ++r)
+			{
+				size_t low = bounds[(j - 1) * k + r];
+				size_t high = sizes[r];
+				while (low < high)
+				{
+					const size_t middle = low + (high - low) / 2;
+					if (key(runs[r][middle]) < splitter)
+					{
+						low = middle + 1;
+					}
+					else
+					{
+						high = middle;
+					}
+				}
+				bounds[j * k + r] = low;
+				offsets[j] += low;
+			}
+		}
+
+		workers.run(count, [&](size_t j) {
+			std::vector<const T *> slices(k);
+			std::vector<size_t> lengths(k);
+			for (size_t r = 0; r < k; ++r)
+			{
+				slices[r] = runs[r] + bounds[j * k + r];
+				lengths[r] = bounds[(j + 1) * k + r] - bounds[j * k + r];
+			}
+			_merge(&slices[0], &lengths[0], k, out + offsets[j], key);
+		});
+	}
+
+private:
+	TimeSort();
+
+	/** @brief 每轮的位数，11位时计数表仍在L2中，比8位少一到两轮 */
+	static const int RadixBits = 11;
+	/** @brief 每轮的桶数 */
+	static const size_t Radix = 1 << RadixBits;
+	/** @brief 轮数 */
+	static const int Digits = (64 + RadixBits - 1) / RadixBits;
+	/** @brief 少于此数时插入排序 */
+	static const size_t SmallCount = 64;
+	/** @brief 并行时每块的最少记录数 */
+	static const size_t ParallelChunk = 65536;
+
+	/** @brief 键和记录原来的位置 */
+	struct Entry
+	{
+		int64 key;
+		size_t index;
+	};
+
+	struct EntryKey
+	{
+		inline int64 operator()(const Entry & entry) const
+		{
+			return entry.key;
+		}
+	};
+
+	/** @brief 不能按字节复制的记录，排序(键, 位置)后按位置移动 */
+	template <typename T, typename Key>
+	static void _sort(T * data, size_t count, Key & key, T *, std::false_type)
+	{
+		std::vector<Entry> entries(count);
+		for (size_t i = 0; i < count; ++i)
+		{
+			entries[i].key = key(data[i]);
+			entries[i].index = i;
+		}
+		sort(entries.data(), count, EntryKey());
+		_permute(data, entries);
+	}
+
+	template <typename T, typename Key>
+	static void _parallelSort(T * data, size_t count, Key & key, ThreadPool * pool, T *, std::false_type)
+	{
+		std::vector<Entry> entries(count);
+		for (size_t i = 0; i < count; ++i)
+		{
+			entries[i].key = key(data[i]);
+			entries[i].index = i;
+		}
+		parallelSort(entries.data(), count, EntryKey(), pool);
+		_permute(data, entries);
+	}
+
+	template <typename T>
+	static void _permute(T * data, const std::vector<Entry> & entries)
+	{
+		std::vector<T> sorted;
+		sorted.reserve(entries.size());
+		for (size_t i = 0; i < entries.size(); ++i)
+		{
+			sorted.push_back(std::move(data[entries[i].index]));
+		}
+		std::move(sorted.begin(), sorted.end(), data);
+	}
+
+	template <typename T, typename Key>
+	static void _sort(T * data, size_t count, Key & key, T * buffer, std::true_type)
+	{
+		if (count < SmallCount)
+		{
+			_insertionSort(data, count, key);
+			return;
+		}
+
+		std::vector<size_t> counts(Digits * Radix);
+		for (size_t i = 0; i < count; ++i)
+		{
+			const uint64_t value = _value(key(data[i]));
+			for (int digit = 0; digit < Digits; ++digit)
+			{
+				++counts[digit * Radix + ((value >> (digit * RadixBits)) & (Radix - 1))];
+			}
+		}
+
+		T * const storage = (NULL != buffer) ? buffer : _allocate<T>(count);
+		T * src = data;
+		T * dst = storage;
+		const uint64_t first = _value(key(data[0]));
+		for (int digit = 0; digit < Digits; ++digit)
+		{
+			const int shift = digit * RadixBits;
+			size_t * offsets = &counts[digit * Radix];
+			if (offsets[(first >> shift) & (Radix - 1)] == count)
+			{
+				continue;
+			}
+
+			// 计数原地换成写入位置
+			size_t offset = 0;
+			for (size_t i = 0; i < Radix; ++i)
+			{
+				const size_t current = offsets[i];
+				offsets[i] = offset;
+				offset += current;
+			}
+
+			for (size_t i = 0; i < count; ++i)
+			{
+				const size_t index = (_value(key(src[i])) >> shift) & (Radix - 1);
+				_copy(dst + offsets[index]++, src[i]);
+			}
+			std::swap(src, dst);
+		}
+
+		if (src != data)
+		{
+			for (size_t i = 0; i < count; ++i)
+			{
+				_copy(data + i, src[i]);
+			}
+		}
+		if (NULL == buffer)
+		{
+			_deallocate(storage);
+		}
+	}
+
+	template <typename T, typename Key>
+	static void _parallelSort(T * data, size_t count, Key & key, ThreadPool * pool, T * buffer, std::true_type)
+	{
+		ThreadPool & workers = (NULL != pool) ? *pool : ThreadPool::shared();
+		const size_t chunks = std::min(workers.size(), count / ParallelChunk);
+		if (chunks <= 1)
+		{
+			sort(data, count, key, buffer);
+			return;
+		}
+
+		const size_t rows = (count + chunks - 1) / chunks;
+		std::vector<size_t> counts(chunks * Digits * Radix);
+		workers.run(chunks, [&](size_t chunk) {
+			const size_t begin = std::min(chunk * rows, count);
+			const size_t end = std::min(begin + rows, count);
+			size_t * local = &counts[chunk * Digits * Radix];
+			for (size_t i = begin; i < end; ++i)
+			{
+				const uint64_t value = _value(key(data[i]));
+				for (int digit = 0; digit < Digits; ++digit)
+				{
+					++local[digit * Radix + ((value >> (digit * RadixBits)) & (Radix - 1))];
+				}
+			}
+		});
+
+		T * const storage = (NULL != buffer) ? buffer : _allocate<T>(count);
+		T * src = data;
+		T * dst = storage;
+		const uint64_t first = _value(key(data[0]));
+		bool counted = true;
+		std::vector<size_t> offsets(chunks * Radix);
+		for (int digit = 0; digit < Digits; ++digit)
+		{
+			const int shift = digit * RadixBits;
+			const size_t firstIndex = (first >> shift) & (Radix - 1);
+			size_t total = 0;
+			for (size_t chunk = 0; chunk < chunks; ++chunk)
+			{
+				total += counts[(chunk * Digits + digit) * Radix + firstIndex];
+			}
+			if (total == count)
+			{
+				continue;
+			}
+
+			// 第一轮之后块中的数据已经改变，重新按这一轮的位计数
+			if (!counted)
+			{
+				workers.run(chunks, [&](size_t chunk) {
+					const size_t begin = std::min(chunk * rows, count);
+					const size_t end = std::min(begin + rows, count);
+					size_t * local = &counts[(chunk * Digits + digit) * Radix];
+					std::fill(local, local + Radix, 0);
+					for (size_t i = begin; i < end; ++i)
+					{
+						++local[(_value(key(src[i])) >> shift) & (Radix - 1)];
+					}
+				});
+			}
+			counted = false;
+
+			size_t offset = 0;
+			for (size_t i = 0; i < Radix; ++i)
+			{
+				for (size_t chunk = 0; chunk < chunks; ++chunk)
+				{
+					offsets[chunk * Radix + i] = offset;
+					offset += counts[(chunk * Digits + digit) * Radix + i];
+				}
+			}
+
+			workers.run(chunks, [&](size_t chunk) {
+				const size_t begin = std::min(chunk * rows, count);
+				const size_t end = std::min(begin + rows, count);
+				size_t * local = &offsets[chunk * Radix];
+				for (size_t i = begin; i < end; ++i)
+				{
+					const size_t index = (_value(key(src[i])) >> shift) & (Radix - 1);
+					_copy(dst + local[index]++, src[i]);
+				}
+			});
+			std::swap(src, dst);
+		}
+
+		if (src != data)
+		{
+			workers.run(chunks, [&](size_t chunk) {
+				const size_t begin = std::min(chunk * rows, count);
+				const size_t end = std::min(begin + rows, count);
+				for (size_t i = begin; i < end; ++i)
+				{
+					_copy(data + i, src[i]);
+				}
+			});
+		}
+		if (NULL == buffer)
+		{
+			_deallocate(storage);
+		}
+	}
+
+	/** @brief 翻转符号位，使无符号的顺序与有符号相同 */
+	static inline uint64_t _value(int64 key)
+	{
+		return static_cast<uint64_t>(key) ^ (static_cast<uint64_t>(1) << 63);
+	}
+
+	/** @brief 可平凡复制的记录直接构造，目标可以是未构造的内存 */
+	template <typename T>
+	static inline void _copy(T * dst, const T & src)
+	{
+		_copy(dst, src, std::is_trivially_copyable<T>());
+	}
+
+	template <typename T>
+	static inline void _copy(T * dst, const T & src, std::true_type)
+	{
+		new (dst) T(src);
+	}
+
+	template <typename T>
+	static inline void _copy(T * dst, const T & src, std::false_type)
+	{
+		*dst = src;
+	}
+
+	template <typename T>
+	static inline T * _allocate(size_t count)
+	{
+		return static_cast<T *>(::operator new(count * sizeof(T)));
+	}
+
+	template <typename T>
+	static inline void _deallocate(T * data)
+	{
+		::operator delete(static_cast<void *>(data));
+	}
+
+	template <typename T, typename Key>
+	static void _insertionSort(T * data, size_t count, Key & key)
+	{
+		for (size_t i = 1; i < count; ++i)
+		{
+			const int64 value = key(data[i]);
+			size_t j = i;
+			while (j > 0 && value < key(data[j - 1]))
+			{
+				--j;
+			}
+			if (j == i)
+			{
+				continue;
+			}
+
+			T current(std::move(data[i]));
+			std::move_backward(data + j, data + i, data + i + 1);
+			data[j] = std::move(current);
+		}
+	}
+
+	/** @brief 败者树归并，键相同时按(耗尽, 序号)决定先后，耗尽的序列总在最后 */
+	template <typename T, typename Key>
+	static void _merge(const T * const * runs, const size_t * sizes, size_t k, T * out, Key & key)
+	{
+		size_t leaves = 1;
+		while (leaves < k)
+		{
+			leaves <<= 1;
+		}
+
+		std::vector<const T *> current(leaves, static_cast<const T *>(NULL));
+		std::vector<const T *> ends(leaves, static_cast<const T *>(NULL));
+		std::vector<int64> keys(leaves, INT64_MAX);
+		std::vector<char> done(leaves, 1);
+		size_t total = 0;
+		for (size_t r = 0; r < k; ++r)
+		{
+			current[r] = runs[r];
+			ends[r] = runs[r] + sizes[r];
+			total += sizes[r];
+			if (sizes[r] > 0)
+			{
+				keys[r] = key(runs[r][0]);
+				done[r] = 0;
+			}
+		}
+
+		struct Less
+		{
+			const int64 * keys;
+			const char * done;
+
+			inline bool operator()(size_t a, size_t b) const
+			{
+				return keys[a] < keys[b]
+					|| (keys[a] == keys[b] && (done[a] < done[b] || (done[a] == done[b] && a < b)));
+			}
+		} less = { &keys[0], &done[0] };
+
+		// tree[n]为节点n的败者，winners只在构建时使用
+		std::vector<size_t> tree(leaves);
+		std::vector<size_t> winners(2 * leaves);
+		for (size_t i = 0; i < leaves; ++i)
+		{
+			winners[leaves + i] = i;
+		}
+		for (size_t n = leaves - 1; n > 0; --n)
+		{
+			const size_t a = winners[2 * n];
+			const size_t b = winners[2 * n + 1];
+			const bool right = less(b, a);
+			winners[n] = right ? b : a;
+			tree[n] = right ? a : b;
+		}
+
+		size_t winner = winners[1];
+		for (size_t i = 0; i < total; ++i)
+		{
+			_copy(out + i, *current[winner]);
+			if (++current[winner] != ends[winner])
+			{
+				keys[winner] = key(*current[winner]);
+			}
+			else
+			{
+				keys[winner] = INT64_MAX;
+				done[winner] = 1;
+			}
+
+			for (size_t n = (winner + leaves) >> 1; n > 0; n >>= 1)
+			{
+				if (less(tree[n], winner))
+				{
+					std::swap(tree[n], winner);
+				}
+			}
+		}
+	}
+};
+
+} /* namespace ec */
+
+#endif /* INCLUDE_EC_TIMESORT_H_ */
@@ -0,0 +1,359 @@
+﻿/*
+ * trace.cpp
+ *
+ *  Created on: 2026年10月19日
+ *      Author: havesnag
+ */
+
+#include "trace.h"
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+using namespace std;
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define TRACE_TSC
+#include <x86intrin.h>
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#define TRACE_TSC
+#include <intrin.h>
+#endif
+
+#ifdef PLATFORM_WINDOWS
+#define getpid() static_cast<int>(GetCurrentProcessId())
+#else
+#include <unistd.h>
+#endif // PLATFORM_WINDOWS
+
+namespace ec
+{
+
+namespace
+{
+
+/** @brief 一条记录，end为0时为瞬时事件 */
+struct Event
+{
+	const char * name;
+	const char * category;
+	uint64_t begin;
+	uint64_t end;
+};
+
+/** @brief 一个线程的环形缓冲区，只有所属线程写入 */
+struct Ring
+{
+	std::unique_ptr<Event[]> events;
+	size_t mask;
+	/** @brief 写入的总数 */
+	std::atomic<uint64_t> head;
+	/** @brief 已取出的总数，只有collect访问 */
+	uint64_t tail;
+	uint64_t id;
+	std::string name;
+	/** @brief 所属线程已结束，取完后可以释放 */
+	std::atomic<bool> finished;
+
+	Ring(size_t capacity, uint64_t id) : mask(capacity - 1), head(0), tail(0), id(id), finished(false)
+	{
+		events.reset(new Event[capacity]);
+	}
+};
+
+inline uint64_t ticks()
+{
+#ifdef TRACE_TSC
+	return __rdtsc();
+#else
+	return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::steady_clock::now().time_since_epoch()).count());
+#endif
+}
+
+inline int64 steadyNanos()
+{
+	return static_cast<int64>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+struct Registry
+{
+	std::mutex mutex;
+	std::vector<std::shared_ptr<Ring> > rings;
+	std::atomic<bool> enabled;
+	std::atomic<size_t> capacity;
+	uint64_t nextId;
+
+	/** @brief 启动时的计时、steady_clock和微秒时间戳，用于换算 */
+	uint64_t startTicks;
+	int64 startNanos;
+	int64 startStamp;
+
+	Registry() : enabled(true), capacity(65536), nextId(1)
+	{
+		startStamp = Time().microStamp();
+		startNanos = steadyNanos();
+		startTicks = ticks();
+	}
+
+	/** @brief 每微秒的计时数 */
+	double ticksPerMicro()
+	{
+#ifdef TRACE_TSC
+		// 至少间隔10毫秒再计算TSC的频率
+		int64 elapsed = steadyNanos() - startNanos;
+		if (elapsed < 10000000)
+		{
+			std::this_thread::sleep_for(std::chrono::nanoseconds(10000000 - elapsed));
+		}
+		const uint64_t now = ticks();
+		elapsed = steadyNanos() - startNanos;
+		return static_cast<double>(now - startTicks) * 1000 / static_cast<double>(elapsed);
+#else
+		return 1000;
+#endif
+	}
+};
+
+Registry & registry()
+{
+	static Registry instance;
+	return instance;
+}
+
+/** @brief 线程结束时标记缓冲区 */
+struct Holder
+{
+	std::shared_ptr<Ring> ring;
+
+	~Holder()
+	{
+		if (ring)
+		{
+			ring->finished.store(true);
+		}
+	}
+};
+
+thread_local Holder holder;
+
+Ring & currentRing()
+{
+	if (!holder.ring)
+	{
+		Registry & r = registry();
+		size_t capacity = 1;
+		while (capacity < r.capacity.load())
+		{
+			capacity <<= 1;
+		}
+
+		std::lock_guard<std::mutex> lock(r.mutex);
+		holder.ring = std::make_shared<Ring>(capacity, r.nextId++);
+		r.rings.push_back(holder.ring);
+	}
+	return *holder.ring;
+}
+
+inline void push(const char * name, const char * category, uint64_t begin, uint64_t end)
+{
+	Ring & ring = currentRing();
+	const uint64_t head = ring.head.load(std::memory_order_relaxed);
+	Event & event = ring.events[static_cast<size_t>(head) & ring.mask];
+	event.name = name;
+	event.category = category;
+	event.begin = begin;
+	event.end = end;
+	ring.head.store(head + 1, std::memory_order_release);
+}
+
+void appendEscaped(std::string & out, const char * text)
+{
+	out += '"';
+	for (const char * p = (NULL != text) ? text : ""; '\0' != *p; ++p)
+	{
+		const unsigned char c = static_cast<unsigned char>(*p);
+		if ('"' == c || '\\' == c)
+		{
+			out += '\\';
+			out += static_cast<char>(c);
+		}
+		else if (c < 0x20)
+		{
+			char buf[8];
+			snprintf(buf, sizeof(buf), "\\u%04x", c);
+			out += buf;
+		}
+		else
+		{
+			out += static_cast<char>(c);
+		}
+	}
+	out += '"';
+}
+
+} /* namespace */
+
+void Trace::setEnabled(bool enabled)
+{
+	registry().enabled.store(enabled, std::memory_order_relaxed);
+}
+
+bool Trace::enabled()
+{
+	return registry().enabled.load(std::memory_order_relaxed);
+}
+
+void Trace::setCapacity(size_t capacity)
+{
+	registry().capacity.store(std::max<size_t>(capacity, 1));
+}
+
+void Trace::setThreadName(const char * name)
+{
+	Ring & ring = currentRing();
+	std::lock_guard<std::mutex> lock(registry().mutex);
+	ring.name = (NULL != name) ? name : "";
+}
+
+uint64_t Trace::now()
+{
+	return ticks();
+}
+
+double Trace::toMicroStamp(uint64_t value)
+{
+	Registry & r = registry();
+	return static_cast<double>(r.startStamp)
+		+ static_cast<double>(static_cast<int64>(value - r.startTicks)) / r.ticksPerMicro();
+}
+
+void Trace::complete(const char * name, const char * category, uint64_t begin, uint64_t end)
+{
+	push(name, category, begin, std::max(end, begin + 1));
+}
+
+void Trace::instant(const char * name, const char * category)
+{
+	if (enabled())
+	{
+		push(name, category, ticks(), 0);
+	}
+}
+
+size_t Trace::collect(std::string & json)
+{
+	Registry & r = registry();
+	const double rate = r.ticksPerMicro();
+	const int pid = static_cast<int>(getpid());
+
+	std::lock_guard<std::mutex> lock(r.mutex);
+
+	json += "{\"traceEvents\":[";
+	bool first = true;
+	size_t count = 0;
+	char buf[160];
+	std::vector<Event> events;
+	for (size_t i = 0; i < r.rings.size(); ++i)
+	{
+		Ring & ring = *r.rings[i];
+		const uint64_t capacity = ring.mask + 1;
+
+		// 先复制再检查，复制期间被覆盖的记录丢弃
+		const uint64_t head = ring.head.load(std::memory_order_acquire);
+		const uint64_t begin = std::max(ring.tail, (head > capacity) ? (head - capacity) : 0);
+		events.clear();
+		for (uint64_t index = begin; index < head; ++index)
+		{
+			events.push_back(ring.events[static_cast<size_t>(index) & ring.mask]);
+		}
+		std::atomic_thread_fence(std::memory_order_acquire);
+		const uint64_t after = ring.head.load(std::memory_order_relaxed);
+		const uint64_t valid = (after >= capacity) ? (after - capacity + 1) : 0;
+		ring.tail = head;
+
+		if (!ring.name.empty())
+		{
+			json += first ? "" : ",";
+			first = false;
+			snprintf(buf, sizeof(buf), "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":%llu,\"args\":{\"name\":",
+				pid, static_cast<unsigned long long>(ring.id));
+			json += buf;
+			appendEscaped(json, ring.name.c_str());
+			json += "}}";
+		}
+
+		for (size_t j = 0; j < events.size(); ++j)
+		{
+			if (begin + j < valid)
+			{
+				continue;
+			}
+
+			const Event & event = events[j];
+			json += first ? "" : ",";
+			first = false;
+			json += "{\"name\":";
+			appendEscaped(json, event.name);
+			json += ",\"cat\":";
+			appendEscaped(json, event.category);
+
+			const double ts = static_cast<double>(r.startStamp)
+				+ static_cast<double>(static_cast<int64>(event.begin - r.startTicks)) / rate;
+			if (0 == event.end)
+			{
+				snprintf(buf, sizeof(buf), ",\"ph\":\"i\",\"s\":\"t\",\"ts\":%.3f,\"pid\":%d,\"tid\":%llu}",
+					ts, pid, static_cast<unsigned long long>(ring.id));
+			}
+			else
+			{
+				snprintf(buf, sizeof(buf), ",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":%d,\"tid\":%llu}",
+					ts, static_cast<double>(event.end - event.begin) / rate, pid, static_cast<unsigned long long>(ring.id));
+			}
+			json += buf;
+			++count;
+		}
+	}
+
+	// 释放已结束且取完的线程的缓冲区
+	for (size_t i = 0; i < r.rings.size(); )
+	{
+		Ring & ring = *r.rings[i];
+		if (ring.finished.load() && ring.tail == ring.head.load())
+		{
+			r.rings.erase(r.rings.begin() + static_cast<std::ptrdiff_t>(i));
+			continue;
+		}
+		++i;
+	}
+
+	json += "],\"displayTimeUnit\":\"ns\",\"otherData\":{\"start\":";
+	Time start;
+	start.setMicroStamp(r.startStamp);
+	appendEscaped(json, start.toDate().format("%Y-%m-%d %H:%M:%S %z").c_str());
+	json += "}}";
+	return count;
+}
+
+bool Trace::write(const std::string & path)
+{
+	std::string json;
+	collect(json);
+
+	FILE * file = fopen(path.c_str(), "wb");
+	if (NULL == file)
+	{
+		return false;
+	}
+
+	const bool ok = (json.empty() || 1 == fwrite(json.data(), json.size(), 1, file));
+	return (0 == fclose(file)) && ok;
+}
+
+} /* namespace ec */
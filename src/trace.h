@@ -0,0 +1,101 @@
+﻿/*
+ * trace.h
+ *
+ *  Created on: 2026年10月19日
+ *      Author: havesnag
+ */
+
+#ifndef INCLUDE_EC_TRACE_H_
+#define INCLUDE_EC_TRACE_H_
+
+#include "date.h"
+#include <stddef.h>
+#include <string>
+
+namespace ec
+{
+
+/**
+ * @brief 性能追踪，记录到每个线程的环形缓冲区，导出为Chrome/Perfetto的trace JSON
+ * @details
+ *     x86下用TSC计时，其他平台用steady_clock，导出时按启动时记录的Time换算为微秒时间戳。
+ *     每个线程第一次记录时分配自己的缓冲区，之后记录不再分配内存也不加锁；
+ *     缓冲区满时覆盖最旧的记录。名称和分类只保存指针，须为字符串常量等长期有效的字符串。
+ *     在chrome://tracing或ui.perfetto.dev中打开导出的文件。
+ * @see TraceSpan
+ */
+class Trace
+{
+public:
+	/** @brief 是否记录，默认记录 */
+	static void setEnabled(bool enabled);
+	/** @brief 是否记录 */
+	static bool enabled();
+
+	/** @brief 之后新线程的缓冲区能容纳的记录数，默认65536 */
+	static void setCapacity(size_t capacity);
+	/** @brief 当前线程在导出中显示的名称 */
+	static void setThreadName(const char * name);
+
+	/** @brief 当前时刻，单位取决于计时方式 @see toMicroStamp */
+	static uint64_t now();
+	/** @brief 将now()的值换算为微秒时间戳(可能有小数) */
+	static double toMicroStamp(uint64_t ticks);
+
+	/** @brief 记录一段已结束的区间 */
+	static void complete(const char * name, const char * category, uint64_t begin, uint64_t end);
+	/** @brief 记录一个瞬时事件 */
+	static void instant(const char * name, const char * category = NULL);
+
+	/**
+	 * @brief 取出所有线程缓冲区中的记录，追加为trace JSON
+	 * @details 正在被覆盖的记录会被丢弃，之后的collect不再包含已取出的记录
+	 * @return 取出的记录数
+	 */
+	static size_t collect(std::string & json);
+	/** @brief 取出记录并写入文件 */
+	static bool write(const std::string & path);
+
+private:
+	Trace();
+};
+
+/**
+ * @brief 作用域内的追踪区间，构造时开始，析构时结束
+ * @details
+ * @code
+ * void handle()
+ * {
+ *     ec::TraceSpan span("handle", "rpc");
+ *     ...
+ * }
+ * @endcode
+ */
+class TraceSpan
+{
+public:
+	explicit TraceSpan(const char * name, const char * category = NULL)
+		: _name(name), _category(category), _begin(Trace::enabled() ? Trace::now() : 0)
+	{
+	}
+
+	~TraceSpan()
+	{
+		if (0 != _begin)
+		{
+			Trace::complete(_name, _category, _begin, Trace::now());
+		}
+	}
+
+private:
+	TraceSpan(const TraceSpan &);
+	TraceSpan & operator = (const TraceSpan &);
+
+	const char * _name;
+	const char * _category;
+	uint64_t _begin;
+};
+
+} /* namespace ec */
+
+#endif /* INCLUDE_EC_TRACE_H_ */
@@ -0,0 +1,185 @@
+﻿/*
+ * windowcounter.cpp
+ *
+ *  Created on: 2026年10月19日
+ *      Author: havesnag
+ */
+
+#include "windowcounter.h"
+#include <stdint.h>
+#include <algorithm>
+#include <thread>
+#include <vector>
+using namespace std;
+
+namespace ec
+{
+
+namespace
+{
+
+/** @brief 每个缓存行的桶数 */
+const size_t slotsPerLine = 64 / sizeof(uint64_t);
+const uint64_t countMask = 0xFFFFFFFFu;
+
+/** @brief 当前线程的分带序号，首次使用时轮流分配 */
+size_t threadStripe()
+{
+	static std::atomic<size_t> next(0);
+	thread_local size_t index = next.fetch_add(1, std::memory_order_relaxed);
+	return index;
+}
+
+} /* namespace */
+
+WindowCounter::WindowCounter(const Duration & resolution, size_t buckets, size_t stripes)
+{
+	_resolution = std::max<int64>(resolution.valueAs(Duration::MicroSecond), 1);
+	_buckets = std::max<size_t>(buckets, 1);
+
+	if (0 == stripes)
+	{
+		stripes = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+	}
+	_stripes = 1;
+	while (_stripes < stripes)
+	{
+		_stripes <<= 1;
+	}
+
+	_stride = (_buckets + slotsPerLine - 1) / slotsPerLine * slotsPerLine;
+	_memory.reset(new std::atomic<uint64_t>[_stride * _stripes + slotsPerLine]);
+
+	const uintptr_t address = reinterpret_cast<uintptr_t>(_memory.get());
+	const uintptr_t aligned = (address + 63) & ~static_cast<uintptr_t>(63);
+	_slots = reinterpret_cast<std::atomic<uint64_t> *>(aligned);
+	clear();
+}
+
+WindowCounter::~WindowCounter()
+{
+}
+
+void WindowCounter::add(int64 count)
+{
+	add(Time().microStamp(), count);
+}
+
+void WindowCounter::add(int64 now, int64 count)
+{
+	if (count <= 0)
+	{
+		return;
+	}
+
+	const int64 bucket = Calendar::floorDiv(now, _resolution);
+	const uint32_t tag = static_cast<uint32_t>(bucket);
+	std::atomic<uint64_t> & slot = _slots[(threadStripe() & (_stripes - 1)) * _stride + _index(bucket)];
+
+	const uint64_t increment = std::min<uint64_t>(static_cast<uint64_t>(count), countMask);
+	uint64_t value = slot.load(std::memory_order_relaxed);
+	for (;;)
+	{
+		// 序号按32位回绕比较
+		const int32_t distance = static_cast<int32_t>(tag - static_cast<uint32_t>(value >> 32));
+		uint64_t next = 0;
+		if (0 == distance)
+		{
+			next = (value & ~countMask) | std::min<uint64_t>((value & countMask) + increment, countMask);
+		}
+		else if (distance > 0)
+		{
+			next = (static_cast<uint64_t>(tag) << 32) | increment;
+		}
+		else
+		{
+			// 该位置已经是更新的桶，这个时间已经移出环
+			return;
+		}
+
+		if (slot.compare_exchange_weak(value, next, std::memory_order_relaxed))
+		{
+			return;
+		}
+	}
+}
+
+void WindowCounter::add(const Time & time, int64 count)
+{
+	add(time.microStamp(), count);
+}
+
+int64 WindowCounter::count(const Duration & window) const
+{
+	return count(Time().microStamp(), window);
+}
+
+int64 WindowCounter::count(int64 now, const Duration & window) const
+{
+	int64 result = 0;
+	count(now, &window, 1, &result);
+	return result;
+}
+
+void WindowCounter::count(int64 now, const Duration * windows, size_t size, int64 * out) const
+{
+	int64 width = 0;
+	for (size_t i = 0; i < size; ++i)
+	{
+		width = std::max(width, _width(windows[i]));
+	}
+
+	// sums[j]为当前桶之前第j个桶的计数
+	const int64 bucket = Calendar::floorDiv(now, _resolution);
+	const size_t first = _index(bucket);
+	std::vector<int64> sums(static_cast<size_t>(width), 0);
+	for (size_t stripe = 0; stripe < _stripes; ++stripe)
+	{
+		const std::atomic<uint64_t> * slots = _slots + stripe * _stride;
+		size_t index = first;
+		for (int64 j = 0; j < width; ++j)
+		{
+			const uint64_t value = slots[index].load(std::memory_order_relaxed);
+			if (static_cast<uint32_t>(value >> 32) == static_cast<uint32_t>(bucket - j))
+			{
+				sums[static_cast<size_t>(j)] += static_cast<int64>(value & countMask);
+			}
+			index = (0 == index) ? (_buckets - 1) : (index - 1);
+		}
+	}
+
+	for (int64 j = 1; j < width; ++j)
+	{
+		sums[static_cast<size_t>(j)] += sums[static_cast<size_t>(j - 1)];
+	}
+
+	for (size_t i = 0; i < size; ++i)
+	{
+		const int64 w = _width(windows[i]);
+		out[i] = (w > 0) ? sums[static_cast<size_t>(w - 1)] : 0;
+	}
+}
+
+void WindowCounter::clear()
+{
+	// 计数为0，即使序号恰好匹配也不影响结果
+	for (size_t i = 0; i < _stride * _stripes; ++i)
+	{
+		_slots[i].store(0, std::memory_order_relaxed);
+	}
+}
+
+size_t WindowCounter::_index(int64 bucket) const
+{
+	const int64 buckets = static_cast<int64>(_buckets);
+	return static_cast<size_t>(bucket - Calendar::floorDiv(bucket, buckets) * buckets);
+}
+
+int64 WindowCounter::_width(const Duration & window) const
+{
+	const int64 micros = window.valueAs(Duration::MicroSecond);
+	return std::min<int64>(std::max<int64>((micros + _resolution - 1) / _resolution, 1),
+		static_cast<int64>(_buckets));
+}
+
+} /* namespace ec */
@@ -0,0 +1,102 @@
+﻿/*
+ * windowcounter.h
+ *
+ *  Created on: 2026年10月19日
+ *      Author: havesnag
+ */
+
+#ifndef INCLUDE_EC_WINDOWCOUNTER_H_
+#define INCLUDE_EC_WINDOWCOUNTER_H_
+
+#include "date.h"
+#include <stddef.h>
+#include <atomic>
+#include <memory>
+
+namespace ec
+{
+
+/**
+ * @brief 滑动窗口计数
+ * @details
+ *     时间按resolution切分为桶，桶的边界与Time::zeroSet(Second/Minute)相同(按UTC对齐)，
+ *     最近buckets个桶组成一个环，不同长度的窗口共用同一个环。
+ *     每个桶为一个64位原子变量，高32位为桶的序号，低32位为计数，
+ *     序号不是当前桶时说明是环上一轮的旧数据，增加时直接替换，查询时跳过，不需要清理线程。
+ *     每个线程固定写其中一条分带(stripe)，避免多个线程争用同一缓存行，查询时合并所有分带。
+ */
+class WindowCounter
+{
+public:
+	/**
+	 * @brief 构造
+	 * @param resolution 每个桶的时长
+	 * @param buckets 桶的个数，决定最长的窗口
+	 * @param stripes 分带数，为0时取CPU核数，向上取为2的幂
+	 */
+	WindowCounter(const Duration & resolution = Duration(1, Duration::Second), size_t buckets = 3600, size_t stripes = 0);
+	~WindowCounter();
+
+	/** @brief 每个桶的时长，微秒 */
+	inline int64 resolution() const
+	{
+		return _resolution;
+	}
+
+	/** @brief 桶的个数 */
+	inline size_t bucketCount() const
+	{
+		return _buckets;
+	}
+
+	/** @brief 分带数 */
+	inline size_t stripeCount() const
+	{
+		return _stripes;
+	}
+
+	/** @brief 当前时间增加计数 */
+	void add(int64 count = 1);
+	/** @brief 在微秒时间戳now所在的桶增加计数，早于环上最旧的桶时忽略 */
+	void add(int64 now, int64 count);
+	/** @brief 在时间所在的桶增加计数 */
+	void add(const Time & time, int64 count = 1);
+
+	/**
+	 * @brief 最近一段时间的计数
+	 * @details 窗口按桶计算，包含当前未结束的桶，比如每桶1秒时1分钟的窗口为当前桶及之前的59个桶
+	 */
+	int64 count(const Duration & window) const;
+	/** @brief 截止到微秒时间戳now的最近一段时间的计数 */
+	int64 count(int64 now, const Duration & window) const;
+	/**
+	 * @brief 一次查询多个窗口，只遍历一遍环
+	 * @param out 输出数组，长度不小于size
+	 */
+	void count(int64 now, const Duration * windows, size_t size, int64 * out) const;
+
+	/** @brief 清空 */
+	void clear();
+
+private:
+	WindowCounter(const WindowCounter &);
+	WindowCounter & operator = (const WindowCounter &);
+
+	/** @brief 桶在环上的位置 */
+	size_t _index(int64 bucket) const;
+	/** @brief 窗口包含的桶数，不超过环的长度 */
+	int64 _width(const Duration & window) const;
+
+	int64 _resolution;
+	size_t _buckets;
+	size_t _stripes;
+	/** @brief 每条分带的长度，按缓存行对齐 */
+	size_t _stride;
+	std::unique_ptr<std::atomic<uint64_t>[]> _memory;
+	/** @brief 第一条分带，按缓存行对齐 */
+	std::atomic<uint64_t> * _slots;
+};
+
+} /* namespace ec */
+
+#endif /* INCLUDE_EC_WINDOWCOUNTER_H_ */
@@ -0,0 +1,590 @@
+﻿/*
+ * zone.cpp
+ *
+ *  Created on: 2026年10月19日
+ *      Author: havesnag
+ */
+
+#include "zone.h"
+#include "zonedb.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+using namespace std;
+
+namespace ec
+{
+
+namespace
+{
+
+const Zone::Type utcType = {0, 0, 0, 0};
+const char utcAbbrs[] = "UTC";
+
+inline uint32_t readUInt32(const unsigned char * p)
+{
+	return (static_cast<uint32_t>(p[0]) << 24) | (static_cast<uint32_t>(p[1]) << 16)
+		| (static_cast<uint32_t>(p[2]) << 8) | static_cast<uint32_t>(p[3]);
+}
+
+inline int64 readInt64(const unsigned char * p)
+{
+	return static_cast<int64>((static_cast<uint64_t>(readUInt32(p)) << 32) | readUInt32(p + 4));
+}
+
+/** @brief 在缩写表中查找缩写，不存在时追加 */
+int32_t findAbbr(std::string & abbrs, const std::string & name)
+{
+	std::string key(name);
+	key.push_back('\0');
+	size_t pos = abbrs.find(key);
+	if (std::string::npos == pos)
+	{
+		pos = abbrs.size();
+		abbrs.append(key);
+	}
+	return static_cast<int32_t>(pos);
+}
+
+bool parseRuleName(const char *& p, std::string & name)
+{
+	const char * begin = p;
+	if ('<' == *p)
+	{
+		begin = ++p;
+		while ('\0' != *p && '>' != *p)
+		{
+			++p;
+		}
+		if ('>' != *p)
+		{
+			return false;
+		}
+		name.assign(begin, p++);
+	}
+	else
+	{
+		while ((*p >= 'a' && *p <= 'z') || (*p >= 'A' && *p <= 'Z'))
+		{
+			++p;
+		}
+		name.assign(begin, p);
+	}
+	return !name.empty();
+}
+
+bool parseRuleNumber(const char *& p, int max, int & value)
+{
+	if (*p < '0' || *p > '9')
+	{
+		return false;
+	}
+
+	value = 0;
+	while (*p >= '0' && *p <= '9')
+	{
+		value = value * 10 + (*p++ - '0');
+		if (value > max)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+/** @brief 解析[+-]hh[:mm[:ss]]，返回秒数 */
+bool parseRuleTime(const char *& p, int32_t & seconds)
+{
+	int sign = 1;
+	if ('+' == *p || '-' == *p)
+	{
+		sign = ('-' == *p++) ? -1 : 1;
+	}
+
+	int hour = 0, minute = 0, second = 0;
+	if (!parseRuleNumber(p, 167, hour))
+	{
+		return false;
+	}
+	if (':' == *p && !parseRuleNumber(++p, 59, minute))
+	{
+		return false;
+	}
+	if (':' == *p && !parseRuleNumber(++p, 59, second))
+	{
+		return false;
+	}
+
+	seconds = sign * (hour * 3600 + minute * 60 + second);
+	return true;
+}
+
+bool parseRuleDate(const char *& p, Zone::RuleDate & date)
+{
+	int value = 0;
+	if ('J' == *p)
+	{
+		date.kind = Zone::RuleJulian;
+		if (!parseRuleNumber(++p, 365, value) || value < 1)
+		{
+			return false;
+		}
+		date.day = value;
+	}
+	else if ('M' == *p)
+	{
+		date.kind = Zone::RuleMonthWeekDay;
+		if (!parseRuleNumber(++p, 12, date.month) || date.month < 1 || '.' != *p)
+		{
+			return false;
+		}
+		if (!parseRuleNumber(++p, 5, date.week) || date.week < 1 || '.' != *p)
+		{
+			return false;
+		}
+		if (!parseRuleNumber(++p, 6, date.day))
+		{
+			return false;
+		}
+	}
+	else
+	{
+		date.kind = Zone::RuleZeroBased;
+		if (!parseRuleNumber(p, 365, value))
+		{
+			return false;
+		}
+		date.day = value;
+	}
+
+	date.time = 7200;
+	if ('/' == *p)
+	{
+		return parseRuleTime(++p, date.time);
+	}
+	return true;
+}
+
+/** @brief 规则中的切换日期距离1970-01-01的天数 */
+int64 ruleDays(const Zone::RuleDate & date, int year)
+{
+	const int64 yearStart = Date::daysFromCivil(year, 1, 1);
+	switch (date.kind)
+	{
+	case Zone::RuleJulian:
+		return yearStart + date.day - 1 + ((Date::isLeapYear(year) && date.day >= 60) ? 1 : 0);
+	case Zone::RuleZeroBased:
+		return yearStart + date.day;
+	default:
+		break;
+	}
+
+	const int64 first = Date::daysFromCivil(year, date.month, 1);
+	const int firstWeekDay = Calendar::weekDay(first) % 7;
+	int day = (date.day - firstWeekDay + 7) % 7 + (date.week - 1) * 7;
+	const int monthDays = Date::yearMonthDays(year, date.month);
+	while (day >= monthDays)
+	{
+		day -= 7;
+	}
+	return first + day;
+}
+
+} /* namespace */
+
+const Zone & Zone::utc()
+{
+	static const Zone zone;
+	return zone;
+}
+
+bool Zone::parse(const char * data, size_t size, const char * name, Zone & zone)
+{
+	const unsigned char * p = reinterpret_cast<const unsigned char *>(data);
+	const unsigned char * end = p + size;
+
+	if (size < 44 || 0 != memcmp(p, "TZif", 4))
+	{
+		return false;
+	}
+
+	const char version = static_cast<char>(p[4]);
+	size_t timeSize = 4;
+	if (version >= '2')
+	{
+		// 跳过32位数据块，使用64位数据块
+		const size_t v1Size = 44 + readUInt32(p + 32) * 5 + readUInt32(p + 36) * 6
+			+ readUInt32(p + 40) + readUInt32(p + 28) * 8 + readUInt32(p + 24) + readUInt32(p + 20);
+		if (size < v1Size + 44 || 0 != memcmp(p + v1Size, "TZif", 4))
+		{
+			return false;
+		}
+		p += v1Size;
+		timeSize = 8;
+	}
+
+	const size_t isutCount = readUInt32(p + 20);
+	const size_t isstdCount = readUInt32(p + 24);
+	const size_t leapCount = readUInt32(p + 28);
+	const size_t timeCount = readUInt32(p + 32);
+	const size_t typeCount = readUInt32(p + 36);
+	const size_t charCount = readUInt32(p + 40);
+	p += 44;
+
+	const size_t blockSize = timeCount * (timeSize + 1) + typeCount * 6 + charCount
+		+ leapCount * (timeSize + 4) + isstdCount + isutCount;
+	if (0 == typeCount || typeCount > 256 || static_cast<size_t>(end - p) < blockSize)
+	{
+		return false;
+	}
+
+	std::shared_ptr<Storage> storage(new Storage());
+	storage->name = (NULL != name) ? name : "";
+
+	storage->transitions.resize(timeCount);
+	for (size_t i = 0; i < timeCount; ++i, p += timeSize)
+	{
+		storage->transitions[i] = (8 == timeSize) ? readInt64(p)
+			: static_cast<int64>(static_cast<int32_t>(readUInt32(p)));
+	}
+
+	storage->indices.assign(p, p + timeCount);
+	p += timeCount;
+	for (size_t i = 0; i < timeCount; ++i)
+	{
+		if (storage->indices[i] >= typeCount)
+		{
+			return false;
+		}
+	}
+
+	storage->types.resize(typeCount);
+	for (size_t i = 0; i < typeCount; ++i, p += 6)
+	{
+		Type & type = storage->types[i];
+		type.offset = static_cast<int32_t>(readUInt32(p));
+		type.isDst = p[4] ? 1 : 0;
+		type.reserved = 0;
+		type.abbrIndex = p[5];
+		if (type.abbrIndex >= charCount)
+		{
+			return false;
+		}
+	}
+
+	storage->abbrs.assign(reinterpret_cast<const char *>(p), charCount);
+	storage->abbrs.push_back('\0');
+	p += charCount + leapCount * (timeSize + 4) + isstdCount + isutCount;
+
+	bool hasRule = false;
+	memset(&storage->rule, 0, sizeof(Rule));
+	if (8 == timeSize && p < end && '\n' == *p)
+	{
+		const unsigned char * begin = ++p;
+		while (p < end && '\n' != *p)
+		{
+			++p;
+		}
+		std::string text(begin, p);
+		if (!text.empty())
+		{
+			hasRule = Zone::parseRule(text.c_str(), storage->rule, storage->abbrs);
+		}
+	}
+
+	zone._storage = storage;
+	zone._name = storage->name.c_str();
+	zone._transitions = storage->transitions.empty() ? NULL : &storage->transitions[0];
+	zone._indices = storage->indices.empty() ? NULL : &storage->indices[0];
+	zone._types = &storage->types[0];
+	zone._abbrs = storage->abbrs.c_str();
+	zone._rule = hasRule ? &storage->rule : NULL;
+	zone._transitionCount = static_cast<uint32_t>(timeCount);
+	zone._typeCount = static_cast<uint32_t>(typeCount);
+	return true;
+}
+
+bool Zone::load(const char * path, const char * name, Zone & zone)
+{
+	FILE * file = fopen(path, "rb");
+	if (NULL == file)
+	{
+		return false;
+	}
+
+	std::string data;
+	char buf[4096];
+	size_t size = 0;
+	while ((size = fread(buf, 1, sizeof(buf), file)) > 0)
+	{
+		data.append(buf, size);
+	}
+	fclose(file);
+
+	return Zone::parse(data.data(), data.size(), name, zone);
+}
+
+bool Zone::parseRule(const char * text, Rule & rule, std::string & abbrs)
+{
+	const char * p = text;
+	std::string name;
+	int32_t offset = 0;
+
+	memset(&rule, 0, sizeof(Rule));
+	if (!parseRuleName(p, name) || !parseRuleTime(p, offset))
+	{
+		return false;
+	}
+
+	// POSIX规则中的偏移以西为正
+	rule.stdOffset = -offset;
+	rule.stdAbbrIndex = findAbbr(abbrs, name);
+	if ('\0' == *p)
+	{
+		return true;
+	}
+
+	if (!parseRuleName(p, name))
+	{
+		return false;
+	}
+	rule.hasDst = 1;
+	rule.dstAbbrIndex = findAbbr(abbrs, name);
+	rule.dstOffset = rule.stdOffset + 3600;
+	if ('\0' != *p && ',' != *p)
+	{
+		if (!parseRuleTime(p, offset))
+		{
+			return false;
+		}
+		rule.dstOffset = -offset;
+	}
+
+	if ('\0' == *p)
+	{
+		// 未指定切换日期时按美国规则
+		const RuleDate start = {RuleMonthWeekDay, 3, 2, 0, 7200};
+		const RuleDate end = {RuleMonthWeekDay, 11, 1, 0, 7200};
+		rule.start = start;
+		rule.end = end;
+		return true;
+	}
+
+	return ',' == *p && parseRuleDate(++p, rule.start)
+		&& ',' == *p && parseRuleDate(++p, rule.end)
+		&& '\0' == *p;
+}
+
+Zone::Zone()
+{
+	_name = utcAbbrs;
+	_transitions = NULL;
+	_indices = NULL;
+	_types = &utcType;
+	_abbrs = utcAbbrs;
+	_rule = NULL;
+	_transitionCount = 0;
+	_typeCount = 1;
+}
+
+Zone::Zone(const Zone &other)
+{
+	*this = other;
+}
+
+Zone::~Zone()
+{
+}
+
+Zone & Zone::operator = (const Zone &other)
+{
+	_name = other._name;
+	_transitions = other._transitions;
+	_indices = other._indices;
+	_types = other._types;
+	_abbrs = other._abbrs;
+	_rule = other._rule;
+	_transitionCount = other._transitionCount;
+	_typeCount = other._typeCount;
+	_storage = other._storage;
+	return *this;
+}
+
+Zone::Info Zone::lookup(time_t stamp) const
+{
+	if (0 == _transitionCount || stamp < _transitions[0])
+	{
+		// 第一个跳变之前使用第0个类型
+		return (0 == _transitionCount && NULL != _rule) ? _ruleLookup(stamp) : _info(_types[0]);
+	}
+
+	if (NULL != _rule && stamp >= _transitions[_transitionCount - 1])
+	{
+		return _ruleLookup(stamp);
+	}
+
+	const int64 * it = std::upper_bound(_transitions, _transitions + _transitionCount, static_cast<int64>(stamp));
+	return _info(_types[_indices[it - _transitions - 1]]);
+}
+
+time_t Zone::localToUTC(time_t local, int isDst) const
+{
+	// 偏移只能是某个类型或规则的偏移，逐个验证即可得到所有对应的时刻，不依赖跳变之间的间隔
+	int offsets[258];
+	size_t count = 0;
+	for (uint32_t i = 0; i < _typeCount; ++i)
+	{
+		offsets[count++] = _types[i].offset;
+	}
+	if (NULL != _rule)
+	{
+		offsets[count++] = _rule->stdOffset;
+		offsets[count++] = _rule->hasDst ? _rule->dstOffset : _rule->stdOffset;
+	}
+	std::sort(offsets, offsets + count);
+	count = std::unique(offsets, offsets + count) - offsets;
+
+	// 偏移从大到小，得到的时刻从早到晚
+	bool found = false;
+	bool matched = false;
+	time_t result = 0;
+	for (size_t i = count; i-- > 0; )
+	{
+		const time_t stamp = local - offsets[i];
+		const Info info = lookup(stamp);
+		if (info.offset != offsets[i])
+		{
+			continue;
+		}
+
+		if (!found || (!matched && isDst >= 0 && info.isDst == (isDst > 0)))
+		{
+			matched = (isDst >= 0 && info.isDst == (isDst > 0));
+			result = stamp;
+			found = true;
+		}
+	}
+	if (found)
+	{
+		return result;
+	}
+
+	// 跳过的时间，二分查找跳变时刻：之前的本地时间都早于local，之后的都晚于local
+	time_t low = local - offsets[count - 1];
+	time_t high = local - offsets[0];
+	while (high - low > 1)
+	{
+		const time_t middle = low + (high - low) / 2;
+		if (middle + offset(middle) > local)
+		{
+			high = middle;
+		}
+		else
+		{
+			low = middle;
+		}
+	}
+	return local - offset(high - 1);
+}
+
+Zone::Info Zone::_ruleLookup(time_t stamp) const
+{
+	const Rule & rule = *_rule;
+	Info info;
+	info.offset = rule.stdOffset;
+	info.isDst = false;
+	info.abbr = _abbrs + rule.stdAbbrIndex;
+	if (!rule.hasDst)
+	{
+		return info;
+	}
+
+	int year = 0, month = 0, day = 0;
+	Date::civilFromDays(Calendar::floorDiv(static_cast<int64>(stamp) + rule.stdOffset, 86400), year, month, day);
+
+	const int64 start = ruleDays(rule.start, year) * 86400 + rule.start.time - rule.stdOffset;
+	const int64 end = ruleDays(rule.end, year) * 86400 + rule.end.time - rule.dstOffset;
+	const bool isDst = (start < end) ? (stamp >= start && stamp < end) : !(stamp >= end && stamp < start);
+	if (isDst)
+	{
+		info.offset = rule.dstOffset;
+		info.isDst = true;
+		info.abbr = _abbrs + rule.dstAbbrIndex;
+	}
+	return info;
+}
+
+Zone::Info Zone::_info(const Type & type) const
+{
+	Info info;
+	info.offset = type.offset;
+	info.isDst = (0 != type.isDst);
+	info.abbr = _abbrs + type.abbrIndex;
+	return info;
+}
+
+
+ZoneRegistry & ZoneRegistry::instance()
+{
+	static ZoneRegistry registry;
+	return registry;
+}
+
+ZoneRegistry::ZoneRegistry()
+{
+	const char * dir = getenv("TZDIR");
+	_directory = (NULL != dir && '\0' != *dir) ? dir : "/usr/share/zoneinfo";
+	_db = NULL;
+}
+
+void ZoneRegistry::setDirectory(const std::string & dir)
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	_directory = dir;
+}
+
+std::string ZoneRegistry::directory()
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	return _directory;
+}
+
+void ZoneRegistry::attach(const ZoneDB * db)
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	_db = db;
+}
+
+const Zone * ZoneRegistry::get(const std::string & name)
+{
+	if ("UTC" == name)
+	{
+		return &Zone::utc();
+	}
+
+	if (name.empty() || '/' == name[0] || std::string::npos != name.find(".."))
+	{
+		return NULL;
+	}
+
+	std::lock_guard<std::mutex> lock(_mutex);
+	std::map<std::string, std::unique_ptr<Zone> >::const_iterator it = _zones.find(name);
+	if (_zones.end() != it)
+	{
+		return it->second.get();
+	}
+
+	std::unique_ptr<Zone> zone(new Zone());
+	if ((NULL == _db || !_db->find(name.c_str(), *zone))
+		&& !Zone::load((_directory + "/" + name).c_str(), name.c_str(), *zone))
+	{
+		return NULL;
+	}
+
+	const Zone * result = zone.get();
+	_zones[name] = std::move(zone);
+	return result;
+}
+
+} /* namespace ec */
@@ -0,0 +1,245 @@
+﻿/*
+ * zone.h
+ *
+ *  Created on: 2026年10月19日
+ *      Author: havesnag
+ */
+
+#ifndef INCLUDE_EC_ZONE_H_
+#define INCLUDE_EC_ZONE_H_
+
+#include "date.h"
+#include <stddef.h>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace ec
+{
+
+class ZoneDB;
+
+/**
+ * @brief 时区
+ * @details
+ *     由tzfile(TZif)格式的时区文件加载，包含全部的跳变时间点、本地时间类型和POSIX TZ规则，
+ *     加载后不可修改，多线程共享无需加锁。
+ *     对象本身只保存指向数据的指针，复制代价很小。
+ * @see ZoneRegistry
+ */
+class Zone
+{
+public:
+	/** @brief 本地时间类型 */
+	struct Type
+	{
+		/** @brief 与UTC的偏移秒数，东8区为28800 */
+		int32_t offset;
+		/** @brief 是否为夏令时 */
+		uint8_t isDst;
+		uint8_t reserved;
+		/** @brief 缩写在缩写表中的位置 */
+		uint16_t abbrIndex;
+	};
+
+	/** @brief POSIX TZ规则中的切换日期 */
+	struct RuleDate
+	{
+		/** @brief 类型，见RuleDateKind */
+		int32_t kind;
+		/** @brief 月，[1,12]，仅kind为RuleMonthWeekDay时有效 */
+		int32_t month;
+		/** @brief 第几周，[1,5]，5表示最后一周 */
+		int32_t week;
+		/** @brief kind为RuleMonthWeekDay时为星期[0,6]，否则为一年中的天 */
+		int32_t day;
+		/** @brief 切换时刻，当天本地时间的秒数，可以为负数或超过一天 */
+		int32_t time;
+	};
+
+	/** @brief 切换日期的类型 */
+	enum RuleDateKind
+	{
+		/** @brief Jn，[1,365]，不计2月29日 */
+		RuleJulian = 0,
+		/** @brief n，[0,365]，计2月29日 */
+		RuleZeroBased = 1,
+		/** @brief Mm.w.d，m月第w周的星期d */
+		RuleMonthWeekDay = 2,
+	};
+
+	/**
+	 * @brief POSIX TZ规则，用于最后一个跳变时间点之后的时间
+	 * @details 比如"EST5EDT,M3.2.0,M11.1.0"
+	 */
+	struct Rule
+	{
+		/** @brief 标准时间与UTC的偏移秒数 */
+		int32_t stdOffset;
+		/** @brief 夏令时与UTC的偏移秒数 */
+		int32_t dstOffset;
+		/** @brief 标准时间缩写在缩写表中的位置 */
+		int32_t stdAbbrIndex;
+		/** @brief 夏令时缩写在缩写表中的位置 */
+		int32_t dstAbbrIndex;
+		/** @brief 是否有夏令时 */
+		int32_t hasDst;
+		/** @brief 夏令时开始日期 */
+		RuleDate start;
+		/** @brief 夏令时结束日期 */
+		RuleDate end;
+	};
+
+	/** @brief 某一时刻的本地时间信息 */
+	struct Info
+	{
+		/** @brief 与UTC的偏移秒数，东8区为28800 */
+		int offset;
+		/** @brief 是否为夏令时 */
+		bool isDst;
+		/** @brief 缩写，比如CST */
+		const char * abbr;
+	};
+
+	/** @brief UTC时区 */
+	static const Zone & utc();
+
+	/**
+	 * @brief 从tzfile(TZif)格式的数据解析时区
+	 * @param data 文件内容
+	 * @param size 文件长度
+	 * @param name 时区名称，比如Asia/Shanghai
+	 * @param zone 输出的时区
+	 * @return 格式错误时返回false
+	 */
+	static bool parse(const char * data, size_t size, const char * name, Zone & zone);
+	/** @brief 从tzfile(TZif)格式的文件加载时区 @see parse */
+	static bool load(const char * path, const char * name, Zone & zone);
+	/**
+	 * @brief 解析POSIX TZ规则字符串，比如"CST-8"、"EST5EDT,M3.2.0,M11.1.0"
+	 * @param abbrs 缩写表，规则中的缩写不存在时追加到末尾
+	 */
+	static bool parseRule(const char * text, Rule & rule, std::string & abbrs);
+
+public:
+	/** @brief 构造为UTC时区 */
+	Zone();
+	Zone(const Zone &other);
+	~Zone();
+
+	Zone & operator = (const Zone &other);
+
+	/** @brief 时区名称 */
+	inline const char * name() const
+	{
+		return _name;
+	}
+
+	/** @brief 跳变时间点的个数 */
+	inline size_t transitionCount() const
+	{
+		return _transitionCount;
+	}
+
+	/** @brief 本地时间类型的个数 */
+	inline size_t typeCount() const
+	{
+		return _typeCount;
+	}
+
+	/** @brief 是否有POSIX TZ规则 */
+	inline bool hasRule() const
+	{
+		return NULL != _rule;
+	}
+
+	/** @brief 获取时间戳(秒)对应的本地时间信息 */
+	Info lookup(time_t stamp) const;
+
+	/** @brief 获取时间戳(秒)对应的与UTC的偏移秒数，东8区为28800 */
+	inline int offset(time_t stamp) const
+	{
+		return lookup(stamp).offset;
+	}
+
+	/**
+	 * @brief 将本地日历时间(按UTC计算的秒数)转换为时间戳
+	 * @param local 本地日历时间
+	 * @param isDst 与tm_isdst含义相同，重叠的时间优先取与之一致的时刻，为-1时取较早的时刻
+	 * @details 跳过的时间按切换前的偏移计算，与mktime一致
+	 */
+	time_t localToUTC(time_t local, int isDst = -1) const;
+
+private:
+	friend class ZoneDB;
+
+	struct Storage
+	{
+		std::string name;
+		std::vector<int64> transitions;
+		std::vector<uint8_t> indices;
+		std::vector<Type> types;
+		std::string abbrs;
+		Rule rule;
+	};
+
+	Info _ruleLookup(time_t stamp) const;
+	Info _info(const Type & type) const;
+
+	const char * _name;
+	const int64 * _transitions;
+	const uint8_t * _indices;
+	const Type * _types;
+	const char * _abbrs;
+	const Rule * _rule;
+	uint32_t _transitionCount;
+	uint32_t _typeCount;
+	std::shared_ptr<const Storage> _storage;
+};
+
+/**
+ * @brief 时区注册表
+ * @details
+ *     按名称加载时区，每个时区只加载一次，之后一直驻留，
+ *     返回的指针在进程生命周期内有效，可被多个线程和Date对象共享。
+ *     默认从环境变量TZDIR指定的目录加载，未设置时为/usr/share/zoneinfo。
+ */
+class ZoneRegistry
+{
+public:
+	/** @brief 全局实例 */
+	static ZoneRegistry & instance();
+
+	/** @brief 设置时区文件目录，仅影响之后首次加载的时区 */
+	void setDirectory(const std::string & dir);
+	/** @brief 时区文件目录 */
+	std::string directory();
+
+	/**
+	 * @brief 获取时区
+	 * @param name 时区名称，比如Asia/Shanghai，"UTC"总是可用
+	 * @return 不存在或格式错误时返回NULL
+	 */
+	const Zone * get(const std::string & name);
+
+	/**
+	 * @brief 关联预编译的时区数据库，之后首次加载的时区优先从中查找
+	 * @note db的生命周期必须长于注册表，传入NULL取消关联 @see ZoneDB
+	 */
+	void attach(const ZoneDB * db);
+
+private:
+	ZoneRegistry();
+	ZoneRegistry(const ZoneRegistry &);
+	ZoneRegistry & operator = (const ZoneRegistry &);
+
+	std::mutex _mutex;
+	std::string _directory;
+	const ZoneDB * _db;
+	std::map<std::string, std::unique_ptr<Zone> > _zones;
+};
+
+} /* namespace ec */
+
+#endif /* INCLUDE_EC_ZONE_H_ */
@@ -0,0 +1,483 @@
+﻿/*
+ * zonedb.cpp
+ *
+ *  Created on: 2026年10月19日
+ *      Author: havesnag
+ */
+
+#include "zonedb.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+
+#ifndef PLATFORM_WINDOWS
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif // PLATFORM_WINDOWS
+
+using namespace std;
+
+namespace ec
+{
+
+namespace
+{
+
+const char magic[8] = {'E', 'C', 'Z', 'O', 'N', 'E', 'D', 'B'};
+const uint32_t byteOrderMark = 0x01020304;
+
+/** @brief 文件头，所有偏移都从文件开始计算 */
+struct Header
+{
+	char magic[8];
+	uint32_t version;
+	uint32_t byteOrder;
+	uint32_t zoneCount;
+	uint32_t reserved;
+	uint64_t indexOffset;
+	uint64_t size;
+	char tzVersion[24];
+};
+
+/** @brief 索引项，按名称排序 */
+struct Entry
+{
+	uint64_t nameOffset;
+	uint64_t transitionsOffset;
+	uint64_t indicesOffset;
+	uint64_t typesOffset;
+	uint64_t abbrsOffset;
+	/** @brief 为0时表示没有POSIX TZ规则 */
+	uint64_t ruleOffset;
+	uint32_t transitionCount;
+	uint32_t typeCount;
+};
+
+inline const Header * header(const char * data)
+{
+	return reinterpret_cast<const Header *>(data);
+}
+
+inline const Entry * entries(const char * data)
+{
+	return reinterpret_cast<const Entry *>(data + header(data)->indexOffset);
+}
+
+/** @brief 从offset开始的count个size字节的元素是否在total字节之内，不会溢出 */
+inline bool fits(uint64_t offset, uint64_t count, uint64_t size, uint64_t total)
+{
+	return offset <= total && count <= (total - offset) / size;
+}
+
+/** @brief offset处的字符串是否在total字节之内结束 */
+inline bool terminated(const char * data, uint64_t total, uint64_t offset)
+{
+	return offset < total && NULL != memchr(data + offset, '\0', static_cast<size_t>(total - offset));
+}
+
+/** @brief 规则日期的各字段是否在取值范围内，避免计算切换日期时溢出 */
+inline bool validRuleDate(const Zone::RuleDate & date)
+{
+	switch (date.kind)
+	{
+	case Zone::RuleJulian:
+		return date.day >= 1 && date.day <= 365;
+	case Zone::RuleZeroBased:
+		return date.day >= 0 && date.day <= 365;
+	case Zone::RuleMonthWeekDay:
+		return date.month >= 1 && date.month <= 12 && date.week >= 1 && date.week <= 5
+			&& date.day >= 0 && date.day <= 6;
+	default:
+		return false;
+	}
+}
+
+/** @brief 追加数据并按8字节对齐，返回数据的偏移 */
+uint64_t append(std::string & image, const void * data, size_t size)
+{
+	image.append((8 - image.size() % 8) % 8, '\0');
+	const uint64_t offset = image.size();
+	if (size > 0)
+	{
+		image.append(static_cast<const char *>(data), size);
+	}
+	return offset;
+}
+
+bool readFile(const std::string & path, std::string & data)
+{
+	FILE * file = fopen(path.c_str(), "rb");
+	if (NULL == file)
+	{
+		return false;
+	}
+
+	char buf[4096];
+	size_t size = 0;
+	while ((size = fread(buf, 1, sizeof(buf), file)) > 0)
+	{
+		data.append(buf, size);
+	}
+	fclose(file);
+	return true;
+}
+
+/** @brief 从tzdata.zi或+VERSION中读取tzdata的版本 */
+std::string readTzVersion(const std::string & dir)
+{
+	std::string data;
+	if (readFile(dir + "/tzdata.zi", data) && 0 == data.compare(0, 10, "# version "))
+	{
+		return data.substr(10, data.find('\n') - 10);
+	}
+
+	data.clear();
+	if (readFile(dir + "/+VERSION", data))
+	{
+		return data.substr(0, data.find_first_of("\r\n"));
+	}
+	return std::string();
+}
+
+#ifndef PLATFORM_WINDOWS
+/** @brief 递归列出目录下的所有文件，返回相对路径 */
+void listFiles(const std::string & dir, const std::string & prefix, std::vector<std::string> & names)
+{
+	DIR * handle = opendir((dir + "/" + prefix).c_str());
+	if (NULL == handle)
+	{
+		return;
+	}
+
+	struct dirent * item = NULL;
+	while (NULL != (item = readdir(handle)))
+	{
+		if ('.' == item->d_name[0])
+		{
+			continue;
+		}
+
+		const std::string name = prefix.empty() ? std::string(item->d_name) : prefix + "/" + item->d_name;
+		if ("posix" == name || "right" == name)
+		{
+			continue;
+		}
+
+		struct stat info;
+		if (0 != stat((dir + "/" + name).c_str(), &info))
+		{
+			continue;
+		}
+
+		if (S_ISDIR(info.st_mode))
+		{
+			listFiles(dir, name, names);
+		}
+		else if (S_ISREG(info.st_mode))
+		{
+			names.push_back(name);
+		}
+	}
+	closedir(handle);
+}
+#endif // PLATFORM_WINDOWS
+
+} /* namespace */
+
+bool ZoneDB::compile(const std::string & dir, const std::string & path, size_t * count)
+{
+	std::vector<std::string> names;
+#ifndef PLATFORM_WINDOWS
+	listFiles(dir, "", names);
+#endif // PLATFORM_WINDOWS
+	std::sort(names.begin(), names.end());
+
+	std::string image(sizeof(Header), '\0');
+	std::vector<Entry> index;
+	for (size_t i = 0; i < names.size(); ++i)
+	{
+		// 不是TZif格式的文件(zone.tab等)直接跳过
+		Zone zone;
+		if (!Zone::load((dir + "/" + names[i]).c_str(), names[i].c_str(), zone))
+		{
+			continue;
+		}
+
+		// 缩写表的长度为最后一个被引用的缩写的结尾
+		size_t abbrsSize = 0;
+		for (uint32_t j = 0; j < zone._typeCount; ++j)
+		{
+			abbrsSize = std::max<size_t>(abbrsSize, zone._types[j].abbrIndex);
+		}
+		if (NULL != zone._rule)
+		{
+			abbrsSize = std::max<size_t>(abbrsSize, zone._rule->stdAbbrIndex);
+			abbrsSize = std::max<size_t>(abbrsSize, zone._rule->dstAbbrIndex);
+		}
+		abbrsSize += strlen(zone._abbrs + abbrsSize) + 1;
+
+		Entry entry;
+		memset(&entry, 0, sizeof(Entry));
+		entry.nameOffset = append(image, names[i].c_str(), names[i].size() + 1);
+		entry.transitionsOffset = append(image, zone._transitions, zone._transitionCount * sizeof(int64));
+		entry.indicesOffset = append(image, zone._indices, zone._transitionCount);
+		entry.typesOffset = append(image, zone._types, zone._typeCount * sizeof(Zone::Type));
+		entry.abbrsOffset = append(image, zone._abbrs, abbrsSize);
+		entry.ruleOffset = (NULL != zone._rule) ? append(image, zone._rule, sizeof(Zone::Rule)) : 0;
+		entry.transitionCount = zone._transitionCount;
+		entry.typeCount = zone._typeCount;
+		index.push_back(entry);
+	}
+
+	const uint64_t indexOffset = append(image, index.empty() ? NULL : &index[0], index.size() * sizeof(Entry));
+
+	Header * head = reinterpret_cast<Header *>(&image[0]);
+	memcpy(head->magic, magic, sizeof(magic));
+	head->version = ZoneDB::Version;
+	head->byteOrder = byteOrderMark;
+	head->zoneCount = static_cast<uint32_t>(index.size());
+	head->indexOffset = indexOffset;
+	head->size = image.size();
+	const std::string tzVersion = readTzVersion(dir);
+	strncpy(head->tzVersion, tzVersion.c_str(), sizeof(head->tzVersion) - 1);
+
+	const std::string temp = path + ".tmp";
+	FILE * file = fopen(temp.c_str(), "wb");
+	if (NULL == file)
+	{
+		return false;
+	}
+
+	const bool written = (image.size() == fwrite(image.data(), 1, image.size(), file));
+	if (0 != fclose(file) || !written || 0 != rename(temp.c_str(), path.c_str()))
+	{
+		remove(temp.c_str());
+		return false;
+	}
+
+	if (NULL != count)
+	{
+		*count = index.size();
+	}
+	return !index.empty();
+}
+
+ZoneDB::ZoneDB()
+{
+	_data = NULL;
+	_size = 0;
+	_mapped = false;
+}
+
+ZoneDB::~ZoneDB()
+{
+	close();
+}
+
+bool ZoneDB::open(const char * path)
+{
+	close();
+
+#ifdef PLATFORM_WINDOWS
+	std::string data;
+	if (!readFile(path, data) || data.empty())
+	{
+		return false;
+	}
+	char * buf = static_cast<char *>(malloc(data.size()));
+	memcpy(buf, data.data(), data.size());
+	_data = buf;
+	_size = data.size();
+	_mapped = false;
+#else
+	const int fd = ::open(path, O_RDONLY);
+	if (fd < 0)
+	{
+		return false;
+	}
+
+	struct stat info;
+	void * addr = MAP_FAILED;
+	if (0 == fstat(fd, &info) && info.st_size > 0)
+	{
+		addr = mmap(NULL, static_cast<size_t>(info.st_size), PROT_READ, MAP_SHARED, fd, 0);
+	}
+	::close(fd);
+
+	if (MAP_FAILED == addr)
+	{
+		return false;
+	}
+	_data = static_cast<const char *>(addr);
+	_size = static_cast<size_t>(info.st_size);
+	_mapped = true;
+#endif // PLATFORM_WINDOWS
+
+	if (!_validate())
+	{
+		close();
+		return false;
+	}
+	return true;
+}
+
+void ZoneDB::close()
+{
+	if (NULL == _data)
+	{
+		return;
+	}
+
+#ifndef PLATFORM_WINDOWS
+	if (_mapped)
+	{
+		munmap(const_cast<char *>(_data), _size);
+	}
+	else
+#endif // PLATFORM_WINDOWS
+	{
+		free(const_cast<char *>(_data));
+	}
+
+	_data = NULL;
+	_size = 0;
+	_mapped = false;
+}
+
+size_t ZoneDB::size() const
+{
+	return isOpen() ? header(_data)->zoneCount : 0;
+}
+
+const char * ZoneDB::name(size_t index) const
+{
+	return (index < size()) ? _data + entries(_data)[index].nameOffset : NULL;
+}
+
+const char * ZoneDB::tzVersion() const
+{
+	return isOpen() ? header(_data)->tzVersion : "";
+}
+
+bool ZoneDB::find(const char * name, Zone & zone) const
+{
+	const Entry * items = isOpen() ? entries(_data) : NULL;
+	size_t low = 0;
+	size_t high = size();
+	while (low < high)
+	{
+		const size_t middle = low + (high - low) / 2;
+		const int result = strcmp(_data + items[middle].nameOffset, name);
+		if (0 == result)
+		{
+			return at(middle, zone);
+		}
+
+		if (result < 0)
+		{
+			low = middle + 1;
+		}
+		else
+		{
+			high = middle;
+		}
+	}
+	return false;
+}
+
+bool ZoneDB::at(size_t index, Zone & zone) const
+{
+	if (index >= size())
+	{
+		return false;
+	}
+
+	const Entry & entry = entries(_data)[index];
+	zone._storage.reset();
+	zone._name = _data + entry.nameOffset;
+	zone._transitions = reinterpret_cast<const int64 *>(_data + entry.transitionsOffset);
+	zone._indices = reinterpret_cast<const uint8_t *>(_data + entry.indicesOffset);
+	zone._types = reinterpret_cast<const Zone::Type *>(_data + entry.typesOffset);
+	zone._abbrs = _data + entry.abbrsOffset;
+	zone._rule = (0 != entry.ruleOffset) ? reinterpret_cast<const Zone::Rule *>(_data + entry.ruleOffset) : NULL;
+	zone._transitionCount = entry.transitionCount;
+	zone._typeCount = entry.typeCount;
+	return true;
+}
+
+bool ZoneDB::_validate() const
+{
+	if (_size < sizeof(Header))
+	{
+		return false;
+	}
+
+	const Header * head = header(_data);
+	if (0 != memcmp(head->magic, magic, sizeof(magic)) || ZoneDB::Version != head->version
+		|| byteOrderMark != head->byteOrder || _size != head->size
+		|| '\0' != head->tzVersion[sizeof(head->tzVersion) - 1])
+	{
+		return false;
+	}
+
+	if (head->indexOffset % 8 != 0 || head->indexOffset > _size
+		|| (_size - head->indexOffset) / sizeof(Entry) < head->zoneCount)
+	{
+		return false;
+	}
+
+	// 检查各段的边界、每个类型和规则的缩写、每个跳变的类型序号，不读取跳变时间
+	const Entry * items = entries(_data);
+	for (uint32_t i = 0; i < head->zoneCount; ++i)
+	{
+		const Entry & entry = items[i];
+		if (0 == entry.typeCount || entry.typeCount > 256
+			|| !terminated(_data, _size, entry.nameOffset)
+			|| entry.transitionsOffset % 8 != 0 || entry.typesOffset % 8 != 0 || entry.ruleOffset % 8 != 0
+			|| !fits(entry.transitionsOffset, entry.transitionCount, sizeof(int64), _size)
+			|| !fits(entry.indicesOffset, entry.transitionCount, 1, _size)
+			|| !fits(entry.typesOffset, entry.typeCount, sizeof(Zone::Type), _size)
+			|| !fits(entry.ruleOffset, 1, sizeof(Zone::Rule), _size)
+			|| entry.abbrsOffset >= _size)
+		{
+			return false;
+		}
+
+		const Zone::Type * types = reinterpret_cast<const Zone::Type *>(_data + entry.typesOffset);
+		for (uint32_t t = 0; t < entry.typeCount; ++t)
+		{
+			if (!terminated(_data, _size, entry.abbrsOffset + types[t].abbrIndex))
+			{
+				return false;
+			}
+		}
+
+		const uint8_t * indices = reinterpret_cast<const uint8_t *>(_data + entry.indicesOffset);
+		for (uint32_t n = 0; n < entry.transitionCount; ++n)
+		{
+			if (indices[n] >= entry.typeCount)
+			{
+				return false;
+			}
+		}
+
+		if (0 != entry.ruleOffset)
+		{
+			const Zone::Rule * rule = reinterpret_cast<const Zone::Rule *>(_data + entry.ruleOffset);
+			if (rule->stdAbbrIndex < 0 || rule->dstAbbrIndex < 0
+				|| !terminated(_data, _size, entry.abbrsOffset + static_cast<uint64_t>(rule->stdAbbrIndex))
+				|| !terminated(_data, _size, entry.abbrsOffset + static_cast<uint64_t>(rule->dstAbbrIndex))
+				|| (0 != rule->hasDst && (!validRuleDate(rule->start) || !validRuleDate(rule->end))))
+			{
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+} /* namespace ec */
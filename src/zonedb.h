@@ -0,0 +1,85 @@
+﻿/*
+ * zonedb.h
+ *
+ *  Created on: 2026年10月19日
+ *      Author: havesnag
+ */
+
+#ifndef INCLUDE_EC_ZONEDB_H_
+#define INCLUDE_EC_ZONEDB_H_
+
+#include "zone.h"
+
+namespace ec
+{
+
+/**
+ * @brief 预编译的时区数据库
+ * @details
+ *     将整个zoneinfo目录编译为一个二进制文件，包含所有时区的跳变时间点、本地时间类型、
+ *     缩写、POSIX TZ规则和按名称排序的索引。
+ *     文件以只读方式映射(mmap)到内存，多个进程共享同一份物理内存，
+ *     打开后查找时区不需要解析，也不分配内存。
+ *     文件按本机字节序存储，字节序或版本不一致时打开失败。
+ * @see ZoneRegistry::attach
+ */
+class ZoneDB
+{
+public:
+	/** @brief 文件格式版本 */
+	static const uint32_t Version = 1;
+
+	/**
+	 * @brief 编译zoneinfo目录
+	 * @param dir zoneinfo目录，比如/usr/share/zoneinfo，跳过其中的posix和right子目录
+	 * @param path 输出文件，先写入临时文件再改名，不影响已映射旧文件的进程
+	 * @param count 如果不为NULL，输出编译的时区个数
+	 * @return 目录不存在或写入失败时返回false
+	 */
+	static bool compile(const std::string & dir, const std::string & path, size_t * count = NULL);
+
+public:
+	ZoneDB();
+	~ZoneDB();
+
+	/** @brief 映射数据库文件，已打开时先关闭；各段越界、缩写未结束、类型序号越界或规则非法时失败 */
+	bool open(const char * path);
+	/** @brief 解除映射 */
+	void close();
+
+	/** @brief 是否已打开 */
+	inline bool isOpen() const
+	{
+		return NULL != _data;
+	}
+
+	/** @brief 时区个数 */
+	size_t size() const;
+	/** @brief 第index个时区的名称，按名称排序 */
+	const char * name(size_t index) const;
+	/** @brief tzdata的版本，比如2025b，未知时为空字符串 */
+	const char * tzVersion() const;
+
+	/**
+	 * @brief 按名称查找时区
+	 * @param zone 输出的时区，数据直接指向映射的内存，ZoneDB关闭后失效
+	 * @return 不存在时返回false
+	 */
+	bool find(const char * name, Zone & zone) const;
+	/** @brief 获取第index个时区 @see find */
+	bool at(size_t index, Zone & zone) const;
+
+private:
+	ZoneDB(const ZoneDB &);
+	ZoneDB & operator = (const ZoneDB &);
+
+	bool _validate() const;
+
+	const char * _data;
+	size_t _size;
+	bool _mapped;
+};
+
+} /* namespace ec */
+
+#endif /* INCLUDE_EC_ZONEDB_H_ */
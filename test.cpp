@@ -6,11 +6,315 @@
  */
 
 #include <iostream>
+#include <stdlib.h>
+#include <vector>
 using namespace std;
 
 #include "src/date.h"
+#include "src/bulk.h"
+#include "src/timeparser.h"
+#include "src/codec.h"
+#include "src/zone.h"
+#include "src/batch.h"
 using namespace ec;
 
+/** @brief 设置系统时区 */
+static void setZone(const char * tz)
+{
+#ifdef PLATFORM_WINDOWS
+	_putenv_s("TZ", tz);
+	_tzset();
+#else
+	setenv("TZ", tz, 1);
+	tzset();
+#endif // PLATFORM_WINDOWS
+	Date::resetZoneCache();
+}
+
+/** @brief 在系统时区tz下比较Bulk与Date::format的结果，返回不一致的个数 */
+static int checkBulk(const char * tz)
+{
+	setZone(tz);
+
+	// 每隔约一天半取一个时刻，覆盖夏令时的切换
+	vector<int64> stamps;
+	for (int64 stamp = 1672531200; stamp < 1735689600; stamp += 129631)
+	{
+		stamps.push_back(stamp * 1000000);
+	}
+
+	string formatted;
+	Bulk::format(stamps.data(), stamps.size(), formatted);
+	vector<int64> parsed;
+	Bulk::parse(formatted.data(), formatted.size(), parsed);
+
+	int errors = 0;
+	size_t begin = 0;
+	for (size_t i = 0; i < stamps.size(); ++i)
+	{
+		const size_t end = formatted.find('\n', begin);
+		const Date date(static_cast<time_t>(stamps[i] / 1000000));
+		if (formatted.compare(begin, end - begin, date.format("%Y-%m-%d %H:%M:%S")) != 0 || parsed[i] != stamps[i])
+		{
+			++errors;
+		}
+		begin = end + 1;
+	}
+	cout << "bulk " << tz << " errors = " << errors << endl;
+	return errors;
+}
+
+/** @brief 同一个TimeParser交替解析不同格式的输入，返回错误的个数 */
+static int checkTimeParser()
+{
+	struct Case
+	{
+		const char * text;
+		int64 micro;
+	} cases[] =
+	{
+		{"1714521600", 1714521600000000LL},
+		{"6 Nov 1994 08:49:37 +0000", 784111777000000LL},
+		{"1714521600123", 1714521600123000LL},
+		{"12 Nov 1994 08:49:37 +0000", 784630177000000LL},
+		{"Sun, 06 Nov 1994 08:49:37 GMT", 784111777000000LL},
+		{"784111777 INFO started", 784111777000000LL},
+		{"1994-11-06T08:49:37Z", 784111777000000LL},
+		{"Sun Nov  6 08:49:37 1994", 784111777000000LL},
+		{"2024-05-01T08:00:00.250+08:00", 1714521600250000LL},
+	};
+
+	TimeParser parser;
+	int errors = 0;
+	for (int round = 0; round < 2; ++round)
+	{
+		for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); ++i)
+		{
+			if (parser.parse(cases[i].text) != cases[i].micro)
+			{
+				++errors;
+			}
+		}
+	}
+	cout << "timeparser errors = " << errors << endl;
+	return errors;
+}
+
+/** @brief 在非UTC的系统时区下编码再解码Date，返回错误的个数 */
+static int checkCodecDate()
+{
+	setZone("America/New_York");
+	const Zone * tokyo = ZoneRegistry::instance().get("Asia/Tokyo");
+	const Date utc(static_cast<time_t>(1000000), true);
+	const Date local(static_cast<time_t>(1690000000));
+	const Date dates[] = {utc, local};
+
+	std::string buffer;
+	Encoder encoder(buffer);
+	encoder.putDate(utc).putDate(local);
+	if (NULL != tokyo)
+	{
+		encoder.putDate(Date(1700000000, *tokyo));
+	}
+
+	int errors = 0;
+	Decoder decoder(buffer);
+	for (size_t i = 0; i < 2; ++i)
+	{
+		Date date(0);
+		if (!decoder.getDate(date) || date.isUTC() != dates[i].isUTC() || date.toString() != dates[i].toString())
+		{
+			++errors;
+		}
+	}
+
+	// 时区不保存，解码为同一时刻的本地日历时间
+	Date zoned(0);
+	if (NULL != tokyo && (!decoder.getDate(zoned) || zoned.stamp() != 1700000000 || NULL != zoned.zone()))
+	{
+		++errors;
+	}
+	cout << "codec date errors = " << errors << endl;
+	return errors;
+}
+
+/** @brief Bulk带ISO周日期说明符的格式化和解析，返回错误的个数 */
+static int checkBulkIso()
+{
+	setZone("UTC");
+	const char * formats[] = {"%Y-%m-%d %u", "%G-W%V-%u %H:%M:%S", "%Y-%m-%dT%H:%M:%S %G %V", "%G %V"};
+	vector<int64> stamps;
+	for (int64 day = -798; day < 20000; day += 7)
+	{
+		stamps.push_back(day * 86400 * 1000000);
+	}
+
+	int errors = 0;
+	for (size_t f = 0; f < sizeof(formats) / sizeof(formats[0]); ++f)
+	{
+		string formatted;
+		vector<int64> parsed;
+		Bulk::format(stamps.data(), stamps.size(), formatted, formats[f]);
+		Bulk::parse(formatted.data(), formatted.size(), parsed, formats[f]);
+		// 只有%G %V时为该周的星期一，时间戳都是星期四
+		const int64 shift = (3 == f) ? 3 * 86400 * 1000000LL : 0;
+		for (size_t i = 0; i < stamps.size(); ++i)
+		{
+			errors += (parsed[i] + shift != stamps[i]) ? 1 : 0;
+		}
+	}
+
+	// %u与年月日不一致时失败
+	const char text[] = "2026-10-19 1\n2026-10-19 2\n";
+	vector<int64> parsed;
+	Bulk::parse(text, sizeof(text) - 1, parsed, "%Y-%m-%d %u");
+	errors += (parsed.size() != 2 || parsed[0] != Calendar::stamp(2026, 10, 19) * 1000000 || parsed[1] != Bulk::Invalid) ? 1 : 0;
+	cout << "bulk iso errors = " << errors << endl;
+	return errors;
+}
+
+/** @brief 写入大端32位整数 */
+static void putUInt32(string & data, uint32_t value)
+{
+	for (int shift = 24; shift >= 0; shift -= 8)
+	{
+		data.push_back(static_cast<char>((value >> shift) & 0xFF));
+	}
+}
+
+/** @brief 检查zone在[begin, end)内每step秒的本地时间都能由localToUTC还原，返回错误的个数 */
+static int checkLocalToUTC(const Zone & zone, time_t begin, time_t end, time_t step)
+{
+	int errors = 0;
+	for (time_t stamp = begin; stamp < end; stamp += step)
+	{
+		const Zone::Info info = zone.lookup(stamp);
+		const time_t local = stamp + info.offset;
+		const time_t earlier = zone.localToUTC(local);
+		const time_t same = zone.localToUTC(local, info.isDst ? 1 : 0);
+		const Zone::Info sameInfo = zone.lookup(same);
+		// 重叠时取较早的时刻，指定夏令时标志时取标志一致的时刻
+		errors += (earlier > stamp || earlier + zone.offset(earlier) != local
+			|| same + sameInfo.offset != local || sameInfo.isDst != info.isDst) ? 1 : 0;
+	}
+	return errors;
+}
+
+/** @brief Zone::localToUTC对照lookup，包括间隔不到一天的跳变，返回错误的个数 */
+static int checkZoneLocal()
+{
+	// 每6小时切换一次的双重夏令时：GMT -> BST -> BDST -> BST -> GMT
+	string data("TZif", 4);
+	data.append(16, '\0');
+	const uint32_t counts[] = {0, 0, 0, 4, 3, 13};
+	for (size_t i = 0; i < 6; ++i)
+	{
+		putUInt32(data, counts[i]);
+	}
+	const time_t start = 1000000000;
+	for (int i = 0; i < 4; ++i)
+	{
+		putUInt32(data, static_cast<uint32_t>(start + i * 21600));
+	}
+	data.append("\1\2\1\0", 4);
+	const int offsets[] = {0, 3600, 7200};
+	for (int i = 0; i < 3; ++i)
+	{
+		putUInt32(data, static_cast<uint32_t>(offsets[i]));
+		data.push_back(0 == i ? 0 : 1);
+		data.push_back(static_cast<char>(i * 4));
+	}
+	data.append("GMT\0BST\0BDST\0", 13);
+
+	int errors = 0;
+	Zone zone;
+	if (!Zone::parse(data.data(), data.size(), "Test/Double", zone))
+	{
+		++errors;
+	}
+	errors += checkLocalToUTC(zone, start - 86400, start + 2 * 86400, 300);
+	// 跳过的时间按切换前的偏移计算
+	errors += (zone.localToUTC(start + 21600 + 3600 + 1800) != start + 21600 + 1800) ? 1 : 0;
+
+	const Zone * london = ZoneRegistry::instance().get("Europe/London");
+	if (NULL != london)
+	{
+		// 1941至1947年有双重夏令时
+		errors += checkLocalToUTC(*london, -915148800, -725846400, 1800);
+		// 按时区构造的时间与当前时刻无关，1944-04-02 02:30不存在，按切换前的偏移(+1)计算
+		const Date skipped(*london, 1944, 4, 2, 2, 30);
+		errors += (skipped.stamp() != Calendar::stamp(1944, 4, 2, 1, 30)) ? 1 : 0;
+	}
+	cout << "zone local errors = " << errors << endl;
+	return errors;
+}
+
+/** @brief Batch::diff对照Time::diff和按周期边界向下取整的结果，返回不一致的个数 */
+static int checkBatchDiff()
+{
+	const Duration::Period periods[] = {Duration::MilliSecond, Duration::Second, Duration::Minute,
+		Duration::Hour, Duration::Day, Duration::Week};
+	const int64 units[] = {1000, 1000000, 60000000LL, 3600000000LL, 86400000000LL, 604800000000LL};
+	const int64 offset = Date::localTimeZoneOffset();
+
+	vector<int64> a;
+	vector<int64> b;
+	for (int64 i = -3000; i < 3000; ++i)
+	{
+		a.push_back(i * 997 * 1000003);
+		b.push_back(-i * 1009 * 999983 + 30000000);
+	}
+	// 1970年之前Time::diff按截断计算，a为30秒、b为-30秒时Minute的差值为0，Batch::diff为1
+	a.push_back(30000000);
+	b.push_back(-30000000);
+
+	int errors = 0;
+	vector<int64> out(a.size());
+	for (size_t p = 0; p < sizeof(periods) / sizeof(periods[0]); ++p)
+	{
+		Batch::diff(a.data(), b.data(), a.size(), periods[p], out.data());
+		// 天和周的边界按本地日历，1970-01-01为星期四，周的边界提前3天
+		const int64 shift = (Duration::Day == periods[p]) ? offset * 1000000
+			: ((Duration::Week == periods[p]) ? (offset - 3 * 86400) * 1000000 : 0);
+		for (size_t i = 0; i < a.size(); ++i)
+		{
+			const int64 expected = Calendar::floorDiv(a[i] - shift, units[p]) - Calendar::floorDiv(b[i] - shift, units[p]);
+			Time ta(0);
+			Time tb(0);
+			ta.setMicroStamp(a[i]);
+			tb.setMicroStamp(b[i]);
+			// 两个时刻都不早于1970年(本地日历)时与Time::diff一致
+			const bool after1970 = (a[i] - offset * 1000000 >= 0 && b[i] - offset * 1000000 >= 0);
+			errors += (out[i] != expected || (after1970 && out[i] != ta.diff(tb, periods[p]))) ? 1 : 0;
+		}
+		if (Duration::Minute == periods[p])
+		{
+			Time ta(30);
+			Time tb(-30);
+			errors += (1 != out.back() || 0 != ta.diff(tb, Duration::Minute)) ? 1 : 0;
+		}
+	}
+	cout << "batch diff errors = " << errors << endl;
+	return errors;
+}
+
+/** @brief 切换系统时区后Date::localOffset和Date::localToUTC不使用之前的缓存，返回错误的个数 */
+static int checkZoneCache()
+{
+	const time_t stamp = 1700000000;
+	const int offsets[] = {-18000, 19800, 0};
+	const char * zones[] = {"America/New_York", "Asia/Kolkata", "UTC"};
+	int errors = 0;
+	for (size_t i = 0; i < 3; ++i)
+	{
+		setZone(zones[i]);
+		errors += (Date::localOffset(stamp) != offsets[i]
+			|| Date::localToUTC(stamp + offsets[i]) != stamp) ? 1 : 0;
+	}
+	cout << "zone cache errors = " << errors << endl;
+	return errors;
+}
+
 int main(int argc, char *argv[])
 {
 	Date d(2000, 1, 1);
@@ -19,7 +323,13 @@ int main(int argc, char *argv[])
 	Time t = d.toTime().addHour(1);
 	cout << "t = " << t.toDate().format() << endl;
 
-	return 0;
+	// 夏令时和非整点的时区
+	int errors = checkBulk("America/New_York") + checkBulk("Asia/Kolkata");
+	errors += checkTimeParser();
+	errors += checkCodecDate();
+	errors += checkBulkIso();
+	errors += checkZoneLocal();
+	errors += checkBatchDiff();
+	errors += checkZoneCache();
+	return (0 == errors) ? 0 : 1;
 }
-
-
@@ -0,0 +1,59 @@
+﻿/*
+ * zonedb.cpp
+ *
+ *  Created on: 2026年10月19日
+ *      Author: havesnag
+ *
+ * 将zoneinfo目录编译为预编译的时区数据库
+ *
+ *     zonedb [zoneinfo目录] <输出文件>
+ *     zonedb -l <数据库文件>
+ */
+
+#include <iostream>
+#include <string.h>
+using namespace std;
+
+#include "../src/zonedb.h"
+using namespace ec;
+
+int main(int argc, char *argv[])
+{
+	if (3 == argc && 0 == strcmp(argv[1], "-l"))
+	{
+		ZoneDB db;
+		if (!db.open(argv[2]))
+		{
+			cerr << "can not open " << argv[2] << endl;
+			return 1;
+		}
+
+		cout << "# version " << db.tzVersion() << ", " << db.size() << " zones" << endl;
+		for (size_t i = 0; i < db.size(); ++i)
+		{
+			Zone zone;
+			db.at(i, zone);
+			cout << zone.name() << "\t" << zone.transitionCount() << "\t" << zone.typeCount() << endl;
+		}
+		return 0;
+	}
+
+	if (2 != argc && 3 != argc)
+	{
+		cerr << "usage: " << argv[0] << " [zoneinfo-dir] <output>" << endl;
+		cerr << "       " << argv[0] << " -l <database>" << endl;
+		return 1;
+	}
+
+	const string dir = (3 == argc) ? argv[1] : "/usr/share/zoneinfo";
+	const string path = argv[argc - 1];
+	size_t count = 0;
+	if (!ZoneDB::compile(dir, path, &count))
+	{
+		cerr << "can not compile " << dir << " to " << path << endl;
+		return 1;
+	}
+
+	cout << count << " zones compiled to " << path << endl;
+	return 0;
+}